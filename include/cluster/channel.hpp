@@ -0,0 +1,500 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef CHANNEL_HPP
+#define CHANNEL_HPP
+
+#include <cluster/package.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <stdint.h>
+#include <time.h>
+
+namespace cluster
+{
+
+class Address;
+class CommunicationSocket;
+
+/**
+  * The types of the frames which are sent
+  * over a Channel. A frame with compressed
+  * content uses the upper case letter of its type.
+  * If the content is in the compact Format of
+  * Package, the highest bit of the type is set
+ **/
+enum class ChannelFrame : char
+{
+
+	/**
+	  * A request which needs to be answered
+	  * with the same correlation id
+	 **/
+	request = 'q',
+
+	/**
+	  * The answer to a request
+	 **/
+	answer = 'a',
+
+	/**
+	  * A message which is not answered
+	 **/
+	message = 'm',
+
+	/**
+	  * Tells that a request was rejected because
+	  * the other side is too busy. It carries the
+	  * correlation id of the request and no content
+	 **/
+	busy = 'b',
+
+	/**
+	  * The options which the sender supports,
+	  * e.g. the Compression. It is answered with
+	  * the options which both sides support
+	 **/
+	options = 'o'
+
+}; //end enum ChannelFrame
+
+/**
+  * A Channel is a connection to another member over
+  * which many requests can be sent at once. Every request
+  * carries a correlation id which is also used by the
+  * answer, so answers can come back in any order.
+  * The other side can also send messages which are
+  * not answered over the same connection, e.g. a
+  * Package to send which was created while handling
+  * a request.
+  * A connection becomes a Channel by sending the hello
+  * Package. If the other side does not answer it with
+  * the hello answer, it does not support Channels.
+  * Afterwards the options frame is sent. Big frames are
+  * only compressed once the other side answered that it
+  * supports the Compression. Older versions ignore the
+  * options frame and get uncompressed frames only.
+ **/
+class Channel
+{
+
+public:
+	/**
+	  * The Package which is sent to turn a
+	  * connection into a Channel
+	 **/
+	static const char helloMessage[];
+
+	/**
+	  * The answer to the hello Package if the
+	  * other side supports Channels
+	 **/
+	static const char helloAnswerMessage[];
+
+	/**
+	  * The answer on a plain connection if the
+	  * other side was too busy to handle the request
+	 **/
+	static const char busyMessage[];
+
+	/**
+	  * Creates a Channel using the given CommunicationSocket
+	  * on which the handshake was already done. The
+	  * Channel takes ownership of the socket.
+	  * The messageCallback is called for every message
+	  * the other side sends. The Package it stores in
+	  * send is sent back as message.
+	  * A request fails if it is not answered within
+	  * timeout seconds. If compression is set, the
+	  * Compression is offered to the other side.
+	  * The Channel needs to be closed using close.
+	 **/
+	static std::shared_ptr<Channel> create(CommunicationSocket *socket, std::function<void(const Address &from, const Package &message, Package &send)> messageCallback, unsigned int timeout=10, bool compression=true);
+
+	/**
+	  * Sends the hello Package over the given socket and
+	  * sets whether the other side supports Channels.
+	  * Returns false if the communication failed
+	 **/
+	static bool handshake(CommunicationSocket *socket, bool &supported);
+
+	/**
+	  * Checks whether the given Package is the hello Package
+	 **/
+	static bool isHello(const Package &message);
+
+	/**
+	  * Returns the answer to the hello Package
+	 **/
+	static Package helloAnswer();
+
+	/**
+	  * Checks whether the given answer of a plain
+	  * connection is the busy answer
+	 **/
+	static bool isBusy(const Package &answer);
+
+	/**
+	  * Returns the answer which is sent over a plain
+	  * connection if a request is rejected because
+	  * the queue is full
+	 **/
+	static Package busyAnswer();
+
+	/**
+	  * Returns the content of the options frame
+	  * which offers the Compression
+	 **/
+	static Package compressionOptions();
+
+	/**
+	  * Checks whether the given content of an options
+	  * frame contains the Compression
+	 **/
+	static bool supportsCompression(const Package &options);
+
+	/**
+	  * Creates a frame of the given type with the
+	  * given correlation id and content. If compress
+	  * is set, content which is bigger than the
+	  * Compression threshold is compressed.
+	 **/
+	static Package encode(ChannelFrame type, uint64_t id, const Package &content, bool compress=false);
+
+	/**
+	  * Reads type, correlation id and content of
+	  * the given frame and decompresses the content
+	  * if needed. The content gets the Format it was
+	  * sent in. Returns false if the frame is invalid
+	 **/
+	static bool decode(const Package &frame, ChannelFrame &type, uint64_t &id, Package &content);
+
+	/**
+	  * Reads only type and correlation id of the given
+	  * frame and sets whether its content is compressed
+	  * and in which Format it is. The read position of the
+	  * frame is moved behind the id. Returns false if the
+	  * frame is invalid
+	 **/
+	static bool decodeHeader(const Package &frame, ChannelFrame &type, uint64_t &id, bool &compressed, Package::Format &format);
+
+	/**
+	  * Default destructor. Closes the socket
+	 **/
+	~Channel();
+
+	/**
+	  * Returns the Address of the other side
+	 **/
+	const Address& getAddress() const;
+
+	/**
+	  * Sends the given request and waits for the answer
+	  * which is stored in answer if set. Can be called
+	  * from many threads at once.
+	 **/
+	bool ask(const Package &message, Package *answer);
+
+	/**
+	  * Like ask, but additionally sets whether the
+	  * request was written to the connection. If not,
+	  * the other side can't have received it. busy is
+	  * set if the other side rejected the request
+	  * because it was too busy to handle it. The
+	  * Channel stays open in this case
+	 **/
+	bool ask(const Package &message, Package *answer, bool &sent, bool &busy);
+
+	/**
+	  * Sends the given request without waiting. When the
+	  * answer was stored in answer, or the request failed,
+	  * the callback is called from the message thread of
+	  * the Channel. answer needs to stay valid until then.
+	  * A request which the other side rejected because it
+	  * was too busy fails.
+	 **/
+	void askAsync(const Package &message, Package *answer, std::function<void(bool success)> callback);
+
+	/**
+	  * Like askAsync, but if the request could not be
+	  * written to the connection, notSent is called
+	  * instead of the callback. notSent is called
+	  * from the calling thread before askAsync returns.
+	  * If the other side rejected the request because it
+	  * was too busy, busy is called instead of the callback
+	  * from the message thread of the Channel
+	 **/
+	void askAsync(const Package &message, Package *answer, std::function<void(bool success)> callback, std::function<void()> notSent, std::function<void()> busy);
+
+	/**
+	  * Sends the given message which is not answered
+	 **/
+	bool send(const Package &message);
+
+	/**
+	  * Returns whether the connection is still open
+	 **/
+	bool isOpen() const
+	{
+		return open;
+	}
+
+	/**
+	  * Checks whether the Channel has no open requests
+	  * and was not used since maxIdleTime seconds
+	 **/
+	bool isIdle(unsigned int maxIdleTime);
+
+	/**
+	  * Stops the threads of the Channel and
+	  * fails all open requests
+	 **/
+	void close();
+
+private:
+	/**
+	  * A request which waits for its answer
+	 **/
+	struct Request
+	{
+		/**
+		  * Creates a request. The callbacks are only
+		  * set for asynchronous requests
+		 **/
+		Request(Package *a, std::function<void(bool success)> fn_callback, std::function<void()> fn_busyCallback, time_t t_deadline) :
+			answer(a),
+			done(false),
+			busy(false),
+			callback(fn_callback),
+			busyCallback(fn_busyCallback),
+			deadline(t_deadline)
+		{}
+
+		/**
+		  * Copying a Request is illegal
+		 **/
+		Request(const Request &r) = delete;
+
+		/**
+		  * Copying a Request is illegal
+		 **/
+		Request& operator=(const Request &r) = delete;
+
+		/**
+		  * Where the answer is stored
+		 **/
+		Package *answer;
+
+		/**
+		  * A flag whether the answer was received
+		 **/
+		bool done;
+
+		/**
+		  * A flag whether the other side rejected
+		  * the request because it was too busy
+		 **/
+		bool busy;
+
+		/**
+		  * The callback of an asynchronous request
+		 **/
+		std::function<void(bool success)> callback;
+
+		/**
+		  * Called instead of the callback if the
+		  * asynchronous request was rejected
+		  * because the other side was too busy
+		 **/
+		std::function<void()> busyCallback;
+
+		/**
+		  * The time after which an asynchronous
+		  * request fails
+		 **/
+		time_t deadline;
+
+	}; //end struct Request
+
+	/**
+	  * Creates a Channel. Use create instead.
+	 **/
+	Channel(CommunicationSocket *socket, std::function<void(const Address &from, const Package &message, Package &send)> messageCallback, unsigned int timeout);
+
+	/**
+	  * Copying a Channel is illegal
+	 **/
+	Channel(const Channel &c);
+
+	/**
+	  * Copying a Channel is illegal
+	 **/
+	Channel& operator=(const Channel &c);
+
+	/**
+	  * Sends the given frame
+	 **/
+	bool sendFrame(const Package &frame);
+
+	/**
+	  * Receives the frames and hands them
+	  * to the waiting requests or to the
+	  * message thread
+	 **/
+	void readFunction();
+
+	/**
+	  * Calls the messageCallback for every
+	  * received message and the callbacks of the
+	  * asynchronous requests. The thread keeps
+	  * the Channel alive until it is closed.
+	 **/
+	void messageFunction(std::shared_ptr<Channel> self);
+
+	/**
+	  * Marks the connection as closed and
+	  * fails all open requests
+	 **/
+	void failRequests();
+
+	/**
+	  * Fails the asynchronous requests which were
+	  * not answered in time. m needs to be locked
+	 **/
+	void failExpiredRequests();
+
+	/**
+	  * Calls the callbacks of the asynchronous
+	  * requests which are finished
+	 **/
+	void runCompletions();
+
+private:
+	/**
+	  * The socket of the connection
+	 **/
+	CommunicationSocket *socket;
+
+	/**
+	  * The callback for every received message
+	 **/
+	std::function<void(const Address &from, const Package &message, Package &send)> messageCallback;
+
+	/**
+	  * The time in seconds a request waits
+	  * for its answer
+	 **/
+	unsigned int timeout;
+
+	/**
+	  * A flag whether the connection is open
+	 **/
+	bool open;
+
+	/**
+	  * A flag whether the threads should run
+	 **/
+	bool running;
+
+	/**
+	  * A flag whether the other side accepted
+	  * compressed frames
+	 **/
+	std::atomic<bool> compression;
+
+	/**
+	  * Makes sure that frames are not mixed up
+	  * when they are sent from many threads
+	 **/
+	std::mutex sendMutex;
+
+	/**
+	  * The correlation id of the next request
+	 **/
+	uint64_t nextId;
+
+	/**
+	  * The requests which wait for their answer
+	 **/
+	std::map<uint64_t, Request*> requests;
+
+	/**
+	  * The received messages which still
+	  * need to be handled
+	 **/
+	std::queue<Package> messages;
+
+	/**
+	  * The callbacks of the finished asynchronous
+	  * requests which still need to be called
+	 **/
+	std::queue<std::pair<std::function<void(bool success)>,bool> > completions;
+
+	/**
+	  * The time of the last request
+	 **/
+	time_t lastActivity;
+
+	/**
+	  * Allows parallel access to requests,
+	  * messages, completions and lastActivity
+	 **/
+	std::mutex m;
+
+	/**
+	  * Notifies the waiting requests and
+	  * the message thread
+	 **/
+	std::condition_variable cv;
+
+	/**
+	  * Makes sure that the Channel is closed once
+	 **/
+	std::mutex closeMutex;
+
+	/**
+	  * The thread which receives the frames
+	 **/
+	std::thread *readThread;
+
+	/**
+	  * The thread which handles the messages
+	 **/
+	std::thread *messageThread;
+
+}; //end class Channel
+
+/**
+  * This function is overloaded from the Package class
+  * to retrieve a ChannelFrame from a Package
+ **/
+template <>
+inline bool operator>>(const Package &p, ChannelFrame &t)
+{
+	return p>>reinterpret_cast<char&>(t);
+}
+
+/**
+  * This function is overloaded from the Package class
+  * to insert a ChannelFrame into a Package
+ **/
+template <>
+inline void operator<<(Package &p, const ChannelFrame &t)
+{
+	p<<reinterpret_cast<const char&>(t);
+}
+
+} //end namespace cluster
+
+#endif //CHANNEL_HPP
@@ -9,28 +9,50 @@
 #ifndef CLIENT_HPP
 #define CLIENT_HPP
 
+#include <functional>
+
 namespace cluster
 {
 
 class Package;
 class Address;
 class Protocol;
+class ConnectionPool;
+class CommunicationSocket;
 
 /**
   * This class is responsible for communicating
-  * with other members. The ceonnection to the
-  * remote host is established each time the send
-  * function is called.
+  * with other members. If a ConnectionPool is given,
+  * the connections to the remote host are taken from
+  * it and reused. If the ConnectionPool uses multiplexing,
+  * the messages are sent over its Channel to the remote
+  * host. Otherwise the connection is established
+  * each time the send function is called.
  **/
 class Client
 {
 
 public:
+	/**
+	  * How often a message is sent again if the
+	  * other side was too busy to handle it
+	 **/
+	static const unsigned int busyRetries = 5;
+
+	/**
+	  * The time in milliseconds to wait before the
+	  * message is sent again to a busy member. It is
+	  * doubled for every further attempt
+	 **/
+	static const unsigned int busyBackoff = 10;
+
 	/**
 	  * Constructus a client to communicate
-	  * with the given address using the given protocol
+	  * with the given address using the given protocol.
+	  * The connections are taken from the given
+	  * ConnectionPool if it is set.
 	 **/
-	Client(const Address &address, const Protocol &protocol);
+	Client(const Address &address, const Protocol &protocol, ConnectionPool *pool=nullptr);
 
 	/**
 	  * Copy constructor
@@ -61,10 +83,28 @@ public:
 
 	/**
 	  * Sends the given package and stores
-	  * the answer into out if set.
+	  * the answer into out if set. If the other
+	  * side is too busy, the package is sent
+	  * again after a pause. Returns false if it
+	  * was still too busy after busyRetries retries.
+	  * A package in the compact Format can only be
+	  * sent over a Channel
 	 **/
 	bool send(const Package &message, Package *out=nullptr) const;
 
+	/**
+	  * Sends the given package without waiting for the
+	  * answer. The callback is called as soon as the
+	  * answer was stored into out or sending failed.
+	  * out needs to stay valid until then. Over a Channel
+	  * no thread is needed, otherwise the Package is
+	  * sent by the Executor of the ConnectionPool.
+	  * Without a ConnectionPool the Package is sent
+	  * before sendAsync returns. A busy member is asked
+	  * again like in send.
+	 **/
+	void sendAsync(const Package &message, Package *out, std::function<void(bool success)> callback) const;
+
 	/**
 	  * Returns the target address
 	 **/
@@ -73,6 +113,27 @@ public:
 		return (*address);
 	}
 
+private:
+	/**
+	  * Sends the given package once. busy is set
+	  * if the other side was too busy to handle it
+	 **/
+	bool sendOnce(const Package &message, Package *out, bool &busy) const;
+
+	/**
+	  * Sends the given package asynchronously.
+	  * attempt counts how often the other side
+	  * was too busy to handle it so far
+	 **/
+	void sendAsync(const Package &message, Package *out, std::function<void(bool success)> callback, unsigned int attempt) const;
+
+	/**
+	  * Receives the answer over the given socket
+	  * and stores it into out if set. busy is set
+	  * if it is the busy answer of the other side
+	 **/
+	static bool receive(CommunicationSocket *s, Package *out, bool &busy);
+
 private:
 	/**
 	  * The target address of the client
@@ -85,6 +146,13 @@ private:
 	 **/
 	const Protocol *protocol;
 
+	/**
+	  * The pool which holds the open connections.
+	  * If it is not set, a new connection is
+	  * established for every message
+	 **/
+	ConnectionPool *pool;
+
 }; //end class Client
 
 } //end namespace cluster
@@ -11,6 +11,7 @@
 
 #include <cluster/clusterobjectserialized.hpp>
 #include <cluster/clustercontainerfunctions.hpp>
+#include <iterator>
 #include <vector>
 #include <list>
 #include <mutex>
@@ -227,24 +228,55 @@ protected:
 		containerMutex.unlock();
 	}
 
-private:
 	/**
-	  * Performs the given operation by first sending it to the
-	  * network, waiting for approvement and then performing
-	  * it locally.
+	  * Overrides the function from ClusterObjectSerialized.
+	  * The chunks contain the elements one after the other
+	  * and the position is the index of the first element
 	 **/
-	bool doAndSend(ClusterContainerOperation type, const T &t, const Index &i)
+	virtual bool getRebuildChunk(Package &out, uint64_t &position, std::size_t maxSize) const override
 	{
-		bool success = false;
-		containerMutex.lock();
-		if(send(type, t, i, nullptr))
+		if(position > v.size())position = v.size();
+		auto it = v.cbegin();
+		std::advance(it, (std::size_t)position);
+
+		const std::size_t start = out.getLength();
+		for(; it != v.cend() && out.getLength() - start < maxSize; ++it, ++position)
 		{
-std::cout<<"OK -> ";
-			//Only performing operation after approvement of network
-			success = perform(type, t, i);
+			out<<(*it);
 		}
+		return it == v.cend();
+	}
+
+	/**
+	  * Overrides the function from ClusterObjectSerialized.
+	  * Appends the elements of the given chunk
+	 **/
+	virtual void rebuildChunk(const Package &chunk, bool first, const Address &/*address*/) override
+	{
+		containerMutex.lock();
+		if(first)v.clear();
+		T t;
+		while(chunk>>t)v.push_back(t);
 		containerMutex.unlock();
-		return success;
+	}
+
+private:
+	/**
+	  * Performs the given operation by sending it to the
+	  * network. It is performed locally when it gets its id,
+	  * so it is applied in the same order as on the other
+	  * members. The operations of other threads can be sent
+	  * together with this one.
+	 **/
+	bool doAndSend(ClusterContainerOperation type, const T &t, const Index &i)
+	{
+		Package::FormatScope scope(ClusterObject_getFormat());
+		Package message;
+		message<<type;
+		message<<t;
+		message<<i;
+
+		return sendPackageAndPerform(message, nullptr);
 	}
 
 	/**
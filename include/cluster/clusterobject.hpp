@@ -11,6 +11,9 @@
 
 #include <cluster/package.hpp>
 #include <cluster/answerpackage.hpp>
+#include <functional>
+#include <future>
+#include <memory>
 #include <string>
 
 namespace cluster
@@ -100,6 +103,7 @@ public:
 	template <class A>
 	bool send(const A &a, AnswerPackage *answer)
 	{
+		Package::FormatScope scope(formatFor(a, ClusterObject_getFormat()));
 		Package message;
 		message<<a;
 		return sendPackage(message, answer);
@@ -111,6 +115,7 @@ public:
 	template <class A, class B>
 	bool send(const A &a, const B &b, AnswerPackage *answer)
 	{
+		Package::FormatScope scope(formatFor(b, formatFor(a, ClusterObject_getFormat())));
 		Package message;
 		message<<a;
 		message<<b;
@@ -123,6 +128,7 @@ public:
 	template <class A, class B, class C>
 	bool send(const A &a, const B &b, const C &c, AnswerPackage *answer)
 	{
+		Package::FormatScope scope(formatFor(c, formatFor(b, formatFor(a, ClusterObject_getFormat()))));
 		Package message;
 		message<<a;
 		message<<b;
@@ -137,6 +143,7 @@ public:
 	template <class A>
 	bool ask(const Address &ip, const A &a, Package *answer)
 	{
+		Package::FormatScope scope(formatFor(a, ClusterObject_getFormat()));
 		Package message;
 		message<<a;
 		return askPackage(ip, message, answer);
@@ -149,6 +156,7 @@ public:
 	template <class A, class B>
 	bool ask(const Address &ip, const A &a, const B &b, Package *answer)
 	{
+		Package::FormatScope scope(formatFor(b, formatFor(a, ClusterObject_getFormat())));
 		Package message;
 		message<<a;
 		message<<b;
@@ -162,6 +170,7 @@ public:
 	template <class A, class B, class C>
 	bool ask(const Address &ip, const A &a, const B &b, const C &c, Package *answer)
 	{
+		Package::FormatScope scope(formatFor(c, formatFor(b, formatFor(a, ClusterObject_getFormat()))));
 		Package message;
 		message<<a;
 		message<<b;
@@ -169,6 +178,94 @@ public:
 		return askPackage(ip, message, answer);
 	}
 
+	/**
+	  * Packs the given object in a package and sends it
+	  * without waiting. The returned future tells whether
+	  * sending succeeded. answer needs to stay valid
+	  * until then.
+	 **/
+	template <class A>
+	std::future<bool> sendAsync(const A &a, AnswerPackage *answer)
+	{
+		Package::FormatScope scope(formatFor(a, ClusterObject_getFormat()));
+		Package message;
+		message<<a;
+		return sendPackageFuture(message, answer);
+	}
+
+	/**
+	  * Packs the given objects in a package and sends them
+	  * without waiting
+	 **/
+	template <class A, class B>
+	std::future<bool> sendAsync(const A &a, const B &b, AnswerPackage *answer)
+	{
+		Package::FormatScope scope(formatFor(b, formatFor(a, ClusterObject_getFormat())));
+		Package message;
+		message<<a;
+		message<<b;
+		return sendPackageFuture(message, answer);
+	}
+
+	/**
+	  * Packs the given objects in a package and sends them
+	  * without waiting
+	 **/
+	template <class A, class B, class C>
+	std::future<bool> sendAsync(const A &a, const B &b, const C &c, AnswerPackage *answer)
+	{
+		Package::FormatScope scope(formatFor(c, formatFor(b, formatFor(a, ClusterObject_getFormat()))));
+		Package message;
+		message<<a;
+		message<<b;
+		message<<c;
+		return sendPackageFuture(message, answer);
+	}
+
+	/**
+	  * Packs the given object in a package and sends it
+	  * to the given address only without waiting. The
+	  * returned future tells whether asking succeeded.
+	  * answer needs to stay valid until then.
+	 **/
+	template <class A>
+	std::future<bool> askAsync(const Address &ip, const A &a, Package *answer)
+	{
+		Package::FormatScope scope(formatFor(a, ClusterObject_getFormat()));
+		Package message;
+		message<<a;
+		return askPackageFuture(ip, message, answer);
+	}
+
+	/**
+	  * Packs the given objects in a package and sends them
+	  * to the given address only without waiting
+	 **/
+	template <class A, class B>
+	std::future<bool> askAsync(const Address &ip, const A &a, const B &b, Package *answer)
+	{
+		Package::FormatScope scope(formatFor(b, formatFor(a, ClusterObject_getFormat())));
+		Package message;
+		message<<a;
+		message<<b;
+		return askPackageFuture(ip, message, answer);
+	}
+
+	/**
+	  * Packs the given objects in a package and sends them
+	  * to the given address only without waiting
+	 **/
+	template <class A, class B, class C>
+	std::future<bool> askAsync(const Address &ip, const A &a, const B &b, const C &c, Package *answer)
+	{
+		Package::FormatScope scope(formatFor(c, formatFor(b, formatFor(a, ClusterObject_getFormat()))));
+		Package message;
+		message<<a;
+		message<<b;
+		message<<c;
+		return askPackageFuture(ip, message, answer);
+	}
+
 	/**
 	  * This function should be called by the current
 	  * object to send a message. Then the message
@@ -191,11 +288,66 @@ public:
 		return ClusterObject_ask(ip, addCurrentSignature(a), answer);
 	}
 
+	/**
+	  * Sends the message like sendPackage but without
+	  * waiting. The callback is called as soon as all
+	  * answers are stored in answer, which needs to
+	  * stay valid until then. The callback might be
+	  * called by another thread.
+	 **/
+	virtual void sendPackageAsync(const Package &a, AnswerPackage *answer, std::function<void(bool success)> callback)
+	{
+		ClusterObject_sendAsync(addCurrentSignature(a), answer, callback);
+	}
+
+	/**
+	  * Asks the member like askPackage but without
+	  * waiting. The callback is called as soon as the
+	  * answer is stored in answer, which needs to
+	  * stay valid until then. The callback might be
+	  * called by another thread.
+	 **/
+	virtual void askPackageAsync(const Address &ip, const Package &a, Package *answer, std::function<void(bool success)> callback)
+	{
+		ClusterObject_askAsync(ip, addCurrentSignature(a), answer, callback);
+	}
+
+	/**
+	  * Sends the message using sendPackageAsync and
+	  * returns a future which tells whether sending
+	  * succeeded
+	 **/
+	std::future<bool> sendPackageFuture(const Package &a, AnswerPackage *answer)
+	{
+		std::shared_ptr<std::promise<bool> > promise(new std::promise<bool>());
+		sendPackageAsync(a, answer, [promise](bool success){ promise->set_value(success); });
+		return promise->get_future();
+	}
+
+	/**
+	  * Asks the member using askPackageAsync and
+	  * returns a future which tells whether asking
+	  * succeeded
+	 **/
+	std::future<bool> askPackageFuture(const Address &ip, const Package &a, Package *answer)
+	{
+		std::shared_ptr<std::promise<bool> > promise(new std::promise<bool>());
+		askPackageAsync(ip, a, answer, [promise](bool success){ promise->set_value(success); });
+		return promise->get_future();
+	}
+
 	/**
 	  * Returns the type of ClusterObject
 	 **/
 	virtual std::string getType() const = 0;
 
+	/**
+	  * Checks whether the given message is intended for
+	  * the current object and not for a child object.
+	  * The read position of the message doesn't change
+	 **/
+	static bool isForCurrent(const Package &message);
+
 protected:
 	/**
 	  * This function is called internally by the network whenever a package
@@ -210,6 +362,26 @@ protected:
 	 **/
 	bool ClusterObject_received(const Address &ip, const Package &message, Package &answer, Package &to_send);
 
+	/**
+	  * Returns the Format of a message to which the given
+	  * object is added. Objects are written in the given
+	  * Format of the network
+	 **/
+	template <class A>
+	static Package::Format formatFor(const A &/*a*/, Package::Format format)
+	{
+		return format;
+	}
+
+	/**
+	  * A Package is added to a message as it is,
+	  * so the message needs to use its Format
+	 **/
+	static Package::Format formatFor(const Package &a, Package::Format /*format*/)
+	{
+		return a.getFormat();
+	}
+
 	/**
 	  * Adds a signature to the package which indicates that
 	  * the package was sent by a child.
@@ -242,6 +414,50 @@ protected:
 		return parent->ClusterObject_ask(ip, addChildSignature(a), answer);
 	}
 
+	/**
+	  * This is the final function which is called to
+	  * send a package without waiting. The top parent
+	  * needs to override this function to actually
+	  * send the message.
+	 **/
+	virtual void ClusterObject_sendAsync(const Package &a, AnswerPackage *answer, std::function<void(bool success)> callback)
+	{
+		parent->ClusterObject_sendAsync(addChildSignature(a), answer, callback);
+	}
+
+	/**
+	  * This is the final function which is called to
+	  * ask a member without waiting. The top parent
+	  * needs to override this function to actually
+	  * ask the member.
+	 **/
+	virtual void ClusterObject_askAsync(const Address &ip, const Package &a, Package *answer, std::function<void(bool success)> callback)
+	{
+		parent->ClusterObject_askAsync(ip, addChildSignature(a), answer, callback);
+	}
+
+	/**
+	  * Checks whether every member reads the batches of
+	  * ClusterObjectSerialized. The top parent needs to
+	  * override this function because it knows the versions
+	  * of the members.
+	 **/
+	virtual bool ClusterObject_readsBatches()
+	{
+		return parent->ClusterObject_readsBatches();
+	}
+
+	/**
+	  * Returns the Format in which the messages of the
+	  * objects are created. The top parent needs to
+	  * override this function because it knows which
+	  * Formats the members read.
+	 **/
+	virtual Package::Format ClusterObject_getFormat()
+	{
+		return parent->ClusterObject_getFormat();
+	}
+
 private:
 	/**
 	  * This is a pointer to the next child object of the network
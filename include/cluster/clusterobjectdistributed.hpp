@@ -267,6 +267,24 @@ protected:
 	 **/
 	virtual bool askPackage(const Address &ip, const Package &a, Package *answer) override;
 
+	/**
+	  * This function sends the given package to the
+	  * network without waiting.
+	 **/
+	virtual void sendPackageAsync(const Package &a, AnswerPackage *answer, std::function<void(bool success)> callback) override;
+
+	/**
+	  * This function sends the given package to the
+	  * network without waiting.
+	 **/
+	virtual void sendPackageUnserializedAsync(const Package &a, AnswerPackage *answer, std::function<void(bool success)> callback) override;
+
+	/**
+	  * This function asks the given member of the
+	  * network without waiting.
+	 **/
+	virtual void askPackageAsync(const Address &ip, const Package &a, Package *answer, std::function<void(bool success)> callback) override;
+
 private:
 	/**
 	  * The amount of nodes where data should
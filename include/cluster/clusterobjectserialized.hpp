@@ -11,12 +11,20 @@
 
 #include <cluster/clusterobject.hpp>
 #include <cluster/prototypes/membercallback.hpp>
-#include <list>
+#include <cluster/replaylog.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace cluster
 {
 
+class WriteAheadLog;
+
 /**
   * This class is responsible for a correct sequence
   * of the packages. This class also handles rebuilds,
@@ -24,29 +32,91 @@ namespace cluster
   * the network or some packages were lost.
   * It is useful to inherit from this class whenever an object
   * needs the packages in correct order and complete.
+  * The Packages are sent by a thread of the object. Packages
+  * which are sent while the previous ones are still on the way
+  * are collected and sent together in one batch with consecutive
+  * ids. Every sender still gets its own answers and its own result.
  **/
 class ClusterObjectSerialized : public ClusterObject, public MemberCallback
 {
 
 public:
+	/**
+	  * The default size in bytes of the
+	  * Packages to remember
+	 **/
+	static const std::size_t defaultMaxBytesToRemember = 16777216;
+
+	/**
+	  * The default amount of Packages after which
+	  * a new snapshot is written to the WriteAheadLog
+	 **/
+	static const unsigned int defaultSnapshotInterval = 1000;
+
+	/**
+	  * The default maximum amount of Packages
+	  * which are sent in one batch
+	 **/
+	static const std::size_t defaultMaxBatchPackages = 256;
+
+	/**
+	  * The default maximum size in bytes of the
+	  * Packages which are sent in one batch
+	 **/
+	static const std::size_t defaultMaxBatchBytes = 262144;
+
 	/**
 	  * The constructor can be called giving the amount
-	  * of packages to remeber. The constructor registers
-	  * a memberCallback of the ClusterObjectSerialized
-	  * to be notified when members join the network
+	  * of packages to remeber and their maximum size in
+	  * bytes. The constructor registers a memberCallback
+	  * of the ClusterObjectSerialized to be notified when
+	  * members join the network
 	 **/
-	ClusterObjectSerialized(ClusterObject *network, unsigned int maxPackagesToRemember=100);
+	ClusterObjectSerialized(ClusterObject *network, unsigned int maxPackagesToRemember=100, std::size_t maxBytesToRemember=defaultMaxBytesToRemember);
 
 	/**
 	  * Default destructor. Removes the member callback.
 	 **/
 	virtual ~ClusterObjectSerialized();
 
+	/**
+	  * Sets the amount of packages to remember
+	  * and their maximum size in bytes
+	 **/
+	void setReplayLimits(unsigned int maxPackagesToRemember, std::size_t maxBytesToRemember);
+
+	/**
+	  * Stores every Package in a WriteAheadLog with the given
+	  * file name and writes a snapshot of the whole object after
+	  * every snapshotInterval Packages. If the files exist, the
+	  * object is restored from them first. When the master is
+	  * online, only the Packages which were missed are fetched
+	  * from it instead of rebuilding everything, as long as it
+	  * still remembers the last restored Package.
+	  * This needs to be called before any Package is sent or
+	  * received. Returns false if the files can't be written
+	 **/
+	bool openWriteAheadLog(const std::string &fileName, unsigned int snapshotInterval=defaultSnapshotInterval);
+
+	/**
+	  * Sets how many Packages and how many bytes are sent in
+	  * one batch at most. If only one Package is allowed, every
+	  * Package is sent on its own like older versions do. This
+	  * also happens as long as a member of an older version is
+	  * online
+	 **/
+	void setBatchLimits(std::size_t maxPackages, std::size_t maxBytes);
+
 	/**
 	  * This function sends the given package to the network.
 	  * It is possible that this function does not send the
 	  * package and returns false because the object is currently
-	  * in the phase of rebuilding.
+	  * in the phase of rebuilding. The package is sent together
+	  * with the packages of other threads which wait to be sent.
+	  * It is not performed locally. An object which applies its
+	  * own packages uses sendPackageAndPerform, so that they are
+	  * performed in the order of their ids and every snapshot of
+	  * the WriteAheadLog contains them.
 	 **/
 	virtual bool sendPackage(const Package &a, AnswerPackage *answer) override;
 
@@ -60,6 +130,34 @@ public:
 	 **/
 	virtual bool askPackage(const Address &ip, const Package &a, Package *answer) override;
 
+	/**
+	  * This function sends the given package to the network
+	  * without waiting. Like sendPackage it fails if the
+	  * object is currently in the phase of rebuilding. The callbacks
+	  * are called in the order of the packages by the thread which
+	  * sends them. They must not wait for other packages of the
+	  * object to be sent because the next batch is sent after them.
+	 **/
+	virtual void sendPackageAsync(const Package &a, AnswerPackage *answer, std::function<void(bool success)> callback) override;
+
+	/**
+	  * This function sends the given package to the
+	  * network without waiting.
+	 **/
+	virtual void sendPackageUnserializedAsync(const Package &a, AnswerPackage *answer, std::function<void(bool success)> callback);
+
+	/**
+	  * Sends the given package using sendPackageUnserializedAsync
+	  * and returns a future which tells whether sending succeeded
+	 **/
+	std::future<bool> sendPackageUnserializedFuture(const Package &a, AnswerPackage *answer);
+
+	/**
+	  * This function asks the given member of the
+	  * network without waiting.
+	 **/
+	virtual void askPackageAsync(const Address &ip, const Package &a, Package *answer, std::function<void(bool success)> callback) override;
+
 	/**
 	  * Packs the given object in a package and sends it unserialized
 	 **/
@@ -96,7 +194,67 @@ public:
 		return sendPackageUnserialized(message, answer);
 	}
 
+	/**
+	  * Packs the given object in a package and sends it
+	  * unserialized without waiting
+	 **/
+	template <class A>
+	std::future<bool> sendUnserializedAsync(const A &a, AnswerPackage *answer)
+	{
+		Package message;
+		message<<a;
+		return sendPackageUnserializedFuture(message, answer);
+	}
+
+	/**
+	  * Packs the given objects in a package and sends them
+	  * unserialized without waiting
+	 **/
+	template <class A, class B>
+	std::future<bool> sendUnserializedAsync(const A &a, const B &b, AnswerPackage *answer)
+	{
+		Package message;
+		message<<a;
+		message<<b;
+		return sendPackageUnserializedFuture(message, answer);
+	}
+
+	/**
+	  * Packs the given objects in a package and sends them
+	  * unserialized without waiting
+	 **/
+	template <class A, class B, class C>
+	std::future<bool> sendUnserializedAsync(const A &a, const B &b, const C &c, AnswerPackage *answer)
+	{
+		Package message;
+		message<<a;
+		message<<b;
+		message<<c;
+		return sendPackageUnserializedFuture(message, answer);
+	}
+
 protected:
+	/**
+	  * Sends the given package like sendPackage, but performs
+	  * it locally as soon as it gets its id. This way the object
+	  * applies its own packages in the same order as the other
+	  * members. A package which got an id is performed even if
+	  * sending fails because the members which missed it
+	  * retrieve it later.
+	 **/
+	bool sendPackageAndPerform(const Package &a, AnswerPackage *answer);
+
+	/**
+	  * Checks whether the Packages are replayed from the
+	  * WriteAheadLog at the moment. The member which sent
+	  * them is not stored, so perform gets no real Address
+	  * and must not keep anything about the sender
+	 **/
+	bool isReplaying() const
+	{
+		return replaying;
+	}
+
 	/**
 	  * A class which inherits from this class needs
 	  * to override this function. This function is called
@@ -121,6 +279,26 @@ protected:
 	 **/
 	virtual void rebuild(const Package &out, const Address &address) = 0;
 
+	/**
+	  * This function is called whenever a member rebuilds
+	  * in chunks. It fills out with the rebuild data which
+	  * starts at the given position until out grew by about
+	  * maxSize bytes and sets position to where the next
+	  * chunk starts. Returns true if this was the last chunk.
+	  * The default implementation uses getRebuildPackage
+	  * and sends everything in one chunk.
+	 **/
+	virtual bool getRebuildChunk(Package &out, uint64_t &position, std::size_t maxSize) const;
+
+	/**
+	  * This function is called for every chunk of the rebuild
+	  * data in the order they were created by getRebuildChunk.
+	  * The structure needs to be cleared before the first chunk
+	  * is applied. The default implementation passes the
+	  * first chunk to rebuild.
+	 **/
+	virtual void rebuildChunk(const Package &chunk, bool first, const Address &address);
+
 	/**
 	  * This function is called whenever a new memeber jois
 	  * the network. It checks whether the new member is the master
@@ -143,6 +321,56 @@ protected:
 	virtual bool received(const Address &ip, const Package &message, Package &answer, Package &to_send) override;
 
 private:
+	/**
+	  * A Package which waits to be sent
+	 **/
+	struct Submission;
+
+	/**
+	  * The Packages which are sent together
+	 **/
+	struct Batch;
+
+	/**
+	  * Adds the given Package to the next batch which the sender
+	  * thread sends. The callback is called when the batch was sent
+	 **/
+	void submit(const Package &a, AnswerPackage *answer, bool perform, std::function<void(bool success)> callback);
+
+	/**
+	  * Waits for Packages and takes the ones of the next
+	  * batch. Returns none if the object is destroyed
+	 **/
+	std::vector<Submission*> nextBatch();
+
+	/**
+	  * This function is executed by the sender thread. It sends
+	  * the batches one after the other and waits for each of
+	  * them, until the object is destroyed
+	 **/
+	void senderFunction();
+
+	/**
+	  * Gives the answers of the given batch to the senders
+	  * of the Packages and calls their callbacks
+	 **/
+	void finishBatch(Batch &batch, bool success);
+
+	/**
+	  * Remembers the given Packages with consecutive ids, performs
+	  * the ones which are performed locally and creates the
+	  * message which is sent to the network.
+	  * Returns false if the object is in the phase of rebuilding
+	 **/
+	bool serialize(const std::vector<Submission*> &submissions, Package &message);
+
+	/**
+	  * Performs the given Package if it has the next id.
+	  * Missed packages are retrieved first. The
+	  * rebuildMutex needs to be locked
+	 **/
+	bool receivedSerialized(const Address &ip, unsigned long long id, const Package &pkg, Package &answer, Package &to_send);
+
 	/**
 	  * This function is called internally for every Package
 	  * which needs to be remembered, either from the network
@@ -150,24 +378,122 @@ private:
 	 **/
 	void packageToRemember(const unsigned long long id, const Package &pkg);
 
+	/**
+	  * Remembers the given Package whose
+	  * Digest is already known
+	 **/
+	void packageToRemember(const unsigned long long id, const Package &pkg, uint32_t digest);
+
+	/**
+	  * Writes the current state to the WriteAheadLog
+	 **/
+	void writeSnapshot();
+
+	/**
+	  * Writes a snapshot if snapshotInterval Packages were
+	  * appended since the last one. rebuildMutex needs to be
+	  * locked, so that every remembered Package is performed
+	 **/
+	void snapshotIfDue();
+
+	/**
+	  * Writes the Packages which were added to the
+	  * WriteAheadLog to the disk. It is called once
+	  * for all Packages which were remembered at once
+	 **/
+	void syncWriteAheadLog();
+
+	/**
+	  * Stops writing the WriteAheadLog because it can't be
+	  * written. The files still contain an older state
+	 **/
+	void closeWriteAheadLog();
+
 	/**
 	  * This function is called internally to rebuild the
 	  * ClusterObjectSerialized an its subobject
 	 **/
 	void rebuildAll(const Package &a, const Address &address);
 
-private:
 	/**
-	  * This list is used to remember the last packages
-	  * which are used for other memebers to rebuild
-	  * a small part of the object
+	  * Rebuilds the ClusterObjectSerialized and its subobject
+	  * from the given member. The data is fetched in chunks if
+	  * the member supports it, otherwise all at once
+	 **/
+	void rebuildFrom(const Address &address);
+
+	/**
+	  * Fetches the rebuild data from the given member chunk by
+	  * chunk and applies it. Returns false if the member doesn't
+	  * support chunks, which sets supported to false, or if its
+	  * data changed in between
+	 **/
+	bool rebuildInChunks(const Address &address, bool &supported);
+
+	/**
+	  * Retrieves the missed packages with the ids in
+	  * [from, to) from the given member at once and
+	  * performs them. The other members confirm them
+	  * with a digest.
+	  * Returns false if a package is missing or the digests
+	  * differ, or if the member doesn't support retrieving
+	  * a range, which sets supported to false
+	 **/
+	bool catchUp(const Address &address, unsigned long long from, unsigned long long to, bool &supported);
+
+	/**
+	  * Retrieves the packages with the ids in [from, to) from
+	  * the given member and performs them until the member
+	  * doesn't remember the next one. Their digests are added
+	  * to digest. Returns the id of the first package which
+	  * was not performed. Sets supported to false if the member
+	  * doesn't support retrieving a range
+	 **/
+	unsigned long long fetchPackages(const Address &address, unsigned long long from, unsigned long long to, uint32_t &digest, bool &supported);
+
+	/**
+	  * Checks with the given member whether the restored object
+	  * ends with the same package and retrieves the packages
+	  * which were missed. Returns false if the object needs to
+	  * be rebuilt from the given member
+	 **/
+	bool continueRestored(const Address &address);
+
+	/**
+	  * Asks all members for every missed package with
+	  * the ids in [from, to) and performs them. This is
+	  * used for older versions. Returns false if a package
+	  * is missing or the members sent different packages
+	 **/
+	bool catchUpOneByOne(unsigned long long from, unsigned long long to);
+
+	/**
+	  * Adds the last remembered Package to the rebuild data
+	 **/
+	void writeRebuildHeader(Package &out) const;
+
+	/**
+	  * Reads the last remembered Package from the rebuild data
+	 **/
+	bool readRebuildHeader(const Package &a);
+
+	/**
+	  * Copying a ClusterObjectSerialized is illegal
+	 **/
+	ClusterObjectSerialized(const ClusterObjectSerialized &c);
+
+	/**
+	  * Copying a ClusterObjectSerialized is illegal
 	 **/
-	std::list<std::pair<unsigned long long,Package> > lastPackages;
+	ClusterObjectSerialized& operator=(const ClusterObjectSerialized &c);
 
+private:
 	/**
-	  * The amount of Packages to remember
+	  * This log is used to remember the last packages
+	  * which are used for other memebers to rebuild
+	  * a small part of the object
 	 **/
-	unsigned int maxPackagesToRemember;
+	ReplayLog lastPackages;
 
 	/**
 	  * This mutex is used to synchronize the build
@@ -181,6 +507,70 @@ private:
 	 **/
 	bool rebuilded;
 
+	/**
+	  * The log to which the Packages are written
+	  * or nullptr if it is not used
+	 **/
+	WriteAheadLog *writeAheadLog;
+
+	/**
+	  * The amount of Packages after which a new
+	  * snapshot is written to the WriteAheadLog
+	 **/
+	unsigned int snapshotInterval;
+
+	/**
+	  * This flag indicates whether the object was
+	  * restored from the WriteAheadLog and was not
+	  * compared with the master yet
+	 **/
+	bool restored;
+
+	/**
+	  * This flag indicates whether the Packages
+	  * are replayed from the WriteAheadLog
+	 **/
+	std::atomic<bool> replaying;
+
+	/**
+	  * This mutex is used to synchronize
+	  * the Packages which wait to be sent
+	 **/
+	std::mutex batchMutex;
+
+	/**
+	  * The Packages which wait to be sent
+	 **/
+	std::deque<Submission*> submissions;
+
+	/**
+	  * The thread which sends the batches. It is
+	  * started when the first Package is sent
+	 **/
+	std::thread *sender;
+
+	/**
+	  * Notifies the sender thread when Packages are
+	  * submitted or when the object is destroyed
+	 **/
+	std::condition_variable submitted;
+
+	/**
+	  * This flag indicates that the object is destroyed
+	  * and that no Packages are sent anymore
+	 **/
+	bool stopping;
+
+	/**
+	  * The maximum amount of Packages in a batch
+	 **/
+	std::size_t maxBatchPackages;
+
+	/**
+	  * The maximum size of the Packages in a batch
+	 **/
+	std::size_t maxBatchBytes;
+
 }; //end class ClusterObjectSerialized
 
 } //end namespace cluster
@@ -0,0 +1,63 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace cluster
+{
+
+/**
+  * The Compression is a fast LZ compressor which is
+  * used to reduce the size of big Packages which are
+  * sent over a Channel. The compressed data uses the
+  * LZ4 block format: sequences of literals followed
+  * by a match which is copied from the already
+  * decompressed data.
+ **/
+class Compression
+{
+
+public:
+	/**
+	  * The name of the codec which is used
+	  * when negotiating the compression
+	 **/
+	static const char name[];
+
+	/**
+	  * Packages smaller than this are not compressed
+	 **/
+	static const std::size_t threshold = 1024;
+
+	/**
+	  * Data can't be compressed by more than this
+	 **/
+	static const std::size_t maxRatio = 255;
+
+	/**
+	  * Compresses length bytes of data into out. Returns
+	  * false if the compressed data is not smaller
+	 **/
+	static bool compress(const char *data, std::size_t length, std::vector<char> &out);
+
+	/**
+	  * Decompresses length bytes of data into out which
+	  * needs room for originalLength bytes. Returns false
+	  * if the data is invalid.
+	 **/
+	static bool decompress(const char *data, std::size_t length, std::size_t originalLength, char *out);
+
+}; //end class Compression
+
+} //end namespace cluster
+
+#endif //COMPRESSION_HPP
@@ -0,0 +1,277 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef CONNECTIONPOOL_HPP
+#define CONNECTIONPOOL_HPP
+
+#include <cluster/prototypes/address.hpp>
+#include <cluster/executor.hpp>
+#include <string>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <time.h>
+
+namespace cluster
+{
+
+class Package;
+class Protocol;
+class CommunicationSocket;
+class Channel;
+
+/**
+  * The ConnectionPool keeps established connections
+  * to other members open so that they can be reused
+  * for the next message instead of connecting again.
+  * Connections which were not used for maxIdleTime
+  * seconds are closed.
+  * If multiplexing is enabled, one Channel is kept
+  * open for every Address over which all requests
+  * to that Address are sent at once.
+  * Blocking work which belongs to the connections
+  * is run by the Executor of the ConnectionPool.
+ **/
+class ConnectionPool
+{
+
+public:
+	/**
+	  * Constructs a ConnectionPool which creates the
+	  * connections using the given Protocol. At most
+	  * maxIdlePerAddress unused connections are kept
+	  * open for every Address
+	 **/
+	ConnectionPool(const Protocol &protocol, unsigned int maxIdleTime=5, unsigned int maxIdlePerAddress=4);
+
+	/**
+	  * Default destructor which waits for the tasks
+	  * of the Executor and closes all connections
+	 **/
+	~ConnectionPool();
+
+	/**
+	  * Returns a connection to the given Address.
+	  * If there is an unused connection it is reused,
+	  * otherwise a new one is established. reused
+	  * is set accordingly. Returns nullptr if no
+	  * connection could be established.
+	 **/
+	CommunicationSocket* get(const Address &address, bool &reused);
+
+	/**
+	  * Gives the connection back to the pool so that
+	  * it can be reused.
+	 **/
+	void put(CommunicationSocket *socket);
+
+	/**
+	  * Returns the Channel to the given Address. If there
+	  * is no open Channel a new one is established and
+	  * reused is set accordingly. Returns nullptr if
+	  * multiplexing is disabled or the other side does not
+	  * support Channels. connected is set to false if no
+	  * connection could be established at all.
+	 **/
+	std::shared_ptr<Channel> getChannel(const Address &address, bool &reused, bool &connected);
+
+	/**
+	  * Closes the given Channel. This should be called
+	  * when a request over the Channel failed
+	 **/
+	void removeChannel(const std::shared_ptr<Channel> &channel);
+
+	/**
+	  * Closes all unused connections to the given Address.
+	  * This should be called when a member goes offline
+	 **/
+	void remove(const Address &address);
+
+	/**
+	  * Closes all connections which were not used
+	  * for maxIdleTime seconds
+	 **/
+	void cleanup();
+
+	/**
+	  * Closes all connections and Channels
+	 **/
+	void clear();
+
+	/**
+	  * Gets whether the requests are sent over Channels
+	 **/
+	bool getMultiplexing() const
+	{
+		return multiplexing;
+	}
+
+	/**
+	  * Sets whether the requests are sent over Channels
+	 **/
+	void setMultiplexing(bool b_multiplexing)
+	{
+		this->multiplexing = b_multiplexing;
+	}
+
+	/**
+	  * Gets whether big Packages are compressed
+	  * on Channels which support it
+	 **/
+	bool getCompression() const
+	{
+		return compression;
+	}
+
+	/**
+	  * Sets whether big Packages are compressed
+	  * on Channels which support it. This affects
+	  * only Channels which are established afterwards
+	 **/
+	void setCompression(bool b_compression)
+	{
+		this->compression = b_compression;
+	}
+
+	/**
+	  * Sets the callback which is called for every
+	  * message which is received over a Channel.
+	  * The Package which is stored in send is sent
+	  * back over the Channel
+	 **/
+	void setMessageCallback(std::function<void(const Address &from, const Package &message, Package &send)> fn_messageCallback)
+	{
+		this->messageCallback = fn_messageCallback;
+	}
+
+	/**
+	  * Gets the time in seconds after which an
+	  * unused connection is closed
+	 **/
+	unsigned int getMaxIdleTime() const
+	{
+		return maxIdleTime;
+	}
+
+	/**
+	  * Sets the time in seconds after which an
+	  * unused connection is closed
+	 **/
+	void setMaxIdleTime(unsigned int ui_maxIdleTime)
+	{
+		this->maxIdleTime = ui_maxIdleTime;
+	}
+
+	/**
+	  * Gets the maximum amount of unused connections
+	  * which are kept open for an Address
+	 **/
+	unsigned int getMaxIdlePerAddress() const
+	{
+		return maxIdlePerAddress;
+	}
+
+	/**
+	  * Sets the maximum amount of unused connections
+	  * which are kept open for an Address
+	 **/
+	void setMaxIdlePerAddress(unsigned int ui_maxIdlePerAddress)
+	{
+		this->maxIdlePerAddress = ui_maxIdlePerAddress;
+	}
+
+	/**
+	  * Returns the Executor which runs blocking work
+	  * such as sending over plain connections
+	 **/
+	Executor& getExecutor()
+	{
+		return executor;
+	}
+
+private:
+	/**
+	  * Copying a ConnectionPool is illegal
+	 **/
+	ConnectionPool(const ConnectionPool &p);
+
+	/**
+	  * Copying a ConnectionPool is illegal
+	 **/
+	ConnectionPool& operator=(const ConnectionPool &p);
+
+private:
+	/**
+	  * The protocol which is used to create
+	  * new connections
+	 **/
+	const Protocol *protocol;
+
+	/**
+	  * The time in seconds after which an
+	  * unused connection is closed
+	 **/
+	unsigned int maxIdleTime;
+
+	/**
+	  * The maximum amount of unused connections
+	  * which are kept open for an Address
+	 **/
+	unsigned int maxIdlePerAddress;
+
+	/**
+	  * The unused connections for every Address
+	  * together with the time they were given back
+	 **/
+	std::unordered_map<AddressKey, std::list<std::pair<CommunicationSocket*,time_t> > > sockets;
+
+	/**
+	  * A flag whether the requests are sent over Channels
+	 **/
+	bool multiplexing;
+
+	/**
+	  * A flag whether big Packages are compressed
+	 **/
+	bool compression;
+
+	/**
+	  * The callback for every message which is
+	  * received over a Channel
+	 **/
+	std::function<void(const Address &from, const Package &message, Package &send)> messageCallback;
+
+	/**
+	  * The open Channel for every Address
+	 **/
+	std::unordered_map<AddressKey, std::shared_ptr<Channel> > channels;
+
+	/**
+	  * The Addresses which don't support Channels
+	  * together with the time it was detected
+	 **/
+	std::unordered_map<AddressKey, time_t> plainAddresses;
+
+	/**
+	  * Allows parallel access to the sockets,
+	  * channels and plainAddresses
+	 **/
+	std::mutex socketsMutex;
+
+	/**
+	  * Runs blocking work on reused threads
+	 **/
+	Executor executor;
+
+}; //end class ConnectionPool
+
+} //end namespace cluster
+
+#endif //CONNECTIONPOOL_HPP
@@ -0,0 +1,49 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef CONNECTSCANNER_HPP
+#define CONNECTSCANNER_HPP
+
+#ifdef __linux__
+
+#include <vector>
+#include <sys/socket.h>
+
+namespace cluster
+{
+
+/**
+  * The ConnectScanner checks which computers accept
+  * connections by starting many non-blocking connects
+  * at once and waiting for them using epoll. This way
+  * an address range can be scanned in about the time
+  * one connect takes. The IPv4 and IPv6 Protocols use
+  * it to probe Addresses.
+  * The ConnectScanner is only available on Linux.
+ **/
+class ConnectScanner
+{
+
+public:
+	/**
+	  * Connects to the given socket addresses and sets
+	  * reachable for every address which accepted the
+	  * connection. Addresses with the family AF_UNSPEC
+	  * are skipped. At most concurrency connects are
+	  * started at once and each one waits at most
+	  * timeout milliseconds
+	 **/
+	static void scan(const std::vector<struct sockaddr_storage> &addresses, std::vector<bool> &reachable, unsigned int concurrency, unsigned int timeout);
+
+}; //end class ConnectScanner
+
+} //end namespace cluster
+
+#endif //__linux__
+
+#endif //CONNECTSCANNER_HPP
@@ -13,6 +13,7 @@
 #include <cluster/database/sqlquery.hpp>
 #include <cluster/database/sqlresult.hpp>
 #include <cluster/database/table.hpp>
+#include <functional>
 #include <vector>
 #include <list>
 #include <mutex>
@@ -152,6 +153,19 @@ protected:
 	 **/
 	virtual void rebuild(const Package &out, const Address &address) override;
 
+	/**
+	  * Overrides the function from ClusterObjectSerialized.
+	  * The chunks contain whole tables and the position
+	  * is the index of the first table
+	 **/
+	virtual bool getRebuildChunk(Package &out, uint64_t &position, std::size_t maxSize) const override;
+
+	/**
+	  * Overrides the function from ClusterObjectSerialized.
+	  * Adds the tables of the given chunk
+	 **/
+	virtual void rebuildChunk(const Package &chunk, bool first, const Address &address) override;
+
 private:
 	/**
 	  * Copying a database is illegal because
@@ -172,6 +186,19 @@ private:
 	 **/
 	void sendToNetwork(const SQLQuery &query, std::mutex *m, SQLResult *result);
 
+	/**
+	  * Adds the results of the given answer to result.
+	  * The mutex is used for synchronized access to the result
+	 **/
+	void addResults(const AnswerPackage &answer, std::mutex *m, SQLResult *result);
+
+	/**
+	  * Sends the given query asynchronously to the network
+	  * and executes the local part meanwhile. The response
+	  * is saved in result after the local part has finished
+	 **/
+	void sendToNetworkWhile(const SQLQuery &query, SQLResult *result, std::function<void()> local);
+
 	/**
 	  * Sends the given query to the given address
 	  * and saves the response in result. The mutex
@@ -51,7 +51,7 @@ public:
 		{
 			success += success / abs(success);
 			const bool wasEmpty = errorMessage.empty();
-			errorMessage += (wasEmpty ? "" : ", ") + address.address + ": " + res.errorMessage;
+			errorMessage += (wasEmpty ? "" : ", ") + address.toString() + ": " + res.errorMessage;
 		}
 
 		for(auto r : res.results)
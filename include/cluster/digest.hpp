@@ -0,0 +1,63 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef DIGEST_HPP
+#define DIGEST_HPP
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace cluster
+{
+
+class Package;
+
+/**
+  * The Digest computes CRC32C (Castagnoli) checksums.
+  * Members compare the digests of Packages instead of
+  * the Packages themselves and use them to check that
+  * data was not corrupted on the way.
+  * The SSE4.2 crc32 instruction is used if the processor
+  * supports it, otherwise a table. Both compute the same
+  * digests, so members with different processors can
+  * compare them.
+ **/
+class Digest
+{
+
+public:
+	/**
+	  * Returns the digest of the given data. The digest
+	  * of data which was split can be computed by passing
+	  * the digest of the previous part as crc
+	 **/
+	static uint32_t compute(const void *data, std::size_t size, uint32_t crc=0);
+
+	/**
+	  * Returns the digest of the content
+	  * of the given Package
+	 **/
+	static uint32_t compute(const Package &p, uint32_t crc=0);
+
+	/**
+	  * Adds the given digest to the given crc. This is used
+	  * to compute the digest of many Packages from their
+	  * digests. The result is the same on all processors
+	 **/
+	static uint32_t combine(uint32_t crc, uint32_t digest);
+
+	/**
+	  * Checks whether the crc32 instruction is used
+	 **/
+	static bool isHardwareSupported();
+
+}; //end class Digest
+
+} //end namespace cluster
+
+#endif //DIGEST_HPP
@@ -0,0 +1,317 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef EVENTLOOP_HPP
+#define EVENTLOOP_HPP
+
+#ifdef __linux__
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <time.h>
+
+namespace cluster
+{
+
+class Address;
+class Package;
+class ListenerSocket;
+class CommunicationSocket;
+class EventLoop;
+
+/**
+  * An EventConnection is a client connection which
+  * is handled by an EventLoop. The incoming data is
+  * read without blocking and split into Packages. The
+  * answers can be sent from any thread and are written
+  * by the EventLoop if they can't be written at once.
+ **/
+class EventConnection
+{
+
+public:
+	/**
+	  * Creates an EventConnection for the given
+	  * non-blocking CommunicationSocket which is
+	  * handled by the given EventLoop
+	 **/
+	EventConnection(CommunicationSocket *socket, EventLoop *loop);
+
+	/**
+	  * Default destructor. Closes the connection
+	 **/
+	~EventConnection();
+
+	/**
+	  * Returns the address of the client
+	 **/
+	const Address& getAddress() const;
+
+	/**
+	  * Sends the given Package to the client.
+	  * This function can be called from any thread
+	 **/
+	void send(const Package &data);
+
+	/**
+	  * Needs to be called when a received Package
+	  * was handled completely
+	 **/
+	void finished();
+
+	/**
+	  * Returns whether the connection is a Channel
+	 **/
+	bool isChannel() const
+	{
+		return channel;
+	}
+
+	/**
+	  * Marks the connection as Channel
+	 **/
+	void setChannel()
+	{
+		channel = true;
+	}
+
+	/**
+	  * A flag whether the other side of the
+	  * Channel accepts compressed frames
+	 **/
+	std::atomic<bool> compression;
+
+private:
+	friend class EventLoop;
+
+	/**
+	  * Copying an EventConnection is illegal
+	 **/
+	EventConnection(const EventConnection &c);
+
+	/**
+	  * Copying an EventConnection is illegal
+	 **/
+	EventConnection& operator=(const EventConnection &c);
+
+	/**
+	  * Reads all available data and calls the
+	  * callback for every complete Package.
+	  * Returns false if the connection was closed
+	 **/
+	bool read(const std::function<void(const Package&)> &callback);
+
+	/**
+	  * Writes the data which could not be written
+	  * when it was sent. Returns false on error
+	 **/
+	bool write();
+
+private:
+	/**
+	  * The socket of the connection
+	 **/
+	CommunicationSocket *socket;
+
+	/**
+	  * The file descriptor of the socket
+	 **/
+	int fd;
+
+	/**
+	  * The EventLoop which handles the connection
+	 **/
+	EventLoop *loop;
+
+	/**
+	  * The received data which is not yet split
+	  * into Packages
+	 **/
+	std::vector<char> in;
+
+	/**
+	  * The read position in the received data
+	 **/
+	std::size_t inPosition;
+
+	/**
+	  * The end of the received data
+	 **/
+	std::size_t inEnd;
+
+	/**
+	  * The data which still needs to be written
+	 **/
+	std::deque<std::vector<char> > out;
+
+	/**
+	  * The write position in the first element of out
+	 **/
+	std::size_t outPosition;
+
+	/**
+	  * Allows parallel access to out
+	 **/
+	std::mutex outMutex;
+
+	/**
+	  * A flag whether the connection was closed
+	 **/
+	bool closed;
+
+	/**
+	  * The time of the last read or write
+	 **/
+	time_t lastActivity;
+
+	/**
+	  * The amount of received Packages which
+	  * were not handled yet
+	 **/
+	std::atomic<unsigned int> pending;
+
+	/**
+	  * A flag whether the connection is a Channel
+	 **/
+	std::atomic<bool> channel;
+
+}; //end class EventConnection
+
+/**
+  * The EventLoop waits for events on many connections
+  * at once using epoll. It reads the requests, passes
+  * complete Packages to the callback and writes the
+  * answers, without blocking on a single connection.
+ **/
+class EventLoop
+{
+
+public:
+	/**
+	  * Creates an EventLoop and starts its thread.
+	  * The callback is called for every complete
+	  * Package. Connections which are idle for
+	  * idleTimeout seconds are closed.
+	 **/
+	EventLoop(std::function<void(const std::shared_ptr<EventConnection> &connection, const Package &data)> callback, const unsigned int &idleTimeout);
+
+	/**
+	  * Default destructor. Stops the thread and
+	  * closes all connections
+	 **/
+	~EventLoop();
+
+	/**
+	  * Adds the given non-blocking CommunicationSocket
+	  * to the EventLoop. The EventLoop takes ownership
+	  * of the socket.
+	 **/
+	void add(CommunicationSocket *socket);
+
+	/**
+	  * Lets the EventLoop accept connections of the given
+	  * ListenerSocket. Every accepted connection is given
+	  * to the acceptCallback.
+	 **/
+	void setListener(ListenerSocket *listener, std::function<void(CommunicationSocket *socket)> acceptCallback);
+
+private:
+	friend class EventConnection;
+
+	/**
+	  * Copying an EventLoop is illegal
+	 **/
+	EventLoop(const EventLoop &l);
+
+	/**
+	  * Copying an EventLoop is illegal
+	 **/
+	EventLoop& operator=(const EventLoop &l);
+
+	/**
+	  * This function waits for events and handles them
+	 **/
+	void loopFunction();
+
+	/**
+	  * Sets whether the EventLoop should wait until
+	  * the given file descriptor is writable
+	 **/
+	void watchWrite(int fd, bool write);
+
+	/**
+	  * Closes the connection with the given file descriptor
+	 **/
+	void close(int fd);
+
+	/**
+	  * Closes all connections which are idle for too long
+	 **/
+	void closeIdleConnections();
+
+private:
+	/**
+	  * The epoll file descriptor
+	 **/
+	int fd_epoll;
+
+	/**
+	  * A flag which is used to manage the running status
+	 **/
+	bool running;
+
+	/**
+	  * The callback which is called for every Package
+	 **/
+	std::function<void(const std::shared_ptr<EventConnection> &connection, const Package &data)> callback;
+
+	/**
+	  * The time in seconds after which an idle
+	  * connection is closed
+	 **/
+	const unsigned int &idleTimeout;
+
+	/**
+	  * The ListenerSocket to accept connections from
+	 **/
+	ListenerSocket *listener;
+
+	/**
+	  * The callback which is called for every
+	  * accepted connection
+	 **/
+	std::function<void(CommunicationSocket *socket)> acceptCallback;
+
+	/**
+	  * The connections of the EventLoop
+	 **/
+	std::map<int, std::shared_ptr<EventConnection> > connections;
+
+	/**
+	  * Allows parallel access to the connections
+	 **/
+	std::mutex connectionsMutex;
+
+	/**
+	  * The thread which handles the events
+	 **/
+	std::thread *t;
+
+}; //end class EventLoop
+
+} //end namespace cluster
+
+#endif //__linux__
+
+#endif //EVENTLOOP_HPP
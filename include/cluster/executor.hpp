@@ -0,0 +1,139 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace cluster
+{
+
+/**
+  * The Executor runs blocking tasks on a limited
+  * amount of worker threads which are reused.
+  * The threads are started when they are needed and
+  * stay idle until the Executor is shut down. Tasks
+  * which are waiting when the Executor is shut down
+  * are still run. Afterwards it can be started again.
+ **/
+class Executor
+{
+
+public:
+	/**
+	  * The default maximum amount of worker threads
+	 **/
+	static const unsigned int defaultMaxThreads = 16;
+
+	/**
+	  * Constructs an Executor which runs at most
+	  * maxThreads tasks at once
+	 **/
+	Executor(unsigned int maxThreads=defaultMaxThreads);
+
+	/**
+	  * Default destructor. Shuts the Executor down
+	 **/
+	~Executor();
+
+	/**
+	  * Runs the given task on a worker thread. Returns
+	  * false if the Executor is shut down already
+	 **/
+	bool execute(std::function<void()> task);
+
+	/**
+	  * Calls the given function for every index from 0
+	  * to count at once and waits until all calls are
+	  * finished. The calling thread takes part, so this
+	  * can also be called from a task
+	 **/
+	void forEach(std::size_t count, const std::function<void(std::size_t index)> &fn);
+
+	/**
+	  * Runs the waiting tasks and stops the worker
+	  * threads. No new tasks are accepted until
+	  * the Executor is started again
+	 **/
+	void shutdown();
+
+	/**
+	  * Accepts new tasks again after a shutdown
+	 **/
+	void start();
+
+private:
+	/**
+	  * The state of a forEach call
+	 **/
+	struct ForEach;
+
+	/**
+	  * Copying an Executor is illegal
+	 **/
+	Executor(const Executor &e);
+
+	/**
+	  * Copying an Executor is illegal
+	 **/
+	Executor& operator=(const Executor &e);
+
+	/**
+	  * Runs the tasks until the Executor is shut down
+	 **/
+	void workerFunction();
+
+private:
+	/**
+	  * The maximum amount of worker threads
+	 **/
+	unsigned int maxThreads;
+
+	/**
+	  * The worker threads
+	 **/
+	std::vector<std::thread*> threads;
+
+	/**
+	  * The amount of worker threads
+	  * which wait for a task
+	 **/
+	std::size_t idle;
+
+	/**
+	  * The tasks which wait for a worker thread
+	 **/
+	std::queue<std::function<void()> > tasks;
+
+	/**
+	  * A flag whether new tasks are accepted
+	 **/
+	bool running;
+
+	/**
+	  * Allows parallel access to the tasks
+	 **/
+	std::mutex m;
+
+	/**
+	  * Wakes up the worker threads
+	 **/
+	std::condition_variable cv;
+
+}; //end class Executor
+
+} //end namespace cluster
+
+#endif //EXECUTOR_HPP
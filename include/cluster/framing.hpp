@@ -0,0 +1,116 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef FRAMING_HPP
+#define FRAMING_HPP
+
+#include <cstddef>
+#include <stdint.h>
+
+#ifndef __linux__
+#include <winsock2.h>
+#endif //__linux__
+
+namespace cluster
+{
+
+class Package;
+
+/**
+  * The Framing is used by the stream based
+  * CommunicationSockets to send and receive Packages.
+  * Every Package is sent as a frame which consists of
+  * a header containing the length followed by the
+  * content of the Package.
+  * The header is a 4 byte little endian length. Frames
+  * of 4 GiB and more are sent with the 4 byte length
+  * 0xFFFFFFFF followed by the 8 byte little endian length.
+  * Frames which are larger than the maximum frame size
+  * are not received, and the connection is closed.
+  * The memory for a frame is reserved as soon as its
+  * header is received, so the maximum frame size protects
+  * against headers with an arbitrary length. It is
+  * defaultMaxFrameSize unless it is changed with
+  * Protocol::setMaxFrameSize for the connections of a
+  * Protocol or Server::setMaxFrameSize for the connections
+  * a Server accepts. Frames of 4 GiB and more are only
+  * received if the receiving side raises the limit.
+ **/
+class Framing
+{
+
+public:
+#ifdef __linux__
+	/**
+	  * The type of a socket descriptor
+	 **/
+	typedef int Descriptor;
+#else
+	/**
+	  * The type of a socket descriptor
+	 **/
+	typedef SOCKET Descriptor;
+#endif //__linux__
+
+	/**
+	  * The maximum size of a frame header
+	 **/
+	static const std::size_t maxHeaderSize = 12;
+
+	/**
+	  * The default maximum size of a received frame
+	 **/
+	static const uint64_t defaultMaxFrameSize = 1073741824;
+
+	/**
+	  * Writes the header of a frame with the given length
+	  * to header which needs to be at least maxHeaderSize
+	  * bytes long. Returns the size of the header
+	 **/
+	static std::size_t encodeHeader(uint64_t length, char *header);
+
+	/**
+	  * Reads the header of a frame from the given data.
+	  * Returns the size of the header or 0 if not enough
+	  * data is available.
+	 **/
+	static std::size_t decodeHeader(const char *data, std::size_t available, uint64_t &length);
+
+	/**
+	  * Sends the given Package as one frame. Header and
+	  * content are sent with one call and partially
+	  * sent data is retried until the frame is complete.
+	  * Empty Packages are sent as a single '\0' byte.
+	 **/
+	static bool send(Descriptor fd, const Package &message);
+
+	/**
+	  * Receives one frame and appends its content to out.
+	  * Waits until the whole frame was received.
+	  * Fails if the frame is larger than maxFrameSize
+	 **/
+	static bool receive(Descriptor fd, Package *out, uint64_t maxFrameSize);
+
+	/**
+	  * Sets the send and receive timeout in seconds of
+	  * the given socket. If noDelay is set, the Nagle
+	  * algorithm is disabled
+	 **/
+	static void setOptions(Descriptor fd, unsigned int timeout, bool noDelay);
+
+private:
+	/**
+	  * Receives exactly length bytes into data
+	 **/
+	static bool receiveAll(Descriptor fd, char *data, std::size_t length);
+
+}; //end class Framing
+
+} //end namespace cluster
+
+#endif //FRAMING_HPP
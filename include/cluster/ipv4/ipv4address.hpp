@@ -10,12 +10,21 @@
 #define IPV4ADDRESS_HPP
 
 #include <cluster/prototypes/address.hpp>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <netinet/in.h>
+#else
+#include <winsock2.h>
+#endif //__linux__
 
 namespace cluster
 {
 
 /**
-  * This class represents an IPv4 address
+  * This class represents an IPv4 address. It
+  * keeps the socket address which is used to
+  * connect. The port of it is not set
  **/
 class IPv4Address : public Address
 {
@@ -52,6 +61,31 @@ public:
 	 **/
 	virtual bool isLoopback() const override;
 
+	/**
+	  * Compares the binary representations
+	  * of the Addresses
+	 **/
+	virtual bool operator== (const Address &a) const override;
+
+	/**
+	  * Returns a hash of the binary representation
+	 **/
+	virtual std::size_t hash() const override;
+
+	/**
+	  * Returns the string representation
+	  * of the Address
+	 **/
+	virtual std::string toString() const override;
+
+	/**
+	  * Returns the socket address without port
+	 **/
+	const struct sockaddr_in& getSocketAddress() const
+	{
+		return socketAddress;
+	}
+
 	/**
 	  * Converts an Address in string representation
 	  * into the char array representation
@@ -66,9 +100,26 @@ public:
 
 protected:
 	/**
-	  * The address in char array representation
+	  * Returns the address in char array representation
+	 **/
+	uint8_t* bytes()
+	{
+		return reinterpret_cast<uint8_t*>(&socketAddress.sin_addr);
+	}
+
+	/**
+	  * Returns the address in char array representation
+	 **/
+	const uint8_t* bytes() const
+	{
+		return reinterpret_cast<const uint8_t*>(&socketAddress.sin_addr);
+	}
+
+protected:
+	/**
+	  * The socket address. sin_addr holds the address
 	 **/
-	uint8_t a[4];
+	struct sockaddr_in socketAddress;
 
 }; // end class IPv4Address
 
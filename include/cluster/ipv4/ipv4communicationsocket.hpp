@@ -72,6 +72,22 @@ public:
 	 **/
 	virtual bool receive(Package *out) override;
 
+	/**
+	  * Checks for the given time in milliseconds if
+	  * there is data waiting to be received
+	 **/
+	virtual bool poll(unsigned int time) override;
+
+#ifdef __linux__
+	/**
+	  * Returns the file descriptor of the connection
+	 **/
+	virtual int getDescriptor() const override
+	{
+		return fd_client;
+	}
+#endif //__linux__
+
 	/**
 	  * Returns the target port
 	 **/
@@ -54,6 +54,22 @@ public:
 	 **/
 	virtual CommunicationSocket* listen() override;
 
+#ifdef __linux__
+	/**
+	  * Returns the file descriptor of the server socket
+	 **/
+	virtual int getDescriptor() const override
+	{
+		return fd_socket;
+	}
+
+	/**
+	  * Accepts a waiting client connection and
+	  * puts it into non-blocking mode
+	 **/
+	virtual CommunicationSocket* listenNonBlocking() override;
+#endif //__linux__
+
 	/**
 	  * Returns the port on which to listen
 	 **/
@@ -14,10 +14,13 @@
 #include <cluster/ipv6/ipv6communicationsocket.hpp>
 #include <cluster/ipv6/ipv6listenersocket.hpp>
 #include <list>
+#include <vector>
 
 namespace cluster
 {
 
+class MulticastDiscovery;
+
 /**
   * This class represents the IPv6 protocol.
   * It is designed in the way that an IPv6
@@ -69,6 +72,30 @@ public:
 	 **/
 	virtual Address* decodeAddress(const std::string &address) const override;
 
+	/**
+	  * Finds the other members using a MulticastDiscovery
+	  * in the given group instead of scanning an address
+	  * range. If the group is empty, the default group is
+	  * used, if groupPort is 0, the port of the Protocol.
+	  * Needs to be called before the Protocol is used.
+	  * Returns false if the group can't be joined
+	 **/
+	bool enableDiscovery(const std::string &group="", uint16_t groupPort=0, unsigned int interval=1);
+
+	/**
+	  * Adds the IPv6Addresses of the members which
+	  * announced themselves in the multicast group.
+	  * Returns false if the discovery is not enabled
+	 **/
+	virtual bool discoverAddresses(std::list<Address*> &out) const override;
+
+	/**
+	  * Checks which of the given IPv6Addresses accept
+	  * connections on the port of the Protocol using
+	  * a ConnectScanner. Only available on Linux
+	 **/
+	virtual bool probeAddresses(const std::vector<const Address*> &addresses, std::vector<bool> &reachable, unsigned int concurrency, unsigned int probeTimeout) const override;
+
 	/**
 	  * Gets the timeout for establishing a connection
 	 **/
@@ -103,6 +130,17 @@ public:
 		this->listenBacklog = ui_listenBacklog;
 	}
 
+private:
+	/**
+	  * Copying an IPv6 Protocol is illegal
+	 **/
+	IPv6(const IPv6 &p);
+
+	/**
+	  * Copying an IPv6 Protocol is illegal
+	 **/
+	IPv6& operator=(const IPv6 &p);
+
 private:
 	/**
 	  * The port which is used for communication
@@ -120,6 +158,12 @@ private:
 	 **/
 	unsigned int listenBacklog;
 
+	/**
+	  * Finds the other members if the
+	  * discovery is enabled
+	 **/
+	MulticastDiscovery *discovery;
+
 }; // end class IPv6
 
 } //end namespace cluster
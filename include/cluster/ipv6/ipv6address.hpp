@@ -10,12 +10,22 @@
 #define IPV6ADDRESS_HPP
 
 #include <cluster/prototypes/address.hpp>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <netinet/in.h>
+#else
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif //__linux__
 
 namespace cluster
 {
 
 /**
-  * This class represents an IPv6 address
+  * This class represents an IPv6 address. It
+  * keeps the socket address which is used to
+  * connect. The port of it is not set
  **/
 class IPv6Address : public Address
 {
@@ -52,6 +62,31 @@ public:
 	 **/
 	virtual bool isLoopback() const override;
 
+	/**
+	  * Compares the binary representations
+	  * of the Addresses
+	 **/
+	virtual bool operator== (const Address &a) const override;
+
+	/**
+	  * Returns a hash of the binary representation
+	 **/
+	virtual std::size_t hash() const override;
+
+	/**
+	  * Returns the string representation
+	  * of the Address
+	 **/
+	virtual std::string toString() const override;
+
+	/**
+	  * Returns the socket address without port
+	 **/
+	const struct sockaddr_in6& getSocketAddress() const
+	{
+		return socketAddress;
+	}
+
 	/**
 	  * Converts an Address in string representation
 	  * into the char array representation
@@ -66,10 +101,26 @@ public:
 
 protected:
 	/**
-	  * The address in char array representation
+	  * Returns the address in char array representation
 	 **/
-	uint8_t a[16];
+	uint8_t* bytes()
+	{
+		return socketAddress.sin6_addr.s6_addr;
+	}
 
+	/**
+	  * Returns the address in char array representation
+	 **/
+	const uint8_t* bytes() const
+	{
+		return socketAddress.sin6_addr.s6_addr;
+	}
+
+protected:
+	/**
+	  * The socket address. sin6_addr holds the address
+	 **/
+	struct sockaddr_in6 socketAddress;
 
 }; // end class IPv6Address
 
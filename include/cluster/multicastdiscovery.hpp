@@ -0,0 +1,146 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef MULTICASTDISCOVERY_HPP
+#define MULTICASTDISCOVERY_HPP
+
+#ifdef __linux__
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <stdint.h>
+#include <sys/socket.h>
+
+namespace cluster
+{
+
+/**
+  * A MulticastDiscovery finds the other members by
+  * UDP multicast instead of scanning an address range.
+  * Every member joins the same multicast group and
+  * announces the port of its Protocol there in a fixed
+  * interval. The senders of the announcements which use
+  * the same port are the other members. The IPv4 and IPv6
+  * Protocols use it to discover addresses.
+  * The MulticastDiscovery is only available on Linux.
+ **/
+class MulticastDiscovery
+{
+
+public:
+	/**
+	  * The default multicast group for IPv4
+	 **/
+	static const char defaultGroupIPv4[];
+
+	/**
+	  * The default multicast group for IPv6
+	 **/
+	static const char defaultGroupIPv6[];
+
+	/**
+	  * Joins the given multicast group of the given address
+	  * family on the given UDP port and starts announcing
+	  * servicePort, the port of the Protocol, every interval
+	  * seconds. Throws a ListenerException if the group
+	  * can't be joined
+	 **/
+	MulticastDiscovery(int family, const std::string &group, uint16_t groupPort, uint16_t servicePort, unsigned int interval=1);
+
+	/**
+	  * Default destructor. Leaves the group
+	 **/
+	~MulticastDiscovery();
+
+	/**
+	  * Adds the addresses of the members which announced
+	  * themselves since the last call
+	 **/
+	void getDiscovered(std::list<std::string> &out);
+
+private:
+	/**
+	  * Copying a MulticastDiscovery is illegal
+	 **/
+	MulticastDiscovery(const MulticastDiscovery &d);
+
+	/**
+	  * Copying a MulticastDiscovery is illegal
+	 **/
+	MulticastDiscovery& operator=(const MulticastDiscovery &d);
+
+	/**
+	  * Sends the announcement to the group
+	 **/
+	void announce();
+
+	/**
+	  * Announces the member in the interval
+	  * and receives the other announcements
+	 **/
+	void discoveryFunction();
+
+private:
+	/**
+	  * The UDP socket which is in the group
+	 **/
+	int fd;
+
+	/**
+	  * The address of the group in the format
+	  * of the address family
+	 **/
+	struct sockaddr_storage groupAddress;
+
+	/**
+	  * The size of groupAddress
+	 **/
+	socklen_t groupAddressLength;
+
+	/**
+	  * The port of the Protocol which is announced
+	 **/
+	uint16_t servicePort;
+
+	/**
+	  * The time in seconds between two announcements
+	 **/
+	unsigned int interval;
+
+	/**
+	  * The addresses which announced themselves
+	  * and were not returned yet
+	 **/
+	std::set<std::string> discovered;
+
+	/**
+	  * Allows parallel access to discovered
+	 **/
+	std::mutex discoveredMutex;
+
+	/**
+	  * A flag whether the thread should run
+	 **/
+	std::atomic<bool> running;
+
+	/**
+	  * The thread which announces and receives
+	 **/
+	std::thread *t;
+
+}; //end class MulticastDiscovery
+
+} //end namespace cluster
+
+#endif //__linux__
+
+#endif //MULTICASTDISCOVERY_HPP
@@ -12,22 +12,39 @@
 #include <cluster/prototypes/protocol.hpp>
 #include <cluster/package.hpp>
 #include <cluster/clusterobject.hpp>
+#include <cluster/connectionpool.hpp>
+#include <cluster/server.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <list>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
 #include <thread>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace cluster
 {
 
 class Address;
 class Client;
-class Server;
 class MemberCallback;
 
 /**
   * The p2p (Peer-to-Peer) network contains
   * all the logic to create a decentralised
   * network with members of the same Protocol.
+  * Failed members are detected like in SWIM: in every
+  * protocol period one member is pinged. If it doesn't
+  * answer, some other members ping it as well and if
+  * none of them gets an answer, the member is suspected.
+  * A suspected member which doesn't refute the suspicion
+  * in time goes offline. The changes of the members are
+  * piggybacked on these messages.
  **/
 class p2p : public ClusterObject
 {
@@ -90,16 +107,28 @@ public:
 	  * Returns the current amount of memebers of the p2p
 	  * network
 	 **/
-	std::size_t getMembersCount() const
-	{
-		return members.size();
-	}
+	std::size_t getMembersCount() const;
+
+	/**
+	  * Returns the metrics of the request queue of
+	  * the Server. They are empty while the p2p
+	  * network is closed
+	 **/
+	ServerStatistics getServerStatistics() const;
 
 	/**
 	  * Adds an address range for members to scan
 	 **/
 	void addAddressRange(const Address &start, const Address &end);
 
+	/**
+	  * Reads the addresses of members from the given file,
+	  * one per line, and connects to them until they are
+	  * members. Empty lines and lines starting with # are
+	  * ignored. Returns false if the file can't be read
+	 **/
+	bool addSeedFile(const std::string &fileName);
+
 	/**
 	  * Checks if the given address points to the
 	  * current computer
@@ -153,6 +182,113 @@ public:
 		return this->continueWithoutMembers;
 	}
 
+	/**
+	  * Sets whether Packages are sent in the compact
+	  * Format once all members support it
+	 **/
+	void setCompactFormat(bool b_compactFormat);
+
+	/**
+	  * Sets how many Addresses of the address ranges
+	  * are probed at once if the Protocol supports it
+	 **/
+	void setScanConcurrency(unsigned int ui_scanConcurrency)
+	{
+		this->scanConcurrency = ui_scanConcurrency;
+	}
+
+	/**
+	  * Returns how many Addresses of the address
+	  * ranges are probed at once
+	 **/
+	unsigned int getScanConcurrency() const
+	{
+		return this->scanConcurrency;
+	}
+
+	/**
+	  * Sets the time in milliseconds a probed
+	  * Address has to accept the connection
+	 **/
+	void setScanTimeout(unsigned int ui_scanTimeout)
+	{
+		this->scanTimeout = ui_scanTimeout;
+	}
+
+	/**
+	  * Returns the time in milliseconds a probed
+	  * Address has to accept the connection
+	 **/
+	unsigned int getScanTimeout() const
+	{
+		return this->scanTimeout;
+	}
+
+	/**
+	  * Gets whether Packages are sent in the compact
+	  * Format once all members support it
+	 **/
+	bool getCompactFormat() const
+	{
+		return this->compactFormat;
+	}
+
+	/**
+	  * Sets the time in milliseconds in which
+	  * one member is pinged
+	 **/
+	void setProtocolPeriod(unsigned int ui_protocolPeriod)
+	{
+		this->protocolPeriod = ui_protocolPeriod;
+	}
+
+	/**
+	  * Returns the time in milliseconds in
+	  * which one member is pinged
+	 **/
+	unsigned int getProtocolPeriod() const
+	{
+		return this->protocolPeriod;
+	}
+
+	/**
+	  * Sets how many members ping a member
+	  * which didn't answer the ping
+	 **/
+	void setIndirectProbes(unsigned int ui_indirectProbes)
+	{
+		this->indirectProbes = ui_indirectProbes;
+	}
+
+	/**
+	  * Returns how many members ping a member
+	  * which didn't answer the ping
+	 **/
+	unsigned int getIndirectProbes() const
+	{
+		return this->indirectProbes;
+	}
+
+	/**
+	  * Sets how many protocol periods, multiplied by
+	  * the logarithm of the amount of members, a
+	  * suspected member has to refute the suspicion
+	 **/
+	void setSuspicionMultiplier(unsigned int ui_suspicionMultiplier)
+	{
+		this->suspicionMultiplier = ui_suspicionMultiplier;
+	}
+
+	/**
+	  * Returns how many protocol periods, multiplied by
+	  * the logarithm of the amount of members, a
+	  * suspected member has to refute the suspicion
+	 **/
+	unsigned int getSuspicionMultiplier() const
+	{
+		return this->suspicionMultiplier;
+	}
+
 protected:
 	/**
 	  * This function is called for every Package.
@@ -183,12 +319,38 @@ private:
 	 **/
 	void received_internal(const Address &ip, const Package &message, Package &answer);
 
+	/**
+	  * This function is called for every Package which
+	  * is received over a Channel. The Package which is
+	  * stored in to_send is sent back over the Channel
+	 **/
+	void received_channel(const Address &ip, const Package &message, Package &answer, Package &to_send);
+
 	/**
 	  * This function is called by the testAlive thread
 	  * to search for new members
 	 **/
         void connectToHosts();
 
+	/**
+	  * This function is called by the testAliveThread
+	  * to test the connection to the members which
+	  * the Protocol finds on its own
+	 **/
+	void discoverMembers();
+
+	/**
+	  * Connects to the addresses of the seed
+	  * files which are not members
+	 **/
+	void connectToSeeds();
+
+	/**
+	  * Connects to the members which other
+	  * members announced in their gossip
+	 **/
+	void connectToGossipedMembers();
+
 	/**
 	  * This function is called by the testAliveThread
 	  * to test the connection to a specific address
@@ -198,9 +360,13 @@ private:
 	/**
 	  * This function is called internally whenever a member
 	  * is online. This fucntion asks then for other peers
-	  * and calls the member callbacks
+	  * and calls the member callbacks. compact tells
+	  * whether the member supports the compact Format,
+	  * supportsGossip whether it supports the ping messages
+	  * and readsBatches whether it reads the batches of
+	  * ClusterObjectSerialized
 	 **/
-	void online(const Address &address, unsigned long long otherTime);
+	void online(const Address &address, unsigned long long otherTime, bool compact, bool supportsGossip, bool readsBatches);
 
 	/**
 	  * This function is called internally whenever a member
@@ -208,6 +374,28 @@ private:
 	 **/
 	void offline(const Address &address);
 
+	/**
+	  * Returns the Format which is sent
+	  * in the echo message
+	 **/
+	char supportedFormat() const;
+
+	/**
+	  * Uses the compact Format for new Packages of
+	  * the network if all members support it
+	 **/
+	void updateFormat();
+
+	/**
+	  * Checks whether the member can read Packages in
+	  * the given Format. A Package can't be encoded again,
+	  * so compact Packages which were created before a
+	  * member which only supports the fixed Format joined
+	  * are not sent to it. Unknown addresses only get
+	  * Packages in the fixed Format
+	 **/
+	bool readsFormat(const Address &address, Package::Format format);
+
 	/**
 	  * Overrides the function from ClusterObject.
 	  * This is the final function of the network
@@ -216,6 +404,32 @@ private:
 	 **/
 	virtual bool ClusterObject_ask(const Address &ip, const Package &message, Package *answer) override;
 
+	/**
+	  * Overrides the function from ClusterObject.
+	  * Asks the member without waiting for the answer
+	 **/
+	virtual void ClusterObject_askAsync(const Address &ip, const Package &message, Package *answer, std::function<void(bool success)> callback) override;
+
+	/**
+	  * Overrides the function from ClusterObject.
+	  * Members of older versions don't read batches
+	 **/
+	virtual bool ClusterObject_readsBatches() override;
+
+	/**
+	  * Overrides the function from ClusterObject.
+	  * The messages are created in the compact Format
+	  * if every member reads it
+	 **/
+	virtual Package::Format ClusterObject_getFormat() override;
+
+	/**
+	  * Calls the given function for every Client at
+	  * once using the Executor of the ConnectionPool
+	  * and waits until all of them are finished
+	 **/
+	void forEachConcurrently(const std::list<Client> &clients, const std::function<void(const Client &client, std::size_t index)> &fn);
+
 	/**
 	  * Overrides the function from ClusterObject.
 	  * This is the final function of the network
@@ -224,9 +438,189 @@ private:
 	 **/
 	virtual bool ClusterObject_send(const Package &message, AnswerPackage *answer) override;
 
+	/**
+	  * Overrides the function from ClusterObject.
+	  * Sends the package to all members without waiting.
+	  * The callback is called when all members answered
+	 **/
+	virtual void ClusterObject_sendAsync(const Package &message, AnswerPackage *answer, std::function<void(bool success)> callback) override;
+
 private:
 	/**
-	  * Allows parallel access to the addressRanges list
+	  * The state of an asynchronous broadcast
+	 **/
+	struct Broadcast;
+
+	/**
+	  * Called for every member which answered an
+	  * asynchronous broadcast or failed
+	 **/
+	void broadcastAnswered(const std::shared_ptr<Broadcast> &broadcast, std::size_t index, bool success);
+
+	/**
+	  * Waits for the joining members which need to
+	  * be checked before a Package can be sent
+	 **/
+	void checkOtherPeers();
+
+	/**
+	  * Stops waiting for the other peers of the given
+	  * member, e.g. because it went offline
+	 **/
+	void uncheckOtherPeers(const Address &address);
+
+	/**
+	  * Sends the Package to the given members until all
+	  * of them got it or went offline
+	 **/
+	bool sendToMembers(const Package &message, AnswerPackage *answer, std::list<Client> toSend, std::mutex &answerMutex);
+
+	/**
+	  * Tests the connection to the given members
+	  * which didn't answer
+	 **/
+	void retestMembers(const std::list<Client> &clients);
+
+	/**
+	  * The snapshot of the members
+	 **/
+	struct MemberTable;
+
+	/**
+	  * Returns the current snapshot of the members.
+	  * It stays valid while members join and leave
+	 **/
+	std::shared_ptr<const MemberTable> getMembers() const;
+
+	/**
+	  * Adds the Client to the members. Returns false if
+	  * it is a member already. memberMutex needs to be locked
+	 **/
+	bool addMember(const Client &client);
+
+	/**
+	  * Removes the member with the given Address. Returns
+	  * false if it is no member. memberMutex needs to be locked
+	 **/
+	bool removeMember(const Address &address);
+
+private:
+	/**
+	  * The states of a member in the failure
+	  * detection. The values are sent in the gossip
+	 **/
+	enum class MemberStatus : char
+	{
+		alive = 'a',
+		suspect = 's',
+		dead = 'd'
+	};
+
+	/**
+	  * What the failure detection knows about a member
+	  * and the Format which the member reads
+	 **/
+	struct MemberState
+	{
+		MemberState() :
+			status(MemberStatus::alive),
+			incarnation(0),
+			suspected(),
+			gossip(false),
+			format(Package::Format::fixed)
+		{}
+
+		MemberStatus status;
+		unsigned long long incarnation;
+		std::chrono::steady_clock::time_point suspected;
+		bool gossip;
+		Package::Format format;
+	};
+
+	/**
+	  * A change of a member which is piggybacked
+	  * on the messages of the failure detection.
+	  * An empty address stands for the sender
+	 **/
+	struct GossipUpdate
+	{
+		GossipUpdate(const std::string &str_address, MemberStatus e_status, unsigned long long ull_incarnation) :
+			address(str_address),
+			status(e_status),
+			incarnation(ull_incarnation),
+			transmissions(0)
+		{}
+
+		std::string address;
+		MemberStatus status;
+		unsigned long long incarnation;
+		unsigned int transmissions;
+	};
+
+	/**
+	  * The state of a ping which waits for its answer
+	 **/
+	struct Probe;
+
+	/**
+	  * This function is called by the failureDetectorThread
+	  * and pings one member in every protocol period
+	 **/
+	void detectFailures();
+
+	/**
+	  * Returns the next member to ping or nullptr if there
+	  * are no members. Every member is pinged once per round
+	  * and the order of each round is random
+	 **/
+	Address* nextProbeTarget();
+
+	/**
+	  * Pings the given member and asks other members to
+	  * ping it if it doesn't answer. The member is suspected
+	  * if nobody got an answer within the protocol period
+	 **/
+	void probe(const Address &target);
+
+	/**
+	  * Returns the message to ping the given member.
+	  * Older members get an echo message instead
+	 **/
+	Package createPing(const Address &target);
+
+	/**
+	  * Sets the given members offline whose
+	  * suspicion timeout elapsed
+	 **/
+	void expireSuspects();
+
+	/**
+	  * Returns the time a suspected member has
+	  * to refute the suspicion
+	 **/
+	std::chrono::milliseconds suspicionTimeout();
+
+	/**
+	  * Adds a change of a member to the gossip
+	 **/
+	void addGossip(const std::string &address, MemberStatus status, unsigned long long incarnation);
+
+	/**
+	  * Appends the gossip which was sent the
+	  * least often to the given message
+	 **/
+	void writeGossip(Package &message);
+
+	/**
+	  * Applies the gossip at the end of the
+	  * given message which ip sent
+	 **/
+	void readGossip(const Address &ip, const Package &message);
+
+private:
+	/**
+	  * Allows parallel access to the addressRanges
+	  * and the seeds list
 	 **/
 	std::mutex addressRangeMutex;
 
@@ -235,11 +629,22 @@ private:
 	 **/
 	std::list<std::pair<Address*,Address*> > addressRanges;
 
+	/**
+	  * Contains the addresses of the seed files
+	 **/
+	std::list<Address*> seeds;
+
 	/**
 	  * The protocol which is used for communication
 	 **/
 	const Protocol &protocol;
 
+	/**
+	  * Holds the open connections to the other members
+	  * which are used for asking and sending
+	 **/
+	ConnectionPool pool;
+
 	/**
 	  * A flag that determines whether the p2p network
 	  * should is connected and therefore should search
@@ -269,9 +674,11 @@ private:
 	std::list<Address*> addresses;
 
 	/**
-	  * The members of the p2p network
+	  * The members of the p2p network. The snapshot is
+	  * replaced while memberMutex is locked and read using
+	  * std::atomic_load without locking
 	 **/
-	std::list<Client> members;
+	std::shared_ptr<const MemberTable> members;
 
 	/**
 	  * The server which listens for connections
@@ -284,7 +691,12 @@ private:
 	std::thread *testAliveThread;
 
 	/**
-	  * The mutex wich allows parallel access to the member list 
+	  * The thread which pings the members
+	 **/
+	std::thread *failureDetectorThread;
+
+	/**
+	  * The mutex wich allows parallel changes of the members
 	 **/
 	std::mutex memberMutex;
 
@@ -313,11 +725,114 @@ private:
 	 **/
 	bool continueWithoutMembers;
 
+	/**
+	  * The amount of Addresses which
+	  * are probed at once
+	 **/
+	std::atomic<unsigned int> scanConcurrency;
+
+	/**
+	  * The time in milliseconds a probed Address
+	  * has to accept the connection
+	 **/
+	std::atomic<unsigned int> scanTimeout;
+
+	/**
+	  * A flag whether Packages are sent in the compact
+	  * Format once all members support it
+	 **/
+	std::atomic<bool> compactFormat;
+
+	/**
+	  * A flag whether new Packages of the
+	  * network are created in the compact Format
+	 **/
+	std::atomic<bool> usesCompactFormat;
+
+	/**
+	  * The members which don't read the batches of
+	  * ClusterObjectSerialized. It is protected
+	  * by memberMutex
+	 **/
+	std::list<Client> unbatchedMembers;
+
 	/**
 	  * This mutex synchronizes access to the member callbacks
 	 **/
 	std::mutex callbackMutex;
 
+	/**
+	  * The time in milliseconds in
+	  * which one member is pinged
+	 **/
+	std::atomic<unsigned int> protocolPeriod;
+
+	/**
+	  * The amount of members which ping a
+	  * member that didn't answer the ping
+	 **/
+	std::atomic<unsigned int> indirectProbes;
+
+	/**
+	  * The amount of protocol periods, multiplied by
+	  * the logarithm of the amount of members, a
+	  * suspected member has to refute the suspicion
+	 **/
+	std::atomic<unsigned int> suspicionMultiplier;
+
+	/**
+	  * The failure detection state of the members.
+	  * It is protected by memberMutex
+	 **/
+	std::unordered_map<AddressKey,MemberState> memberStates;
+
+	/**
+	  * The members in the order in which they are
+	  * pinged in the current round
+	 **/
+	std::vector<AddressKey> probeOrder;
+
+	/**
+	  * The position of the next member in probeOrder
+	 **/
+	std::size_t probeIndex;
+
+	/**
+	  * Shuffles the rounds and selects the
+	  * members for the indirect pings
+	 **/
+	std::mt19937 randomGenerator;
+
+	/**
+	  * The incarnation of the current computer. It is
+	  * increased to refute a suspicion
+	 **/
+	unsigned long long incarnation;
+
+	/**
+	  * The changes of the members which still
+	  * need to be piggybacked
+	 **/
+	std::list<GossipUpdate> gossip;
+
+	/**
+	  * The pings which wait for an answer of the
+	  * members which were asked to ping the member
+	 **/
+	std::map<std::string,std::shared_ptr<Probe> > pendingProbes;
+
+	/**
+	  * The addresses which other members announced
+	  * and which are not members yet
+	 **/
+	std::list<std::string> gossipedMembers;
+
+	/**
+	  * Allows parallel access to incarnation, gossip,
+	  * pendingProbes and gossipedMembers
+	 **/
+	std::mutex gossipMutex;
+
 }; // end class p2p
 
 } //end namespace cluster
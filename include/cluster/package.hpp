@@ -10,9 +10,14 @@
 #define PACKAGE_HPP
 
 #include <algorithm>
+#include <atomic>
+#include <limits>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 #include <list>
+#include <stdint.h>
+#include <string.h>
 
 namespace cluster
 {
@@ -29,17 +34,121 @@ namespace cluster
   * Package also contains a string function to get
   * the content in string representation this also
   * works fairly good with binary data.
+  * Small contents are stored inside of the Package itself.
+  * Bigger ones are stored in a Buffer which is taken from
+  * a pool of the current thread and is shared by the copies
+  * of a Package. The memory has some headroom in front of
+  * the content so that headers can be prepended without
+  * copying the content, and subPackageFromCurrentPosition
+  * doesn't copy anything either. The content is only copied
+  * if a shared Package is changed in a way that would
+  * affect the others.
+  * Lengths of strings and containers are written in the
+  * Format of the Package. It is taken over by copies and
+  * needs to be known by the receiver. A Channel sends it
+  * together with every frame.
+  * New Packages use the fixed Format unless they are
+  * created within a FormatScope.
  **/
 class Package
 {
 
 public:
+	/**
+	  * The formats in which lengths and integers are
+	  * written. Packages in the compact Format may
+	  * only be sent to members which support it
+	 **/
+	enum class Format : char
+	{
+
+		/**
+		  * Lengths are written as uint64_t and
+		  * integers with the size of their type
+		 **/
+		fixed = '1',
+
+		/**
+		  * Lengths and integers are written as LEB128
+		  * varints. Signed integers are zigzag encoded
+		  * so that small negative numbers stay small
+		 **/
+		compact = '2'
+
+	}; //end enum Format
+
+	/**
+	  * Sets the Format of the Packages which are
+	  * created by the current thread as long as
+	  * the FormatScope exists
+	 **/
+	class FormatScope
+	{
+
+	public:
+		/**
+		  * Sets the Format of the current thread
+		 **/
+		FormatScope(Format f) :
+			previous(threadFormat)
+		{
+			threadFormat = f;
+		}
+
+		/**
+		  * Restores the previous Format
+		 **/
+		~FormatScope()
+		{
+			threadFormat = previous;
+		}
+
+		/**
+		  * Copying a FormatScope is illegal
+		 **/
+		FormatScope(const FormatScope &s) = delete;
+
+		/**
+		  * Copying a FormatScope is illegal
+		 **/
+		FormatScope& operator=(const FormatScope &s) = delete;
+
+	private:
+		/**
+		  * The Format before the FormatScope
+		 **/
+		Format previous;
+
+	}; //end class FormatScope
+
+	/**
+	  * The amount of bytes which are reserved
+	  * in front of the content for headers
+	 **/
+	static const std::size_t defaultHeadroom = 64;
+
+	/**
+	  * The amount of bytes which are stored
+	  * inside of the Package itself
+	 **/
+	static const std::size_t inlineSize = 96;
+
+	/**
+	  * The amount of bytes which are reserved in
+	  * front of content stored inside of the Package
+	 **/
+	static const std::size_t inlineHeadroom = 32;
+
 	/**
 	  * Default constructor.
 	 **/
 	Package() :
-		data(),
-		iteratorPosition(0)
+		buffer(nullptr),
+		dataBegin(inlineHeadroom),
+		dataEnd(inlineHeadroom),
+		iteratorPosition(0),
+		format(getDefaultFormat()),
+		inlineBytes()
 	{}
 
 	/**
@@ -47,18 +156,172 @@ public:
 	  * the given content
 	 **/
 	Package(const char *c_data, std::size_t length) :
-		data(c_data, c_data+length),
-		iteratorPosition(0)
-	{}
+		buffer(nullptr),
+		dataBegin(inlineHeadroom),
+		dataEnd(inlineHeadroom),
+		iteratorPosition(0),
+		format(getDefaultFormat()),
+		inlineBytes()
+	{
+		write(c_data, length);
+	}
 
 	/**
 	  * Constructor to create a Package using
 	  * the given content
 	 **/
 	Package(const std::vector<char> &v_data) :
-		data(v_data),
-		iteratorPosition(0)
-	{}
+		buffer(nullptr),
+		dataBegin(inlineHeadroom),
+		dataEnd(inlineHeadroom),
+		iteratorPosition(0),
+		format(getDefaultFormat()),
+		inlineBytes()
+	{
+		write(v_data.data(), v_data.size());
+	}
+
+	/**
+	  * Copy constructor. The content is shared
+	 **/
+	Package(const Package &p) :
+		buffer(p.buffer),
+		dataBegin(p.dataBegin),
+		dataEnd(p.dataEnd),
+		iteratorPosition(p.iteratorPosition),
+		format(p.format),
+		inlineBytes()
+	{
+		if(buffer)++buffer->references;
+		else memcpy(inlineBytes + dataBegin, p.inlineBytes + dataBegin, getLength());
+	}
+
+	/**
+	  * Move constructor. The given
+	  * Package is empty afterwards
+	 **/
+	Package(Package &&p) :
+		buffer(p.buffer),
+		dataBegin(p.dataBegin),
+		dataEnd(p.dataEnd),
+		iteratorPosition(p.iteratorPosition),
+		format(p.format),
+		inlineBytes()
+	{
+		if(!buffer)memcpy(inlineBytes + dataBegin, p.inlineBytes + dataBegin, getLength());
+		p.buffer = nullptr;
+		p.dataBegin = inlineHeadroom;
+		p.dataEnd = inlineHeadroom;
+		p.iteratorPosition = 0;
+	}
+
+	/**
+	  * Default destructor. The Buffer goes back
+	  * to the pool if it is not shared anymore
+	 **/
+	~Package()
+	{
+		release();
+	}
+
+	/**
+	  * Assignment operator. The content is shared
+	 **/
+	Package& operator=(const Package &p)
+	{
+		if(this == &p)return *this;
+
+		//The reference is taken first in case
+		//both Packages share the Buffer
+		if(p.buffer)++p.buffer->references;
+		release();
+
+		buffer = p.buffer;
+		dataBegin = p.dataBegin;
+		dataEnd = p.dataEnd;
+		iteratorPosition = p.iteratorPosition;
+		format = p.format;
+		if(!buffer)memcpy(inlineBytes + dataBegin, p.inlineBytes + dataBegin, getLength());
+		return *this;
+	}
+
+	/**
+	  * Move assignment operator. The given
+	  * Package is empty afterwards
+	 **/
+	Package& operator=(Package &&p)
+	{
+		if(this == &p)return *this;
+		release();
+
+		buffer = p.buffer;
+		dataBegin = p.dataBegin;
+		dataEnd = p.dataEnd;
+		iteratorPosition = p.iteratorPosition;
+		format = p.format;
+		if(!buffer)memcpy(inlineBytes + dataBegin, p.inlineBytes + dataBegin, getLength());
+
+		p.buffer = nullptr;
+		p.dataBegin = inlineHeadroom;
+		p.dataEnd = inlineHeadroom;
+		p.iteratorPosition = 0;
+		return *this;
+	}
+
+	/**
+	  * Returns the Format of new Packages. It is the
+	  * Format of the current FormatScope or the fixed
+	  * Format outside of any FormatScope
+	 **/
+	static Format getDefaultFormat()
+	{
+		return threadFormat;
+	}
+
+	/**
+	  * Returns the Format of the Package
+	 **/
+	Format getFormat() const
+	{
+		return format;
+	}
+
+	/**
+	  * Sets the Format of the Package. This needs to
+	  * be done before the content is written or read
+	 **/
+	void setFormat(Format f)
+	{
+		format = f;
+	}
+
+	/**
+	  * Makes sure that size more bytes can be
+	  * written without allocating memory. Writers
+	  * which know the size of the content should
+	  * call this first
+	 **/
+	void reserve(std::size_t size)
+	{
+		if(buffer)
+		{
+			releaseUnused();
+			if(buffer->capacity - dataEnd >= size && buffer->back == dataEnd)return;
+		}
+		else if(inlineSize - dataEnd >= size)return;
+
+		reallocate(defaultHeadroom, getLength() + size);
+	}
+
+	/**
+	  * Appends size bytes to the content and returns
+	  * where they are, so that the content can be
+	  * written directly into the Package
+	 **/
+	char* extend(std::size_t size)
+	{
+		return reserveBack(size);
+	}
 
 	void write(const char &t){ write_internal(t); }
 	void write(const char16_t &t){ write_internal(t); }
@@ -98,6 +361,97 @@ public:
 	void write(const long double *array, std::size_t size) { write_internal(array, size); }
 	void write(const bool *array, std::size_t size) { write_internal(array, size); }
 
+	/**
+	  * Appends the content of the given Package.
+	  * If this Package is empty, the content
+	  * is shared instead of copied.
+	 **/
+	void write(const Package &p)
+	{
+		if(empty() && p.buffer && !p.empty())
+		{
+			++p.buffer->references;
+			release();
+			buffer = p.buffer;
+			dataBegin = p.dataBegin;
+			dataEnd = p.dataEnd;
+			format = p.format;
+			return;
+		}
+		write(p.getData(), p.getLength());
+	}
+
+	/**
+	  * Writes the given length of a string or
+	  * container in the Format of the Package
+	 **/
+	void writeLength(uint64_t length)
+	{
+		if(format == Format::compact)writeVarint(length);
+		else write(length);
+	}
+
+	/**
+	  * Writes the given integer in the Format
+	  * of the Package
+	 **/
+	template <class T>
+	void writeInteger(const T &t)
+	{
+		static_assert(std::is_integral<T>::value, "Only integers can be written as varint");
+		if(format == Format::compact)writeVarint(toVarint(t, std::is_signed<T>()));
+		else write(t);
+	}
+
+	/**
+	  * Writes the given value as LEB128 varint:
+	  * 7 bits per byte, the highest bit tells
+	  * whether another byte follows
+	 **/
+	void writeVarint(uint64_t value)
+	{
+		char bytes[maxVarintSize];
+		write(bytes, encodeVarint(value, bytes));
+	}
+
+	/**
+	  * Inserts the given value in front of the content.
+	  * This is used to add headers to a Package which
+	  * already contains the content.
+	 **/
+	template <class T>
+	void prepend(const T &t)
+	{
+		static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Only basic values can be prepended");
+		prepend(reinterpret_cast<const char*>(&t), sizeof(T));
+	}
+
+	/**
+	  * Inserts the given integer in front of the
+	  * content in the Format of the Package
+	 **/
+	template <class T>
+	void prependInteger(const T &t)
+	{
+		static_assert(std::is_integral<T>::value, "Only integers can be written as varint");
+		if(format == Format::fixed)
+		{
+			prepend(t);
+			return;
+		}
+		char bytes[maxVarintSize];
+		prepend(bytes, encodeVarint(toVarint(t, std::is_signed<T>()), bytes));
+	}
+
+	/**
+	  * Inserts the given bytes in front of the content
+	 **/
+	void prepend(const char *array, std::size_t size)
+	{
+		if(size == 0)return;
+		memcpy(reserveFront(size), array, size);
+	}
+
 	bool get(char &t) const { return get_internal(t); }
 	bool get(char16_t &t) const { return get_internal(t); }
 	bool get(char32_t &t) const { return get_internal(t); }
@@ -174,12 +528,73 @@ public:
 	bool getAndNext(long double *array, std::size_t size) const { return getAndNext_internal(array, size); }
 	bool getAndNext(bool *array, std::size_t size) const { return getAndNext_internal(array, size); }
 
+	/**
+	  * Reads a length of a string or container
+	  * in the Format of the Package
+	 **/
+	bool readLength(uint64_t &length) const
+	{
+		if(format == Format::compact)return readVarint(length);
+		return getAndNext(length);
+	}
+
+	/**
+	  * Reads an integer in the Format of the Package.
+	  * Fails if the value doesn't fit into the type
+	 **/
+	template <class T>
+	bool readInteger(T &t) const
+	{
+		static_assert(std::is_integral<T>::value, "Only integers can be read as varint");
+		if(format == Format::fixed)return getAndNext(t);
+
+		uint64_t value;
+		if(!readVarint(value))return false;
+		return fromVarint(value, t, std::is_signed<T>());
+	}
+
+	/**
+	  * Reads a LEB128 varint
+	 **/
+	bool readVarint(uint64_t &value) const
+	{
+		const char *content = getData() + iteratorPosition;
+		const std::size_t available = getLength() - iteratorPosition;
+
+		value = 0;
+		for(std::size_t i = 0; i < available && i < maxVarintSize; ++i)
+		{
+			const unsigned char byte = (unsigned char)content[i];
+			value |= uint64_t(byte & 0x7F) << (7 * i);
+			if(!(byte & 0x80))
+			{
+				iteratorPosition += i + 1;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	  * Sets data to the next size bytes of the content
+	  * without copying them and increases the iterator.
+	  * data stays valid as long as the Package exists
+	  * and is not changed
+	 **/
+	bool viewAndNext(const char *&data, std::size_t size) const
+	{
+		if(size > getRemaining())return false;
+		data = getData() + iteratorPosition;
+		iteratorPosition += size;
+		return true;
+	}
+
 	/**
 	  * Returns whether the current package equals the given one
 	 **/
 	bool operator== (const Package &pkg) const
 	{
-		return this->data == pkg.data;
+		return getLength() == pkg.getLength() && (empty() || memcmp(getData(), pkg.getData(), getLength()) == 0);
 	}
 
 	/**
@@ -188,7 +603,7 @@ public:
 	 **/
 	bool operator!= (const Package &pkg) const
 	{
-		return this->data != pkg.data;
+		return !(*this == pkg);
 	}
 
 	/**
@@ -196,16 +611,34 @@ public:
 	 **/
 	void clear()
 	{
-		data.clear();
+		if(!buffer || buffer->references == 1)
+		{
+			dataEnd = dataBegin;
+			if(buffer)releaseUnused();
+		}
+		else release();
 	}
 
 	/**
-	  * Creates a new Package which contains
-	  * the content after the current read position
+	  * Creates a new Package which contains the content
+	  * after the current read position. The content
+	  * is shared and not copied.
 	 **/
 	Package subPackageFromCurrentPosition() const
 	{
-		return Package(&data[iteratorPosition], data.size() - iteratorPosition);
+		Package p;
+		p.format = format;
+		if(!buffer)
+		{
+			p.write(getData() + iteratorPosition, getLength() - iteratorPosition);
+			return p;
+		}
+
+		++buffer->references;
+		p.buffer = buffer;
+		p.dataBegin = dataBegin + iteratorPosition;
+		p.dataEnd = dataEnd;
+		return p;
 	}
 
 	/**
@@ -214,7 +647,7 @@ public:
 	 **/
 	void next(std::size_t size) const
 	{
-		if(iteratorPosition+size > data.size())return;
+		if(iteratorPosition+size > getLength())return;
 		iteratorPosition += size;
 	}
 
@@ -223,7 +656,7 @@ public:
 	 **/
 	std::size_t getLength() const
 	{
-		return data.size();
+		return dataEnd - dataBegin;
 	}
 
 	/**
@@ -231,7 +664,16 @@ public:
 	 **/
 	bool empty() const
 	{
-		return data.empty();
+		return dataEnd == dataBegin;
+	}
+
+	/**
+	  * Returns the amount of bytes which
+	  * were not read yet
+	 **/
+	std::size_t getRemaining() const
+	{
+		return getLength() - iteratorPosition;
 	}
 
 	/**
@@ -239,7 +681,7 @@ public:
 	 **/
 	bool finished() const
 	{
-		return iteratorPosition == data.size();
+		return iteratorPosition == getLength();
 	}
 
 	/**
@@ -250,9 +692,10 @@ public:
 	{
 		if(empty())return true;
 
-		for(const char c : data)
+		const char *content = getData();
+		for(std::size_t i = 0; i < getLength(); ++i)
 		{
-			if(c != '\0')return false;
+			if(content[i] != '\0')return false;
 		}
 		return true;
 	}
@@ -262,7 +705,7 @@ public:
 	 **/
 	const char* getData() const
 	{
-		return &(data[0]);
+		return (buffer ? buffer->bytes() : inlineBytes) + dataBegin;
 	}
 
 	/**
@@ -290,8 +733,10 @@ public:
 	{
 		std::stringstream os;
 		bool lastWasBinary = false;
-		for(const char &c : data)
+		const char *content = getData();
+		for(std::size_t i = 0; i < getLength(); ++i)
 		{
+			const char c = content[i];
 			if(isalnum(c))
 			{
 				if(lastWasBinary)os<<'.'<<std::dec;
@@ -306,19 +751,265 @@ public:
 			}
 		}
 		if(lastWasBinary)os<<'.'<<std::dec;
-		os<<" ("<<data.size()<<")";
+		os<<" ("<<getLength()<<")";
 		return os.str();
 	}
 
 private:
+	/**
+	  * The maximum size of a varint
+	 **/
+	static const std::size_t maxVarintSize = 10;
+
+	/**
+	  * Writes the given value as varint into
+	  * bytes and returns its size
+	 **/
+	static std::size_t encodeVarint(uint64_t value, char *bytes)
+	{
+		std::size_t size = 0;
+		for(; value > 0x7F; value >>= 7)bytes[size++] = char((value & 0x7F) | 0x80);
+		bytes[size++] = char(value);
+		return size;
+	}
+
+	/**
+	  * Returns the zigzag encoded value of
+	  * the given signed integer
+	 **/
+	template <class T>
+	static uint64_t toVarint(const T &t, std::true_type)
+	{
+		const int64_t value = int64_t(t);
+		return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+	}
+
+	/**
+	  * Returns the given unsigned integer
+	 **/
+	template <class T>
+	static uint64_t toVarint(const T &t, std::false_type)
+	{
+		return uint64_t(t);
+	}
+
+	/**
+	  * Decodes the given zigzag encoded value.
+	  * Fails if it doesn't fit into the type
+	 **/
+	template <class T>
+	static bool fromVarint(uint64_t value, T &t, std::true_type)
+	{
+		const int64_t decoded = int64_t(value >> 1) ^ -int64_t(value & 1);
+		if(decoded < int64_t(std::numeric_limits<T>::min()) || decoded > int64_t(std::numeric_limits<T>::max()))return false;
+		t = T(decoded);
+		return true;
+	}
+
+	/**
+	  * Stores the given unsigned value.
+	  * Fails if it doesn't fit into the type
+	 **/
+	template <class T>
+	static bool fromVarint(uint64_t value, T &t, std::false_type)
+	{
+		if(value > uint64_t(std::numeric_limits<T>::max()))return false;
+		t = T(value);
+		return true;
+	}
+
+	/**
+	  * The memory of the content which is shared
+	  * by the copies of a Package. Every Package
+	  * owns a part of it. The bytes before front
+	  * and after back are not owned by any Package
+	  * and can be taken by the Package which
+	  * begins at front or ends at back.
+	  * The bytes of the Buffer directly follow it
+	  * in the same block of memory.
+	 **/
+	struct Buffer
+	{
+		/**
+		  * Creates an empty Buffer of the given
+		  * capacity where the content begins at
+		  * the given position
+		 **/
+		Buffer(std::size_t ui_capacity, std::size_t position) :
+			references(1),
+			capacity(ui_capacity),
+			front(position),
+			back(position)
+		{}
+
+		/**
+		  * Copying a Buffer is illegal
+		 **/
+		Buffer(const Buffer &b) = delete;
+
+		/**
+		  * Copying a Buffer is illegal
+		 **/
+		Buffer& operator=(const Buffer &b) = delete;
+
+		/**
+		  * Takes a Buffer with at least the given capacity
+		  * from the pool of the current thread. Buffers
+		  * which are too big for the pool are allocated
+		 **/
+		static Buffer* create(std::size_t capacity, std::size_t position);
+
+		/**
+		  * Gives the Buffer back to the pool
+		  * of the current thread
+		 **/
+		static void destroy(Buffer *buffer);
+
+		/**
+		  * Returns the memory
+		 **/
+		char* bytes()
+		{
+			return reinterpret_cast<char*>(this + 1);
+		}
+
+		/**
+		  * The amount of Packages which use the Buffer
+		 **/
+		std::atomic<unsigned int> references;
+
+		/**
+		  * The amount of bytes. It is never changed
+		 **/
+		const std::size_t capacity;
+
+		/**
+		  * The first byte which is owned by a Package
+		 **/
+		std::atomic<std::size_t> front;
+
+		/**
+		  * The byte after the last one
+		  * which is owned by a Package
+		 **/
+		std::atomic<std::size_t> back;
+
+	}; //end struct Buffer
+
+	/**
+	  * Stops using the Buffer. Afterwards
+	  * the Package is empty
+	 **/
+	void release()
+	{
+		if(buffer && --buffer->references == 0)Buffer::destroy(buffer);
+		buffer = nullptr;
+		dataBegin = inlineHeadroom;
+		dataEnd = inlineHeadroom;
+	}
+
+	/**
+	  * If the Buffer is not shared, all bytes
+	  * outside of the content are free again
+	 **/
+	void releaseUnused()
+	{
+		if(buffer->references != 1)return;
+		buffer->front = dataBegin;
+		buffer->back = dataEnd;
+	}
+
+	/**
+	  * Copies the content into a new Buffer which has
+	  * the given headroom and room for capacity bytes
+	 **/
+	void reallocate(std::size_t headroom, std::size_t capacity)
+	{
+		Buffer *reallocated = Buffer::create(headroom + capacity, headroom);
+		const std::size_t length = getLength();
+		if(length > 0)memcpy(reallocated->bytes() + headroom, getData(), length);
+		reallocated->back = headroom + length;
+
+		release();
+		buffer = reallocated;
+		dataBegin = headroom;
+		dataEnd = headroom + length;
+	}
+
+	/**
+	  * Adds size bytes in front of the content
+	  * and returns where they are
+	 **/
+	char* reserveFront(std::size_t size)
+	{
+		if(!buffer)
+		{
+			if(dataBegin < size)
+			{
+				reallocate(size + defaultHeadroom, getLength());
+				buffer->front = dataBegin - size;
+			}
+		}
+		else
+		{
+			releaseUnused();
+
+			//The bytes in front can only be taken if no
+			//other Package which shares the Buffer owns them
+			std::size_t expected = dataBegin;
+			if(dataBegin < size || !buffer->front.compare_exchange_strong(expected, dataBegin - size))
+			{
+				reallocate(size + defaultHeadroom, getLength());
+				buffer->front = dataBegin - size;
+			}
+		}
+
+		dataBegin -= size;
+		return (buffer ? buffer->bytes() : inlineBytes) + dataBegin;
+	}
+
+	/**
+	  * Adds size bytes after the content
+	  * and returns where they are
+	 **/
+	char* reserveBack(std::size_t size)
+	{
+		if(!buffer)
+		{
+			if(inlineSize - dataEnd < size)
+			{
+				const std::size_t length = getLength();
+				reallocate(defaultHeadroom, std::max(length + size, 2 * length));
+				buffer->back = dataEnd + size;
+			}
+		}
+		else
+		{
+			releaseUnused();
+
+			//The bytes after the content can only be taken if
+			//no other Package which shares the Buffer owns them
+			std::size_t expected = dataEnd;
+			if(buffer->capacity - dataEnd < size || !buffer->back.compare_exchange_strong(expected, dataEnd + size))
+			{
+				const std::size_t length = getLength();
+				reallocate(defaultHeadroom, std::max(length + size, 2 * length));
+				buffer->back = dataEnd + size;
+			}
+		}
+
+		char *position = (buffer ? buffer->bytes() : inlineBytes) + dataEnd;
+		dataEnd += size;
+		return position;
+	}
+
 	/**
 	  * Appends the given object to the Package
 	 **/
 	template <class T>
 	void write_internal(const T &t)
 	{
-		const char *dataToAppend = reinterpret_cast<const char*>(&t);
-		data.insert(data.end(), dataToAppend, dataToAppend + sizeof(T));
+		memcpy(reserveBack(sizeof(T)), &t, sizeof(T));
 	}
 
 	/**
@@ -328,8 +1019,7 @@ private:
 	void write_internal(const T *t, std::size_t size)
 	{
 		if(size <= 0)return;
-		const char *dataToAppend = reinterpret_cast<const char*>(t);
-		data.insert(data.end(), dataToAppend, dataToAppend + (sizeof(T)*size));
+		memcpy(reserveBack(sizeof(T)*size), t, sizeof(T)*size);
 	}
 
 	/**
@@ -352,7 +1042,7 @@ private:
 	bool getAndNext_internal(T *t, std::size_t size) const
 	{
 		bool success = get_internal(t, size);
-		next(size);
+		if(success)iteratorPosition += sizeof(T)*size;
 		return success;
 	}
 
@@ -363,9 +1053,10 @@ private:
 	bool get_internal(T &t) const
 	{
 		std::size_t size = sizeof(T);
-		if(iteratorPosition+size > data.size())return false;
-		const void *tempData = reinterpret_cast<const void*>(&data[iteratorPosition]);
-		t = *reinterpret_cast<const T*>(tempData);
+		if(iteratorPosition+size > getLength())return false;
+
+		//The content is not aligned
+		memcpy(&t, getData() + iteratorPosition, size);
 		return true;
 	}
 
@@ -376,25 +1067,150 @@ private:
 	bool get_internal(T *t, std::size_t size) const
 	{
 		if(size <= 0)return true;
-		if(iteratorPosition+size > data.size())return false;
-		std::copy(&data[iteratorPosition], &data[iteratorPosition+size], reinterpret_cast<char*>(t));
+		if(size > getRemaining() / sizeof(T))return false;
+		memcpy(t, getData() + iteratorPosition, sizeof(T)*size);
 		return true;
 	}
 
 private:
 
 	/**
-	  * The char array where the data are stored
+	  * The memory where the content is stored.
+	  * If it is not set, the content is stored
+	  * in inlineBytes
+	 **/
+	Buffer *buffer;
+
+	/**
+	  * The position of the content in the Buffer
+	 **/
+	std::size_t dataBegin;
+
+	/**
+	  * The position after the content in the Buffer
 	 **/
-	std::vector<char> data;
+	std::size_t dataEnd;
 
 	/**
 	  * The current interator position
 	 **/
 	mutable std::size_t iteratorPosition;
 
+	/**
+	  * The Format of lengths and integers
+	 **/
+	Format format;
+
+	/**
+	  * The memory of small contents
+	 **/
+	char inlineBytes[inlineSize];
+
+	/**
+	  * The Format of the current FormatScope
+	 **/
+	static thread_local Format threadFormat;
+
 }; //end class package
 
+/**
+  * Tells whether objects of the given type are stored
+  * in a Package as their plain bytes, so that arrays of
+  * them can be copied with one memcpy. This is the case
+  * for the basic types. It can be specialized for other
+  * types whose operator<< and operator>> copy their bytes
+ **/
+template <class T>
+struct isBitwiseSerializable : std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T,bool>::value> {};
+
+/**
+  * A view of an array of objects inside of a Package
+  * which is not copied. The content of a Package is not
+  * aligned, so the objects are copied when they are
+  * accessed. It stays valid as long as the Package
+  * exists and is not changed
+ **/
+template <class T>
+class PackageSpan
+{
+
+	static_assert(isBitwiseSerializable<T>::value, "Only bitwise serializable objects can be viewed");
+
+public:
+	/**
+	  * Creates an empty PackageSpan
+	 **/
+	PackageSpan() :
+		bytes(nullptr),
+		count(0)
+	{}
+
+	/**
+	  * Creates a PackageSpan of the given
+	  * amount of objects at the given position
+	 **/
+	PackageSpan(const char *c_bytes, std::size_t ui_count) :
+		bytes(c_bytes),
+		count(ui_count)
+	{}
+
+	/**
+	  * Returns the object at the given index
+	 **/
+	T operator[](std::size_t index) const
+	{
+		T t;
+		memcpy(&t, bytes + index * sizeof(T), sizeof(T));
+		return t;
+	}
+
+	/**
+	  * Returns the amount of objects
+	 **/
+	std::size_t size() const
+	{
+		return count;
+	}
+
+	/**
+	  * Checks whether the PackageSpan is empty
+	 **/
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	/**
+	  * Returns the bytes of the objects
+	 **/
+	const char* data() const
+	{
+		return bytes;
+	}
+
+	/**
+	  * Copies the objects into a vector
+	 **/
+	std::vector<T> toVector() const
+	{
+		std::vector<T> v(count);
+		if(count)memcpy(v.data(), bytes, count * sizeof(T));
+		return v;
+	}
+
+private:
+	/**
+	  * The position of the objects in the Package
+	 **/
+	const char *bytes;
+
+	/**
+	  * The amount of objects
+	 **/
+	std::size_t count;
+
+}; //end class PackageSpan
+
 
 /*-----	Functions for adding data to package	-----*/
 
@@ -429,7 +1245,7 @@ inline void operator<<(Package &p, const T (&t)[N])
 template <>
 inline void operator<<(Package &p, const Package &t)
 {
-	p.write(t.getData(), t.getLength());
+	p.write(t);
 }
 
 /**
@@ -439,24 +1255,43 @@ template <>
 inline void operator<<(Package &p, const std::string &t)
 {
 	const uint64_t size = t.size();
-	p<<size;
+	p.writeLength(size);
 	p.write(t.c_str(), (std::size_t)size);
 }
 
 /**
-  * Adds the given vector to the Package
+  * Adds the elements of the given vector one by one
  **/
 template <class T>
-inline void operator<<(Package &p, const std::vector<T> &t)
+inline void writeElements(Package &p, const std::vector<T> &t, std::false_type)
 {
-	const uint64_t size = t.size();
-	p<<size;
-	for(std::size_t i = 0; i < size; ++i)
+	for(std::size_t i = 0; i < t.size(); ++i)
 	{
 		p<<t[i];
 	}
 }
 
+/**
+  * Adds the elements of the given vector at once
+ **/
+template <class T>
+inline void writeElements(Package &p, const std::vector<T> &t, std::true_type)
+{
+	if(t.empty())return;
+	memcpy(p.extend(t.size() * sizeof(T)), t.data(), t.size() * sizeof(T));
+}
+
+/**
+  * Adds the given vector to the Package
+ **/
+template <class T>
+inline void operator<<(Package &p, const std::vector<T> &t)
+{
+	const uint64_t size = t.size();
+	p.writeLength(size);
+	writeElements(p, t, isBitwiseSerializable<T>());
+}
+
 /**
   * Adds the given list to the Package
  **/
@@ -464,7 +1299,7 @@ template <class T>
 inline void operator<<(Package &p, const std::list<T> &t)
 {
 	const uint64_t size = t.size();
-	p<<size;
+	p.writeLength(size);
 	for(const T &value : t)
 	{
 		p<<value;
@@ -496,18 +1331,39 @@ inline bool operator>>(const Package &p, T &t)
 }
 
 /**
-  * Retrieves the given array from the Package
+  * Retrieves the given amount of objects one by one
  **/
-template <typename T, std::size_t N>
-inline bool operator>>(const Package &p, T(&t)[N])
+template <class T>
+inline bool readElements(const Package &p, T *t, std::size_t size, std::false_type)
 {
-	for(std::size_t i = 0; i < N; i++)
+	for(std::size_t i = 0; i < size; i++)
 	{
 		if(!(p>>t[i]))return false;
 	}
 	return true;
 }
 
+/**
+  * Retrieves the given amount of objects at once
+ **/
+template <class T>
+inline bool readElements(const Package &p, T *t, std::size_t size, std::true_type)
+{
+	const char *bytes;
+	if(!p.viewAndNext(bytes, size * sizeof(T)))return false;
+	if(size)memcpy(t, bytes, size * sizeof(T));
+	return true;
+}
+
+/**
+  * Retrieves the given array from the Package
+ **/
+template <typename T, std::size_t N>
+inline bool operator>>(const Package &p, T(&t)[N])
+{
+	return readElements(p, t, N, isBitwiseSerializable<T>());
+}
+
 /**
   * Retrieves the given size_t from the Package
  **/
@@ -520,7 +1376,7 @@ template <>
 inline bool operator>>(const Package &p, std::string &t)
 {
 	uint64_t size;
-	if(!(p>>size))return false;
+	if(!p.readLength(size))return false;
 	t.resize((std::size_t)size);
 	bool success = p.getAndNext(&t[0], (std::size_t)size);
 	return success;
@@ -533,12 +1389,28 @@ template <class T>
 inline bool operator>>(const Package &p, std::vector<T> &t)
 {
 	uint64_t size;
-	if(!(p>>size))return false;
+	if(!p.readLength(size))return false;
+
+	//The size is checked before any memory is reserved
+	if(isBitwiseSerializable<T>::value && size > p.getRemaining() / sizeof(T))return false;
+
 	t.resize((std::size_t)size);
-	for(unsigned int i = 0; i < size; ++i)
-	{
-		if(!(p>>t[i]))return false;
-	}
+	return readElements(p, t.data(), t.size(), isBitwiseSerializable<T>());
+}
+
+/**
+  * Retrieves a vector from the Package without
+  * copying its elements
+ **/
+template <class T>
+inline bool operator>>(const Package &p, PackageSpan<T> &t)
+{
+	uint64_t size;
+	const char *bytes;
+	if(!p.readLength(size))return false;
+	if(size > p.getRemaining() / sizeof(T))return false;
+	if(!p.viewAndNext(bytes, (std::size_t)size * sizeof(T)))return false;
+	t = PackageSpan<T>(bytes, (std::size_t)size);
 	return true;
 }
 
@@ -549,7 +1421,7 @@ template <class T>
 inline bool operator>>(const Package &p, std::list<T> &t)
 {
 	uint64_t size;
-	if(!(p>>size))return false;
+	if(!p.readLength(size))return false;
 	t.clear();
 	for(unsigned int i = 0; i < size; ++i)
 	{
@@ -9,6 +9,7 @@
 #ifndef ADDRESS_HPP
 #define ADDRESS_HPP
 
+#include <functional>
 #include <string>
 
 namespace cluster
@@ -37,18 +38,15 @@ public:
 /**
   * This class is used to uniquely identify
   * a client in the network. Every protocol
-  * uses its own addresses
+  * uses its own addresses. The Addresses keep
+  * the representation the protocol uses to connect,
+  * the string representation is only created when
+  * it is needed
  **/
 class Address
 {
 
 public:
-	/**
-	  * Constructs an address using its string
-	  * representation
-	 **/
-	Address(const std::string &str_address) : address(str_address) {}
-
 	/**
 	  * Default virtual destructor
 	 **/
@@ -69,10 +67,7 @@ public:
 	  * Returns if the Address is equel to
 	  * the given Address
 	 **/
-	virtual bool operator== (const Address &a) const
-	{
-		return address == a.address;
-	}
+	virtual bool operator== (const Address &a) const = 0;
 
 	/**
 	  * Returns if the Address is equel to
@@ -83,6 +78,18 @@ public:
 		return !((*this) == a);
 	}
 
+	/**
+	  * Returns a hash of the Address. Equal
+	  * Addresses have the same hash
+	 **/
+	virtual std::size_t hash() const = 0;
+
+	/**
+	  * Returns the string representation
+	  * of the Address
+	 **/
+	virtual std::string toString() const = 0;
+
 	/**
 	  * Returns whether the current address
 	  * is a loopback Address. This means that
@@ -91,14 +98,110 @@ public:
 	 **/
 	virtual bool isLoopback() const = 0;
 
+}; // end class Address
+
+/**
+  * An AddressKey is used as key of hash maps which
+  * are indexed by Address. A key which is constructed
+  * from an Address only refers to it, so looking up
+  * an Address doesn't copy it. The copies of a key,
+  * e.g. the ones which are stored in the map, own a
+  * copy of the Address.
+ **/
+class AddressKey
+{
+
 public:
 	/**
-	  * Holds the string representation of the address
+	  * Constructs a key which refers to the given
+	  * Address. The Address needs to stay valid as
+	  * long as the key is used
 	 **/
-	std::string address;
+	explicit AddressKey(const Address &a) :
+		address(&a),
+		owner(false)
+	{}
 
-}; // end class Address
+	/**
+	  * Copy constructor. The copy owns
+	  * a copy of the Address
+	 **/
+	AddressKey(const AddressKey &k) :
+		address(k.address->clone()),
+		owner(true)
+	{}
+
+	/**
+	  * Assignment operator. The key owns
+	  * a copy of the Address
+	 **/
+	AddressKey& operator=(const AddressKey &k)
+	{
+		if(this == &k)return (*this);
+
+		const Address *copy = k.address->clone();
+		if(owner)delete address;
+		address = copy;
+		owner = true;
+		return (*this);
+	}
+
+	/**
+	  * Default destructor
+	 **/
+	~AddressKey()
+	{
+		if(owner)delete address;
+	}
+
+	/**
+	  * Returns if the Addresses of
+	  * the keys are equal
+	 **/
+	bool operator==(const AddressKey &k) const
+	{
+		return (*address) == (*k.address);
+	}
+
+	/**
+	  * Returns the Address of the key
+	 **/
+	const Address& get() const
+	{
+		return (*address);
+	}
+
+private:
+	/**
+	  * The Address of the key
+	 **/
+	const Address *address;
+
+	/**
+	  * A flag whether the key needs
+	  * to delete the Address
+	 **/
+	bool owner;
+
+}; // end class AddressKey
 
 } //end namespace cluster
 
+namespace std
+{
+
+/**
+  * Hashes AddressKeys using the hash of the Address
+ **/
+template <>
+struct hash<cluster::AddressKey>
+{
+	std::size_t operator()(const cluster::AddressKey &k) const
+	{
+		return k.get().hash();
+	}
+};
+
+} //end namespace std
+
 #endif //ADDRESS_HPP
@@ -10,6 +10,7 @@
 #define COMMUNICATIONSOCKET_HPP
 
 #include "address.hpp"
+#include <cluster/framing.hpp>
 
 namespace cluster
 {
@@ -50,14 +51,16 @@ public:
 	  * client with the given Address
 	 **/
 	CommunicationSocket(const Address &a) :
-		address(a.clone())
+		address(a.clone()),
+		maxFrameSize(Framing::defaultMaxFrameSize)
 	{}
 
 	/**
 	  * Copy constructor
 	 **/
 	CommunicationSocket(const CommunicationSocket &c) :
-		address(c.address->clone())
+		address(c.address->clone()),
+		maxFrameSize(c.maxFrameSize)
 	{}
 
 	/**
@@ -67,6 +70,7 @@ public:
 	{
 		delete this->address;
 		this->address = c.address->clone();
+		this->maxFrameSize = c.maxFrameSize;
 		return (*this);
 	}
 
@@ -86,6 +90,24 @@ public:
 		return *address;
 	}
 
+	/**
+	  * Returns the maximum size of a frame
+	  * which is received
+	 **/
+	uint64_t getMaxFrameSize() const
+	{
+		return maxFrameSize;
+	}
+
+	/**
+	  * Sets the maximum size of a frame which is
+	  * received. Larger frames close the connection
+	 **/
+	void setMaxFrameSize(uint64_t ui_maxFrameSize)
+	{
+		this->maxFrameSize = ui_maxFrameSize;
+	}
+
 	/**
 	  * Sends the given Package to the target Address.
 	 **/
@@ -97,12 +119,35 @@ public:
 	 **/
 	virtual bool receive(Package *out) = 0;
 
+	/**
+	  * Checks for the given time in milliseconds if
+	  * there is data waiting to be received
+	 **/
+	virtual bool poll(unsigned int time) = 0;
+
+#ifdef __linux__
+	/**
+	  * Returns the file descriptor of the connection.
+	  * -1 means that the CommunicationSocket has no
+	  * file descriptor.
+	 **/
+	virtual int getDescriptor() const
+	{
+		return -1;
+	}
+#endif //__linux__
+
 protected:
 	/**
 	  * The target address to communicate with
 	 **/
 	const Address *address;
 
+	/**
+	  * The maximum size of a received frame
+	 **/
+	uint64_t maxFrameSize;
+
 }; // end class ListenerSocket
 
 } // end namespace cluster
@@ -67,6 +67,29 @@ public:
 	 **/
 	virtual CommunicationSocket* listen() = 0;
 
+#ifdef __linux__
+	/**
+	  * Returns the file descriptor the ListenerSocket
+	  * is listening on. This is used by the Server to
+	  * wait for connections using epoll. -1 means that
+	  * the ListenerSocket has no file descriptor.
+	 **/
+	virtual int getDescriptor() const
+	{
+		return -1;
+	}
+
+	/**
+	  * Accepts a waiting client connection. The returned
+	  * CommunicationSocket is in non-blocking mode and can
+	  * only be used with its file descriptor.
+	 **/
+	virtual CommunicationSocket* listenNonBlocking()
+	{
+		return nullptr;
+	}
+#endif //__linux__
+
 }; // end class ListenerSocket
 
 } // end namespace cluster
@@ -12,8 +12,10 @@
 #include <cluster/prototypes/address.hpp>
 #include <cluster/prototypes/communicationsocket.hpp>
 #include <cluster/prototypes/listenersocket.hpp>
+#include <cluster/framing.hpp>
 #include <string>
 #include <list>
+#include <vector>
 
 namespace cluster
 {
@@ -31,11 +33,40 @@ class Protocol
 {
 
 public:
+	/**
+	  * Default constructor
+	 **/
+	Protocol() :
+		maxFrameSize(Framing::defaultMaxFrameSize)
+	{}
+
 	/**
 	  * Default destructor
 	 **/
 	virtual ~Protocol() {}
 
+	/**
+	  * Returns the maximum size of a frame which
+	  * is received by the CommunicationSockets
+	  * of the Protocol
+	 **/
+	uint64_t getMaxFrameSize() const
+	{
+		return maxFrameSize;
+	}
+
+	/**
+	  * Sets the maximum size of a frame which is
+	  * received by the CommunicationSockets the
+	  * Protocol creates. A Server uses it for the
+	  * connections it accepts unless it is changed
+	  * with Server::setMaxFrameSize
+	 **/
+	void setMaxFrameSize(uint64_t ui_maxFrameSize)
+	{
+		this->maxFrameSize = ui_maxFrameSize;
+	}
+
 	/**
 	  * This function creates a ListenerSocket
 	  * for the current Protocol
@@ -59,6 +90,36 @@ public:
 	 **/
 	virtual Address* decodeAddress(const std::string &address) const = 0;
 
+	/**
+	  * Adds the Addresses of other members which the
+	  * Protocol can find without scanning an address
+	  * range. Returns false if the Protocol can't
+	  * find members on its own
+	 **/
+	virtual bool discoverAddresses(std::list<Address*> &/*out*/) const
+	{
+		return false;
+	}
+
+	/**
+	  * Checks which of the given Addresses accept connections
+	  * by connecting to many of them at once. reachable is set
+	  * for every Address in the same order. At most concurrency
+	  * connects run at once and each one waits at most timeout
+	  * milliseconds. Returns false if the Protocol can't
+	  * check many Addresses at once
+	 **/
+	virtual bool probeAddresses(const std::vector<const Address*> &/*addresses*/, std::vector<bool> &/*reachable*/, unsigned int /*concurrency*/, unsigned int /*timeout*/) const
+	{
+		return false;
+	}
+
+private:
+	/**
+	  * The maximum size of a received frame
+	 **/
+	uint64_t maxFrameSize;
+
 }; // end class Protocol
 
 } //end namespace cluster
@@ -0,0 +1,195 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef REPLAYLOG_HPP
+#define REPLAYLOG_HPP
+
+#include <vector>
+#include <stdint.h>
+#include <cluster/package.hpp>
+
+namespace cluster
+{
+
+/**
+  * The ReplayLog remembers the last Packages of a
+  * ClusterObjectSerialized together with their
+  * consecutive ids, so that other members can fetch
+  * the Packages they missed. The Packages are stored
+  * in a ring buffer which is indexed by the distance
+  * of an id to the oldest id, so a Package is found
+  * in constant time. The oldest Packages are removed
+  * if there are more than maxPackages Packages or
+  * if they are bigger than maxBytes. The newest
+  * Package is always kept.
+  * The content of the Packages is shared and not
+  * copied. The Digest of every Package is computed
+  * once when it is added.
+ **/
+class ReplayLog
+{
+
+public:
+	/**
+	  * Constructs an empty ReplayLog with the
+	  * given limits
+	 **/
+	ReplayLog(std::size_t maxPackages, std::size_t maxBytes);
+
+	/**
+	  * Adds the Package with the given id. If the id
+	  * doesn't follow the newest id, all remembered
+	  * Packages are removed first
+	 **/
+	void add(unsigned long long id, const Package &p);
+
+	/**
+	  * Adds the Package with the given id and
+	  * its Digest which is already known
+	 **/
+	void add(unsigned long long id, const Package &p, uint32_t digest);
+
+	/**
+	  * Returns the Package with the given id or
+	  * nullptr if it is not remembered
+	 **/
+	const Package* find(unsigned long long id) const;
+
+	/**
+	  * Sets the Digest of the Package with the given id.
+	  * Returns false if the Package is not remembered
+	 **/
+	bool findDigest(unsigned long long id, uint32_t &out) const;
+
+	/**
+	  * Removes all Packages
+	 **/
+	void clear();
+
+	/**
+	  * Checks whether no Package is remembered
+	 **/
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	/**
+	  * Returns the amount of remembered Packages
+	 **/
+	std::size_t size() const
+	{
+		return count;
+	}
+
+	/**
+	  * Returns the size of the remembered
+	  * Packages in bytes
+	 **/
+	std::size_t getBytes() const
+	{
+		return bytes;
+	}
+
+	/**
+	  * Returns the id of the newest Package.
+	  * The ReplayLog must not be empty
+	 **/
+	unsigned long long lastId() const
+	{
+		return base + count - 1;
+	}
+
+	/**
+	  * Returns the newest Package.
+	  * The ReplayLog must not be empty
+	 **/
+	const Package& last() const
+	{
+		return slots[(first + count - 1) % slots.size()];
+	}
+
+	/**
+	  * Returns the id which follows the newest
+	  * Package or 0 if the ReplayLog is empty
+	 **/
+	unsigned long long nextId() const
+	{
+		return empty() ? 0 : base + count;
+	}
+
+	/**
+	  * Sets the limits and removes the
+	  * Packages which exceed them
+	 **/
+	void setLimits(std::size_t ui_maxPackages, std::size_t ui_maxBytes);
+
+private:
+	/**
+	  * Removes the oldest Package
+	 **/
+	void removeFirst();
+
+	/**
+	  * Removes the oldest Packages while
+	  * the limits are exceeded
+	 **/
+	void shrink();
+
+	/**
+	  * Makes room for at least one more Package
+	 **/
+	void grow();
+
+private:
+	/**
+	  * The ring buffer of the Packages
+	 **/
+	std::vector<Package> slots;
+
+	/**
+	  * The Digests of the Packages in the
+	  * same order as the slots
+	 **/
+	std::vector<uint32_t> digests;
+
+	/**
+	  * The slot of the oldest Package
+	 **/
+	std::size_t first;
+
+	/**
+	  * The amount of remembered Packages
+	 **/
+	std::size_t count;
+
+	/**
+	  * The id of the oldest Package
+	 **/
+	unsigned long long base;
+
+	/**
+	  * The size of the remembered Packages in bytes
+	 **/
+	std::size_t bytes;
+
+	/**
+	  * The maximum amount of Packages
+	 **/
+	std::size_t maxPackages;
+
+	/**
+	  * The maximum size of the Packages in bytes
+	 **/
+	std::size_t maxBytes;
+
+}; //end class ReplayLog
+
+} //end namespace cluster
+
+#endif //REPLAYLOG_HPP
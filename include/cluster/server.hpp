@@ -9,20 +9,26 @@
 #ifndef SERVER_HPP
 #define SERVER_HPP
 
+#include <atomic>
 #include <string>
 #include <thread>
-#include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+#include <cluster/package.hpp>
 
 namespace cluster
 {
 
+class Address;
 class Protocol;
-class Package;
 class ListenerSocket;
 class CommunicationSocket;
+class EventLoop;
+class EventConnection;
 
 /**
   * This exception could be thrown from the constructor
@@ -44,19 +50,125 @@ public:
 
 }; // end class ServerException
 
+/**
+  * The metrics of the request queue of a Server.
+  * The wait time of a request is measured from the
+  * moment it was queued until a handler takes it
+ **/
+struct ServerStatistics
+{
+	ServerStatistics() :
+		queued(0),
+		maxQueued(0),
+		accepted(0),
+		rejected(0),
+		handled(0),
+		totalWait(0),
+		maxWait(0)
+	{}
+
+	/**
+	  * Returns the average wait time in microseconds
+	 **/
+	unsigned long long averageWait() const
+	{
+		return handled ? totalWait / handled : 0;
+	}
+
+	/**
+	  * The amount of requests which are waiting
+	 **/
+	std::size_t queued;
+
+	/**
+	  * The highest amount of requests which were waiting
+	 **/
+	std::size_t maxQueued;
+
+	/**
+	  * The amount of requests which were queued
+	 **/
+	unsigned long long accepted;
+
+	/**
+	  * The amount of requests which were rejected
+	  * because the queue was full
+	 **/
+	unsigned long long rejected;
+
+	/**
+	  * The amount of requests which were taken
+	  * by a handler
+	 **/
+	unsigned long long handled;
+
+	/**
+	  * The sum of the wait times in microseconds
+	 **/
+	unsigned long long totalWait;
+
+	/**
+	  * The longest wait time in microseconds
+	 **/
+	unsigned long long maxWait;
+
+}; //end struct ServerStatistics
+
 /**
   * This class is responsible to listen for connections
   * and accept and handle them.
+  * On Linux the connections are handled by EventLoops
+  * using epoll if the ListenerSocket supports it. The
+  * handler threads then only process complete Packages.
+  * Otherwise every connection is handled by one of
+  * the handler threads.
+  * The connections and Packages wait in a bounded queue
+  * for the handler threads. The peers with waiting requests
+  * take turns, so that a single peer can't fill the queue,
+  * and control Packages are handled before all others.
+  * Requests which don't fit are rejected at once: a new
+  * connection is closed and a Package is answered with the
+  * busy answer of the Channel, or a busy frame if it was
+  * sent over a Channel, so that the sender doesn't wait
+  * for the timeout and can try again later.
  **/
 class Server
 {
 
 public:
+#ifdef __linux__
+	/**
+	  * The default amount of EventLoops
+	 **/
+	static const unsigned int defaultEventLoops = 1;
+#else
+	/**
+	  * The default amount of EventLoops
+	 **/
+	static const unsigned int defaultEventLoops = 0;
+#endif //__linux__
+
+	/**
+	  * The default amount of requests which can wait
+	 **/
+	static const std::size_t defaultMaxQueued = 1024;
+
+	/**
+	  * The default amount of requests of
+	  * a single peer which can wait
+	 **/
+	static const std::size_t defaultMaxQueuedPerPeer = 256;
+
 	/**
 	  * Constructs a Server using the given protocol.
+	  * A connection is kept open for further requests
+	  * until it was idle for idleTimeout seconds.
+	  * The connections are handled by the given amount
+	  * of EventLoops. 0 means that every connection is
+	  * handled by a thread.
 	  * Throws ServerException if the listener can not be bound
 	 **/
-	Server(const Protocol &protocol);
+	Server(const Protocol &protocol, unsigned int idleTimeout=10, unsigned int eventLoopsCount=defaultEventLoops);
 
 	/**
 	  * Default destructor
@@ -72,6 +184,79 @@ public:
 		this->callback = fn_callback;
 	}
 
+	/**
+	  * Registers the given function as callback which
+	  * is called for every Package received over a Channel.
+	  * The answer is sent back with the correlation id of
+	  * the request and the Package stored in send is sent
+	  * back over the same connection. If this callback is
+	  * not set, the Packages of a Channel are passed to the
+	  * callback which is set with setCallback.
+	 **/
+	void setChannelCallback(std::function<void(const Address &from, const Package &data, Package &answer, Package &send)> fn_channelCallback)
+	{
+		this->channelCallback = fn_channelCallback;
+	}
+
+	/**
+	  * Registers the given function which decides whether
+	  * a Package is control traffic. Control Packages are
+	  * handled before all other requests and may still
+	  * be queued if the queue is full
+	 **/
+	void setPriorityCallback(std::function<bool(const Package &data)> fn_priorityCallback)
+	{
+		this->priorityCallback = fn_priorityCallback;
+	}
+
+	/**
+	  * Sets the amount of requests which can wait in total
+	  * and the amount of requests of a single peer
+	 **/
+	void setQueueLimits(std::size_t maxQueued, std::size_t maxQueuedPerPeer);
+
+	/**
+	  * Returns the metrics of the request queue
+	 **/
+	ServerStatistics getStatistics() const;
+
+	/**
+	  * Gets the time in seconds after which an idle
+	  * connection is closed
+	 **/
+	unsigned int getIdleTimeout() const
+	{
+		return idleTimeout;
+	}
+
+	/**
+	  * Sets the time in seconds after which an idle
+	  * connection is closed
+	 **/
+	void setIdleTimeout(unsigned int ui_idleTimeout)
+	{
+		this->idleTimeout = ui_idleTimeout;
+	}
+
+	/**
+	  * Returns the maximum size of a frame which is
+	  * received on the accepted connections
+	 **/
+	uint64_t getMaxFrameSize() const
+	{
+		return maxFrameSize;
+	}
+
+	/**
+	  * Sets the maximum size of a frame which is received
+	  * on connections which are accepted afterwards. It
+	  * is the one of the Protocol by default
+	 **/
+	void setMaxFrameSize(uint64_t ui_maxFrameSize)
+	{
+		this->maxFrameSize = ui_maxFrameSize;
+	}
+
 private:
 	/**
 	  * Copying a Server is illegal
@@ -100,10 +285,112 @@ private:
 	void serverFunction();
 
 	/**
-	  * Handles the next connection in the queue
+	  * Returns whether the connections are handled
+	  * by EventLoops
+	 **/
+	bool usesEventLoops() const
+	{
+#ifdef __linux__
+		return !eventLoops.empty();
+#else
+		return false;
+#endif //__linux__
+	}
+
+	/**
+	  * A connection or Package which waits to be handled
+	 **/
+	struct Request;
+
+	/**
+	  * The bounded queue of the Requests
+	 **/
+	struct RequestQueue;
+
+	/**
+	  * Checks whether the given Package is control
+	  * traffic. channel tells whether it is a frame
+	  * of a Channel
+	 **/
+	bool isControl(const Package &data, bool channel) const;
+
+	/**
+	  * Adds the given Request of the given peer to the
+	  * queue and notifies a handler thread. Returns false
+	  * if it was rejected because the queue is full
+	 **/
+	bool enqueue(const Address &from, const Request &request, bool control);
+
+	/**
+	  * Returns the busy frame which is sent if the
+	  * given frame of a Channel is rejected. It is
+	  * empty if nothing needs to be sent
+	 **/
+	static Package busyFrame(const Package &frame);
+
+	/**
+	  * Handles the next connection or Package in the queue
 	 **/
 	void handle();
 
+	/**
+	  * Handles all requests of the given connection
+	 **/
+	void handleConnection(CommunicationSocket *client);
+
+	/**
+	  * A connection which became a Channel while
+	  * the Server doesn't use EventLoops
+	 **/
+	struct ChannelConnection;
+
+	/**
+	  * Reads the frames of the given Channel and adds
+	  * them to the queue, so that the handler threads
+	  * handle them at the same time. Otherwise a request
+	  * which waits for another member would block all
+	  * other requests of the Channel.
+	 **/
+	void readChannel(std::shared_ptr<ChannelConnection> connection);
+
+	/**
+	  * Handles the given frame which was received over a
+	  * Channel while the Server doesn't use EventLoops
+	 **/
+	void handleChannelConnectionFrame(const std::shared_ptr<ChannelConnection> &connection, const Package &frame);
+
+	/**
+	  * Waits for the threads which read the Channels
+	  * that are closed. If all is set, it waits for
+	  * the threads of all Channels
+	 **/
+	void joinChannelReaders(bool all);
+
+	/**
+	  * Handles the given frame which was received over
+	  * a Channel. The frame which needs to be sent as
+	  * answer is stored in answer and the message frame
+	  * which needs to be sent is stored in send.
+	  * compression is set once the other side offered
+	  * the Compression and the frames are compressed
+	  * afterwards
+	 **/
+	void handleChannelFrame(const Address &from, const Package &frame, std::atomic<bool> &compression, Package &answer, Package &send);
+
+#ifdef __linux__
+	/**
+	  * Adds the given Package which was received by
+	  * an EventLoop to the queue
+	 **/
+	void dispatch(const std::shared_ptr<EventConnection> &connection, const Package &data);
+
+	/**
+	  * Handles the given Package which was received
+	  * by an EventLoop and sends the answer
+	 **/
+	void handleEvent(const std::shared_ptr<EventConnection> &connection, const Package &data);
+#endif //__linux__
+
 private:
 	/**
 	  * Determines the amount of threads to handle
@@ -112,6 +399,30 @@ private:
 	 **/
 	static const unsigned int handlersCount = 20;
 
+	/**
+	  * The interval in milliseconds in which an idle
+	  * connection is checked for new requests
+	 **/
+	static const unsigned int idlePollInterval = 100;
+
+	/**
+	  * The amount of control Packages which can
+	  * wait in addition if the queue is full
+	 **/
+	static const std::size_t controlReserve = 64;
+
+	/**
+	  * The time in seconds after which an idle
+	  * connection is closed
+	 **/
+	unsigned int idleTimeout;
+
+	/**
+	  * The maximum size of a frame which is
+	  * received on the accepted connections
+	 **/
+	std::atomic<uint64_t> maxFrameSize;
+
 	/**
 	  * A flag which is used to manage the running status
 	 **/
@@ -135,6 +446,18 @@ private:
 	 **/
 	std::function<void(const Address &from, const Package &data, Package &answer)> callback;
 
+	/**
+	  * The callback function which is called for
+	  * every Package received over a Channel
+	 **/
+	std::function<void(const Address &from, const Package &data, Package &answer, Package &send)> channelCallback;
+
+	/**
+	  * The callback function which decides whether
+	  * a Package is control traffic
+	 **/
+	std::function<bool(const Package &data)> priorityCallback;
+
 	/**
 	  * The listener thread
 	 **/
@@ -146,25 +469,41 @@ private:
 	std::thread *answerThread[handlersCount];
 
 	/**
-	  * The communication sockets which need to be handled
+	  * The connections and Packages which
+	  * need to be handled
 	 **/
-	std::queue<CommunicationSocket*> requests;
+	RequestQueue *requests;
 
 	/**
-	  * Allows paralled access to the requests queue
+	  * The Channels which are read by their own thread
+	  * while the Server doesn't use EventLoops
 	 **/
-	std::mutex m;
+	std::list<std::shared_ptr<ChannelConnection> > channels;
 
+#ifdef __linux__
 	/**
-	  * The condition variable which is used to notify the threads
-	  * to accept connections
+	  * The EventLoops which handle the connections
 	 **/
-	std::condition_variable cv;
+	std::vector<EventLoop*> eventLoops;
+
+	/**
+	  * The index of the EventLoop which gets
+	  * the next accepted connection
+	 **/
+	unsigned int nextEventLoop;
+#endif //__linux__
 
 	/**
-	  * The mutext which is needed for the threads to wait.
+	  * Allows paralled access to the requests
+	  * queue and the Channels
 	 **/
-	std::mutex cm;
+	mutable std::mutex m;
+
+	/**
+	  * The condition variable which is used to notify
+	  * the threads that requests are waiting
+	 **/
+	std::condition_variable cv;
 
 };
 
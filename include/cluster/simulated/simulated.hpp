@@ -0,0 +1,130 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef SIMULATED_HPP
+#define SIMULATED_HPP
+
+#include <cluster/prototypes/protocol.hpp>
+#include <cluster/simulated/simulatednetwork.hpp>
+#include <cluster/simulated/simulatedaddress.hpp>
+#include <cluster/simulated/simulatedcommunicationsocket.hpp>
+#include <cluster/simulated/simulatedlistenersocket.hpp>
+#include <list>
+#include <string>
+
+namespace cluster
+{
+
+/**
+  * This class represents a Protocol for members which
+  * run in the same process and are connected by a
+  * SimulatedNetwork. Every member has a name and finds
+  * the other members of the SimulatedNetwork on its
+  * own, so no address range needs to be scanned.
+ **/
+class Simulated : public Protocol
+{
+
+public:
+	/**
+	  * Constructs a Simulated Protocol for the member
+	  * with the given name in the given network. The
+	  * timeout is the time in seconds a Package is
+	  * waited for, and the listen backlog is the amount
+	  * of connections which are remembered before they
+	  * are accepted
+	 **/
+	Simulated(SimulatedNetwork &network, const std::string &name, unsigned int timeout=10, unsigned int listenBacklog=50);
+
+	/**
+	  * Creates a Simulated ListenerSocket
+	 **/
+	virtual ListenerSocket* createListenerSocket() const override;
+
+	/**
+	  * Creates a Simulated CommunicationSocket to
+	  * communicate with the given Address
+	 **/
+	virtual CommunicationSocket* createCommunicationSocket(const Address &address) const override;
+
+	/**
+	  * Returns the name of the current member
+	 **/
+	virtual void getAddresses(std::list<Address*> &out) const override;
+
+	/**
+	  * Converts the given Address in string representation
+	  * to a SimulatedAddress
+	 **/
+	virtual Address* decodeAddress(const std::string &address) const override;
+
+	/**
+	  * Returns the names of the listening members
+	  * of the SimulatedNetwork
+	 **/
+	virtual bool discoverAddresses(std::list<Address*> &out) const override;
+
+	/**
+	  * Returns the network the member belongs to
+	 **/
+	SimulatedNetwork& getNetwork() const
+	{
+		return network;
+	}
+
+	/**
+	  * Returns the name of the current member
+	 **/
+	const std::string& getName() const
+	{
+		return name;
+	}
+
+	/**
+	  * Gets the time in seconds a Package is waited for
+	 **/
+	unsigned int getTimeout() const
+	{
+		return timeout;
+	}
+
+	/**
+	  * Sets the time in seconds a Package is waited for
+	 **/
+	void setTimeout(unsigned int ui_timeout)
+	{
+		this->timeout = ui_timeout;
+	}
+
+private:
+	/**
+	  * The network the member belongs to
+	 **/
+	SimulatedNetwork &network;
+
+	/**
+	  * The name of the current member
+	 **/
+	std::string name;
+
+	/**
+	  * The time in seconds a Package is waited for
+	 **/
+	unsigned int timeout;
+
+	/**
+	  * The amount of connections which are
+	  * remembered before they are accepted
+	 **/
+	unsigned int listenBacklog;
+
+}; // end class Simulated
+
+} //end namespace cluster
+
+#endif //SIMULATED_HPP
@@ -0,0 +1,79 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef SIMULATEDADDRESS_HPP
+#define SIMULATEDADDRESS_HPP
+
+#include <cluster/prototypes/address.hpp>
+
+namespace cluster
+{
+
+/**
+  * This class represents the Address of a
+  * member in a SimulatedNetwork which is
+  * the name of the member
+ **/
+class SimulatedAddress : public Address
+{
+
+public:
+	/**
+	  * Constructs an address using the name
+	  * of the member which must not be empty
+	 **/
+	SimulatedAddress(const std::string &name);
+
+	/**
+	  * Creates a copy of the Address
+	 **/
+	virtual Address* clone() const override;
+
+	/**
+	  * Increases the number at the end of the name,
+	  * e.g. node9 becomes node10. If the name doesn't
+	  * end with a number, 1 is appended.
+	 **/
+	virtual void increase() override;
+
+	/**
+	  * Every name belongs to a different member.
+	  * Therefore no SimulatedAddress is a
+	  * loopback Address
+	 **/
+	virtual bool isLoopback() const override;
+
+	/**
+	  * Compares the names of the Addresses
+	 **/
+	virtual bool operator== (const Address &a) const override;
+
+	/**
+	  * Returns a hash of the name
+	 **/
+	virtual std::size_t hash() const override;
+
+	/**
+	  * Returns the name of the member
+	 **/
+	virtual std::string toString() const override
+	{
+		return name;
+	}
+
+protected:
+	/**
+	  * The name of the member
+	 **/
+	std::string name;
+
+}; // end class SimulatedAddress
+
+} // end namespace cluster
+
+#endif //SIMULATEDADDRESS_HPP
@@ -0,0 +1,91 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef SIMULATEDCOMMUNICATIONSOCKET_HPP
+#define SIMULATEDCOMMUNICATIONSOCKET_HPP
+
+#include <cluster/prototypes/communicationsocket.hpp>
+#include <memory>
+
+namespace cluster
+{
+
+class SimulatedAddress;
+class SimulatedPipe;
+
+/**
+  * This class is used to communicate with another
+  * member of a SimulatedNetwork. It uses one
+  * SimulatedPipe for each direction.
+ **/
+class SimulatedCommunicationSocket : public CommunicationSocket
+{
+
+public:
+	/**
+	  * Creates a communication socket to the member
+	  * with the given Address which receives from in
+	  * and sends to out. A Package is waited for at
+	  * most timeout seconds
+	 **/
+	SimulatedCommunicationSocket(const SimulatedAddress &memberAddress, std::shared_ptr<SimulatedPipe> in, std::shared_ptr<SimulatedPipe> out, unsigned int timeout);
+
+	/**
+	  * Default destructor. Closes the connection
+	 **/
+	virtual ~SimulatedCommunicationSocket();
+
+	/**
+	  * Sends the given Package to the target Address.
+	 **/
+	virtual bool send(const Package &data) override;
+
+	/**
+	  * Receives a Package from the target Address
+	  * and stores is in out.
+	 **/
+	virtual bool receive(Package *out) override;
+
+	/**
+	  * Checks for the given time in milliseconds if
+	  * there is data waiting to be received
+	 **/
+	virtual bool poll(unsigned int time) override;
+
+private:
+	/**
+	  * Copying a SimulatedCommunicationSocket is illegal
+	 **/
+	SimulatedCommunicationSocket(const SimulatedCommunicationSocket &c);
+
+	/**
+	  * Copying a SimulatedCommunicationSocket is illegal
+	 **/
+	SimulatedCommunicationSocket& operator=(const SimulatedCommunicationSocket &c);
+
+private:
+	/**
+	  * The pipe from the other member
+	 **/
+	std::shared_ptr<SimulatedPipe> in;
+
+	/**
+	  * The pipe to the other member
+	 **/
+	std::shared_ptr<SimulatedPipe> out;
+
+	/**
+	  * The time in seconds a Package is waited for
+	 **/
+	unsigned int timeout;
+
+}; // end class SimulatedCommunicationSocket
+
+} // end namespace cluster
+
+#endif //SIMULATEDCOMMUNICATIONSOCKET_HPP
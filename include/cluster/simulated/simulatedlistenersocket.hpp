@@ -0,0 +1,100 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef SIMULATEDLISTENERSOCKET_HPP
+#define SIMULATEDLISTENERSOCKET_HPP
+
+#include <cluster/prototypes/listenersocket.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <string>
+
+namespace cluster
+{
+
+class CommunicationSocket;
+class SimulatedNetwork;
+
+/**
+  * This class listens for connections of other
+  * members of a SimulatedNetwork.
+ **/
+class SimulatedListenerSocket : public ListenerSocket
+{
+
+public:
+	/**
+	  * Creates a listener socket with the given name
+	  * in the given SimulatedNetwork. The listenBacklog
+	  * defines how many connections are stored before
+	  * they are accepted.
+	 **/
+	SimulatedListenerSocket(SimulatedNetwork &network, const std::string &name, unsigned int listenBacklog);
+
+	/**
+	  * Default destructor
+	 **/
+	virtual ~SimulatedListenerSocket();
+
+	/**
+	  * Cheks for the given timesout if a
+	  * client is waiting for a connection.
+	 **/
+	virtual bool poll(unsigned int time) override;
+
+	/**
+	  * Accepts the client connection. Doesn't
+	  * return until the connection is established
+	 **/
+	virtual CommunicationSocket* listen() override;
+
+	/**
+	  * Called by the SimulatedNetwork when another
+	  * member connects. Returns false if too many
+	  * connections are waiting
+	 **/
+	bool connected(CommunicationSocket *socket);
+
+private:
+	/**
+	  * The network the member belongs to
+	 **/
+	SimulatedNetwork &network;
+
+	/**
+	  * The name of the member
+	 **/
+	std::string name;
+
+	/**
+	  * The amount of connections which are
+	  * stored before they are accepted
+	 **/
+	unsigned int listenBacklog;
+
+	/**
+	  * The connections which were not accepted yet
+	 **/
+	std::queue<CommunicationSocket*> waiting;
+
+	/**
+	  * Allows parallel access to waiting
+	 **/
+	std::mutex m;
+
+	/**
+	  * Notifies about new connections
+	 **/
+	std::condition_variable cv;
+
+}; // end class SimulatedListenerSocket
+
+} // end namespace cluster
+
+#endif //SIMULATEDLISTENERSOCKET_HPP
@@ -0,0 +1,287 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef SIMULATEDNETWORK_HPP
+#define SIMULATEDNETWORK_HPP
+
+#include <cluster/package.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <stdint.h>
+
+namespace cluster
+{
+
+class SimulatedNetwork;
+class SimulatedListenerSocket;
+class SimulatedCommunicationSocket;
+
+/**
+  * The properties of the link from one member
+  * of a SimulatedNetwork to another one
+ **/
+struct SimulatedLink
+{
+
+	/**
+	  * Creates a link with the given properties
+	 **/
+	SimulatedLink(unsigned int ui_latency=0, uint64_t ui_bandwidth=0, double d_dropRate=0) :
+		latency(ui_latency),
+		bandwidth(ui_bandwidth),
+		dropRate(d_dropRate)
+	{}
+
+	/**
+	  * The time in microseconds a Package
+	  * needs to reach the other member
+	 **/
+	unsigned int latency;
+
+	/**
+	  * The amount of bytes per second which can be
+	  * sent over the link. 0 means unlimited
+	 **/
+	uint64_t bandwidth;
+
+	/**
+	  * The probability between 0 and 1
+	  * that a Package is lost
+	 **/
+	double dropRate;
+
+}; //end struct SimulatedLink
+
+/**
+  * A SimulatedPipe is one direction of a connection
+  * in a SimulatedNetwork. The Packages which are sent
+  * can only be received after the time the link needs
+  * to transmit them.
+ **/
+class SimulatedPipe
+{
+
+public:
+	/**
+	  * Creates a pipe from one member to another one
+	 **/
+	SimulatedPipe(SimulatedNetwork &network, const std::string &from, const std::string &to);
+
+	/**
+	  * Sends the given Package. Returns false if the
+	  * pipe is closed. A Package which is lost on
+	  * the link still counts as sent.
+	 **/
+	bool send(const Package &data);
+
+	/**
+	  * Waits for at most timeout seconds for a Package
+	  * and appends it to out
+	 **/
+	bool receive(Package *out, unsigned int timeout);
+
+	/**
+	  * Checks for the given time in milliseconds if
+	  * a Package can be received or the pipe was closed
+	 **/
+	bool poll(unsigned int time);
+
+	/**
+	  * Closes the pipe. The Packages which were
+	  * already sent can still be received.
+	 **/
+	void close();
+
+private:
+	/**
+	  * The clock which is used for the transmission times
+	 **/
+	typedef std::chrono::steady_clock Clock;
+
+	/**
+	  * Waits until a Package can be received, the pipe is
+	  * closed or the deadline is reached. Returns false
+	  * if the deadline was reached
+	 **/
+	bool wait(std::unique_lock<std::mutex> &lock, Clock::time_point deadline);
+
+private:
+	/**
+	  * The network the pipe belongs to
+	 **/
+	SimulatedNetwork &network;
+
+	/**
+	  * The name of the sending member
+	 **/
+	std::string from;
+
+	/**
+	  * The name of the receiving member
+	 **/
+	std::string to;
+
+	/**
+	  * The Packages together with the time
+	  * they arrive at the other member
+	 **/
+	std::queue<std::pair<Clock::time_point,Package> > packages;
+
+	/**
+	  * The time until which the link is busy
+	  * with transmitting the previous Packages
+	 **/
+	Clock::time_point nextFree;
+
+	/**
+	  * A flag whether the pipe is closed
+	 **/
+	bool closed;
+
+	/**
+	  * Allows parallel access to the pipe
+	 **/
+	std::mutex m;
+
+	/**
+	  * Notifies the receiver about new Packages
+	 **/
+	std::condition_variable cv;
+
+}; //end class SimulatedPipe
+
+/**
+  * A SimulatedNetwork connects many members of
+  * the Simulated Protocol within one process. No
+  * real network is used. The links between the
+  * members can be slowed down, lose Packages or
+  * be cut by partitions. This makes it possible
+  * to test and benchmark many members on one
+  * computer.
+  * The SimulatedNetwork needs to exist longer
+  * than all Protocols which use it.
+ **/
+class SimulatedNetwork
+{
+
+public:
+	/**
+	  * Creates a SimulatedNetwork. The seed is used for
+	  * deciding which Packages are lost, so runs with
+	  * the same seed lose the same Packages as long as
+	  * they are sent in the same order
+	 **/
+	SimulatedNetwork(uint32_t seed=0);
+
+	/**
+	  * Sets the properties of all links which
+	  * were not set using setLink
+	 **/
+	void setDefaultLink(const SimulatedLink &link);
+
+	/**
+	  * Sets the properties of the link from one
+	  * member to another one. The link back
+	  * needs to be set separately.
+	 **/
+	void setLink(const std::string &from, const std::string &to, const SimulatedLink &link);
+
+	/**
+	  * Moves the given member into the given partition.
+	  * Members in different partitions can't connect to
+	  * each other and all Packages between them are lost.
+	  * All members start in partition 0.
+	 **/
+	void setPartition(const std::string &name, unsigned int partition);
+
+	/**
+	  * Moves all members back into partition 0
+	 **/
+	void heal();
+
+	/**
+	  * Registers a ListenerSocket with the given name.
+	  * Returns false if the name is already in use
+	 **/
+	bool addListener(const std::string &name, SimulatedListenerSocket *listener);
+
+	/**
+	  * Removes the ListenerSocket with the given name
+	 **/
+	void removeListener(const std::string &name);
+
+	/**
+	  * Connects the member with the given name to
+	  * the listening member. Returns nullptr if nobody
+	  * listens with that name or it can't be reached.
+	 **/
+	SimulatedCommunicationSocket* connect(const std::string &from, const std::string &to, unsigned int timeout);
+
+	/**
+	  * Returns the names of the listening members
+	 **/
+	void getNames(std::list<std::string> &out) const;
+
+	/**
+	  * Decides whether a Package which is sent from one member
+	  * to another one arrives and returns the properties of
+	  * the link
+	 **/
+	bool transmit(const std::string &from, const std::string &to, SimulatedLink &link);
+
+private:
+	/**
+	  * Checks whether both members are in the
+	  * same partition. m needs to be locked
+	 **/
+	bool isReachable(const std::string &from, const std::string &to) const;
+
+private:
+	/**
+	  * Allows parallel access to the network
+	 **/
+	mutable std::mutex m;
+
+	/**
+	  * The properties of the links which
+	  * were not set using setLink
+	 **/
+	SimulatedLink defaultLink;
+
+	/**
+	  * The properties of the links which were set
+	 **/
+	std::map<std::pair<std::string,std::string>,SimulatedLink> links;
+
+	/**
+	  * The partitions of the members which
+	  * are not in partition 0
+	 **/
+	std::map<std::string,unsigned int> partitions;
+
+	/**
+	  * The listening members
+	 **/
+	std::map<std::string,SimulatedListenerSocket*> listeners;
+
+	/**
+	  * Decides which Packages are lost
+	 **/
+	std::mt19937 random;
+
+}; //end class SimulatedNetwork
+
+} //end namespace cluster
+
+#endif //SIMULATEDNETWORK_HPP
@@ -0,0 +1,152 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef UNIXDOMAIN_HPP
+#define UNIXDOMAIN_HPP
+
+#include <cluster/prototypes/protocol.hpp>
+#include <cluster/unixdomain/unixdomainaddress.hpp>
+#include <cluster/unixdomain/unixdomaincommunicationsocket.hpp>
+#include <cluster/unixdomain/unixdomainlistenersocket.hpp>
+#include <list>
+#include <string>
+
+namespace cluster
+{
+
+/**
+  * This class represents a Protocol for members which
+  * run on the same computer. It uses unix domain stream
+  * sockets which avoid the TCP stack. Every member has
+  * a name and creates a socket file with this name in
+  * a directory which is shared by all members. The
+  * other members are found by reading this directory,
+  * so no address range needs to be scanned.
+  * The UnixDomain Protocol is only available on Linux.
+ **/
+class UnixDomain : public Protocol
+{
+
+public:
+	/**
+	  * Constructs a UnixDomain Protocol for the member
+	  * with the given name which uses the given directory.
+	  * It is also possible to set the timeout for a
+	  * connection to be accepted and the listen backlog
+	  * which is the amount of connections which should
+	  * be rememebred before they are accepted
+	 **/
+	UnixDomain(const std::string &directory, const std::string &name, unsigned int timeout=10, unsigned int listenBacklog=50);
+
+	/**
+	  * Creates a UnixDomain ListenerSocket
+	 **/
+	virtual ListenerSocket* createListenerSocket() const override;
+
+	/**
+	  * Creates a UnixDomain CommunicationSocket to
+	  * communicate with the given Address which must
+	  * be a UnixDomainAddress
+	 **/
+	virtual CommunicationSocket* createCommunicationSocket(const Address &address) const override;
+
+	/**
+	  * Returns the name of the current member
+	 **/
+	virtual void getAddresses(std::list<Address*> &out) const override;
+
+	/**
+	  * Converts the given Address in string representation
+	  * to a UnixDomainAddress
+	 **/
+	virtual Address* decodeAddress(const std::string &address) const override;
+
+	/**
+	  * Returns the names of the socket files in
+	  * the directory
+	 **/
+	virtual bool discoverAddresses(std::list<Address*> &out) const override;
+
+	/**
+	  * Returns the directory which contains
+	  * the socket files
+	 **/
+	const std::string& getDirectory() const
+	{
+		return directory;
+	}
+
+	/**
+	  * Returns the name of the current member
+	 **/
+	const std::string& getName() const
+	{
+		return name;
+	}
+
+	/**
+	  * Gets the timeout for establishing a connection
+	 **/
+	unsigned int getTimeout() const
+	{
+		return timeout;
+	}
+
+	/**
+	  * Sets the timeout for establishing a connection
+	 **/
+	void setTimeout(unsigned int ui_timeout)
+	{
+		this->timeout = ui_timeout;
+	}
+
+	/**
+	  * Gets the amount of connections which
+	  * are remembered before they are accepted
+	 **/
+	unsigned int getListenBacklog() const
+	{
+		return listenBacklog;
+	}
+
+	/**
+	  * Sets the amount of connections which
+	  * are remembered before they are accepted
+	 **/
+	void setListenBacklog(unsigned int ui_listenBacklog)
+	{
+		this->listenBacklog = ui_listenBacklog;
+	}
+
+private:
+	/**
+	  * The directory which contains the socket files
+	 **/
+	std::string directory;
+
+	/**
+	  * The name of the current member
+	 **/
+	std::string name;
+
+	/**
+	  * The timeout for establishing a connection
+	 **/
+	unsigned int timeout;
+
+	/**
+	  * The amount of connections which are
+	  * remembered before they are accepted
+	 **/
+	unsigned int listenBacklog;
+
+}; // end class UnixDomain
+
+} //end namespace cluster
+
+#endif //UNIXDOMAIN_HPP
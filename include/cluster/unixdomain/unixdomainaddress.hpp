@@ -0,0 +1,89 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef UNIXDOMAINADDRESS_HPP
+#define UNIXDOMAINADDRESS_HPP
+
+#include <cluster/prototypes/address.hpp>
+
+namespace cluster
+{
+
+/**
+  * This class represents the Address of a member
+  * which uses the UnixDomain Protocol. The Address
+  * is the name of the member which is also the name
+  * of its socket file in the directory of the Protocol.
+ **/
+class UnixDomainAddress : public Address
+{
+
+public:
+	/**
+	  * Constructs an address using the name of
+	  * the member. The name must not be empty,
+	  * must not contain a '/' and must not start
+	  * with a '.'
+	 **/
+	UnixDomainAddress(const std::string &name);
+
+	/**
+	  * Creates a copy of the Address
+	 **/
+	virtual Address* clone() const override;
+
+	/**
+	  * Increases the number at the end of the name,
+	  * e.g. node9 becomes node10. If the name doesn't
+	  * end with a number, 1 is appended.
+	 **/
+	virtual void increase() override;
+
+	/**
+	  * All members of the UnixDomain Protocol are on
+	  * the current computer, but every name belongs to
+	  * a different member. Therefore no UnixDomainAddress
+	  * is a loopback Address
+	 **/
+	virtual bool isLoopback() const override;
+
+	/**
+	  * Compares the names of the Addresses
+	 **/
+	virtual bool operator== (const Address &a) const override;
+
+	/**
+	  * Returns a hash of the name
+	 **/
+	virtual std::size_t hash() const override;
+
+	/**
+	  * Returns the name of the member
+	 **/
+	virtual std::string toString() const override
+	{
+		return name;
+	}
+
+	/**
+	  * Checks whether the given name can be used
+	  * as UnixDomainAddress
+	 **/
+	static bool isValid(const std::string &name);
+
+protected:
+	/**
+	  * The name of the member
+	 **/
+	std::string name;
+
+}; // end class UnixDomainAddress
+
+} // end namespace cluster
+
+#endif //UNIXDOMAINADDRESS_HPP
@@ -0,0 +1,119 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef UNIXDOMAINCOMMUNICATIONSOCKET_HPP
+#define UNIXDOMAINCOMMUNICATIONSOCKET_HPP
+
+#include <cluster/prototypes/communicationsocket.hpp>
+#include <string>
+
+namespace cluster
+{
+
+class UnixDomainAddress;
+
+/**
+  * This class is used to communicate with another
+  * member on the same computer using a unix domain
+  * stream socket.
+ **/
+class UnixDomainCommunicationSocket : public CommunicationSocket
+{
+
+public:
+	/**
+	  * Every connecting socket is bound to an abstract
+	  * name which starts with this prefix followed by
+	  * the name of the member. This way the ListenerSocket
+	  * knows who connected.
+	 **/
+	static const char clientPrefix[];
+
+	/**
+	  * Creates a communication socket to the
+	  * member with the given Address. This constructor
+	  * can be called when the connection was already
+	  * established before.
+	 **/
+	UnixDomainCommunicationSocket(const UnixDomainAddress &memberAddress, int fd_client, unsigned int timeout);
+
+	/**
+	  * Creates a communication socket to the member
+	  * with the given Address whose socket file is in
+	  * the given directory. ownName is the name of
+	  * the current member.
+	 **/
+	UnixDomainCommunicationSocket(const UnixDomainAddress &memberAddress, const std::string &directory, const std::string &ownName, unsigned int timeout);
+
+	/**
+	  * Copy constructor
+	 **/
+	UnixDomainCommunicationSocket(const UnixDomainCommunicationSocket &c);
+
+	/**
+	  * Assignment operator
+	 **/
+	UnixDomainCommunicationSocket& operator=(const UnixDomainCommunicationSocket &c);
+
+	/**
+	  * Default destructor
+	 **/
+	virtual ~UnixDomainCommunicationSocket();
+
+	/**
+	  * Sends the given Package to the target Address.
+	 **/
+	virtual bool send(const Package &data) override;
+
+	/**
+	  * Receives a Package from the target Address
+	  * and stores is in out.
+	 **/
+	virtual bool receive(Package *out) override;
+
+	/**
+	  * Checks for the given time in milliseconds if
+	  * there is data waiting to be received
+	 **/
+	virtual bool poll(unsigned int time) override;
+
+#ifdef __linux__
+	/**
+	  * Returns the file descriptor of the connection
+	 **/
+	virtual int getDescriptor() const override
+	{
+		return fd_client;
+	}
+#endif //__linux__
+
+private:
+	/**
+	  * Closes the socket if this is the last
+	  * UnixDomainCommunicationSocket using it
+	 **/
+	void release();
+
+private:
+	/**
+	  * The file descriptor which is used by the socket
+	 **/
+	int fd_client;
+
+	/**
+	  * This variable is used for the copy constructor
+	  * and assignment operator to keep the socket open
+	  * until all communication sockets are closed
+	 **/
+	int *counter;
+
+}; // end class UnixDomainCommunicationSocket
+
+} // end namespace cluster
+
+#endif //UNIXDOMAINCOMMUNICATIONSOCKET_HPP
@@ -0,0 +1,121 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef UNIXDOMAINLISTENERSOCKET_HPP
+#define UNIXDOMAINLISTENERSOCKET_HPP
+
+#include <cluster/prototypes/listenersocket.hpp>
+#include <string>
+
+namespace cluster
+{
+
+class CommunicationSocket;
+
+/**
+  * This class listens for connections of other
+  * members on the same computer. It creates a socket
+  * file with the name of the member in the given
+  * directory which is removed again when the
+  * ListenerSocket is destroyed.
+ **/
+class UnixDomainListenerSocket : public ListenerSocket
+{
+
+public:
+	/**
+	  * Creates a listener socket with the given name in
+	  * the given directory. The directory is created if
+	  * it doesn't exist. A socket file which is left over
+	  * from a member which crashed is replaced. The
+	  * listenBacklog defines how many connections are
+	  * stored before they are accepted. Timeout is used
+	  * when a client connection is established
+	 **/
+	UnixDomainListenerSocket(const std::string &directory, const std::string &name, unsigned int timeout, unsigned int listenBacklog);
+
+	/**
+	  * Default destructor. Removes the socket file
+	 **/
+	virtual ~UnixDomainListenerSocket();
+
+	/**
+	  * Cheks for the given timesout if a
+	  * client is waiting for a connection.
+	 **/
+	virtual bool poll(unsigned int time) override;
+
+	/**
+	  * Accepts the client connection. Doesn't
+	  * return until the connection is established
+	 **/
+	virtual CommunicationSocket* listen() override;
+
+#ifdef __linux__
+	/**
+	  * Returns the file descriptor of the server socket
+	 **/
+	virtual int getDescriptor() const override
+	{
+		return fd_socket;
+	}
+
+	/**
+	  * Accepts a waiting client connection and
+	  * puts it into non-blocking mode
+	 **/
+	virtual CommunicationSocket* listenNonBlocking() override;
+#endif //__linux__
+
+	/**
+	  * Returns the path of the socket file
+	 **/
+	const std::string& getPath() const
+	{
+		return path;
+	}
+
+	/**
+	  * Returns the timeout which is used when
+	  * establishing client connections
+	 **/
+	unsigned int getTimeout() const
+	{
+		return timeout;
+	}
+
+private:
+	/**
+	  * Creates the CommunicationSocket for an accepted
+	  * connection. The name of the other member is read
+	  * from the abstract name its socket is bound to.
+	 **/
+	CommunicationSocket* accepted(int fd_client, const void *clientAddr, unsigned int size);
+
+private:
+	/**
+	  * The path of the socket file
+	 **/
+	std::string path;
+
+	/**
+	  * The server socket
+	 **/
+	int fd_socket;
+
+	/**
+	  * The timeout which is used when establishing
+	  * client connections
+	 **/
+	unsigned int timeout;
+
+}; // end class UnixDomainListenerSocket
+
+} // end namespace cluster
+
+#endif //UNIXDOMAINLISTENERSOCKET_HPP
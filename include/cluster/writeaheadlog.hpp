@@ -0,0 +1,142 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef WRITEAHEADLOG_HPP
+#define WRITEAHEADLOG_HPP
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include <cluster/package.hpp>
+
+namespace cluster
+{
+
+/**
+  * The WriteAheadLog stores the Packages which a
+  * ClusterObjectSerialized performed on the disk,
+  * so that a member which restarts can restore
+  * its state locally instead of fetching all data
+  * from the master again.
+  * It consists of a snapshot of the whole state and
+  * a log to which every following Package is appended
+  * together with its id and its Digest. Whenever a
+  * new snapshot is written, the log starts again with
+  * a record which names the snapshot it belongs to.
+  * The snapshot is synced to the disk before the log
+  * is started again, so a crash in between loses no
+  * Package.
+  * Appended records are only flushed, so that many of
+  * them can be synced to the disk at once using sync.
+  * Records which were only written partly, e.g.
+  * because the process crashed, are detected by
+  * their Digest and ignored.
+  * The WriteAheadLog is not synchronized.
+ **/
+class WriteAheadLog
+{
+
+public:
+	/**
+	  * Constructs a WriteAheadLog which uses the
+	  * given file for the log and the file with
+	  * the extension .snapshot for the snapshot.
+	  * The files are not opened yet
+	 **/
+	WriteAheadLog(const std::string &fileName);
+
+	/**
+	  * Default destructor. Closes the log
+	 **/
+	~WriteAheadLog();
+
+	/**
+	  * Reads the snapshot and the Packages which follow it
+	  * with consecutive ids. Returns false if there is
+	  * no valid snapshot
+	 **/
+	bool load(unsigned long long &snapshotId, Package &snapshot, std::vector<std::pair<unsigned long long,Package> > &packages) const;
+
+	/**
+	  * Replaces the snapshot by the given one which
+	  * is followed by the Package with the given id
+	  * and starts the log again. Returns false if
+	  * the files can't be written
+	 **/
+	bool writeSnapshot(unsigned long long nextId, const Package &snapshot);
+
+	/**
+	  * Appends the given Package to the log. The log
+	  * is flushed but not synced to the disk. Returns
+	  * false if the log is not started by a snapshot
+	  * yet or if it can't be written
+	 **/
+	bool append(unsigned long long id, const Package &p, uint32_t digest);
+
+	/**
+	  * Writes the Packages which were appended since
+	  * the last call to the disk. Returns false if
+	  * the log can't be synced
+	 **/
+	bool sync();
+
+	/**
+	  * Returns the amount of Packages which were
+	  * appended since the last snapshot
+	 **/
+	unsigned int getAppended() const
+	{
+		return appended;
+	}
+
+private:
+	/**
+	  * Copying a WriteAheadLog is illegal
+	 **/
+	WriteAheadLog(const WriteAheadLog &w);
+
+	/**
+	  * Copying a WriteAheadLog is illegal
+	 **/
+	WriteAheadLog& operator=(const WriteAheadLog &w);
+
+private:
+	/**
+	  * The name of the log file
+	 **/
+	std::string fileName;
+
+	/**
+	  * The name of the snapshot file
+	 **/
+	std::string snapshotFileName;
+
+	/**
+	  * The log to which the Packages are appended
+	 **/
+	std::ofstream log;
+
+	/**
+	  * The amount of Packages which were
+	  * appended since the last snapshot
+	 **/
+	unsigned int appended;
+
+	/**
+	  * A flag whether Packages were appended
+	  * which are not synced yet
+	 **/
+	bool unsynced;
+
+}; //end class WriteAheadLog
+
+} //end namespace cluster
+
+#endif //WRITEAHEADLOG_HPP
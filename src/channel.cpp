@@ -0,0 +1,516 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/channel.hpp>
+#include <cluster/prototypes/communicationsocket.hpp>
+#include <cluster/compression.hpp>
+#include <chrono>
+#include <limits>
+#include <string.h>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The interval in milliseconds in which the read
+  * thread checks whether it should stop
+ **/
+static const unsigned int pollInterval = 100;
+
+const char Channel::helloMessage[] = "cluster-channel-1";
+
+const char Channel::helloAnswerMessage[] = "cluster-channel-1-ok";
+
+const char Channel::busyMessage[] = "cluster-busy-1";
+
+/**
+  * The difference between the type of a frame
+  * and the type of a compressed frame
+ **/
+static const char compressedTypeOffset = 'a' - 'A';
+
+/**
+  * The bit of the type of a frame which tells
+  * that the content is in the compact Format
+ **/
+static const unsigned char compactTypeFlag = 0x80;
+
+/**
+  * Returns the type character of a frame
+ **/
+static char typeCharacter(ChannelFrame type, bool compressed, Package::Format format)
+{
+	char character = char(type);
+	if(compressed)character = char(character - compressedTypeOffset);
+	if(format == Package::Format::compact)character = char(static_cast<unsigned char>(character) | compactTypeFlag);
+	return character;
+}
+
+shared_ptr<Channel> Channel::create(CommunicationSocket *socket, function<void(const Address&, const Package&, Package&)> fn_messageCallback, unsigned int ui_timeout, bool compression)
+{
+	shared_ptr<Channel> channel(new Channel(socket, fn_messageCallback, ui_timeout));
+
+	channel->readThread = new thread(&Channel::readFunction, channel.get());
+	channel->messageThread = new thread(&Channel::messageFunction, channel.get(), channel);
+
+	//Frames are sent uncompressed until
+	//the other side answered the options
+	if(compression)channel->sendFrame(encode(ChannelFrame::options, 0, compressionOptions()));
+
+	return channel;
+}
+
+bool Channel::handshake(CommunicationSocket *socket, bool &supported)
+{
+	Package answer;
+	if(!socket->send(Package(helloMessage, sizeof(helloMessage) - 1)))return false;
+	if(!socket->receive(&answer))return false;
+	supported = (answer == helloAnswer());
+	return true;
+}
+
+bool Channel::isHello(const Package &message)
+{
+	return message.getLength() == sizeof(helloMessage) - 1 && memcmp(message.getData(), helloMessage, sizeof(helloMessage) - 1) == 0;
+}
+
+Package Channel::helloAnswer()
+{
+	return Package(helloAnswerMessage, sizeof(helloAnswerMessage) - 1);
+}
+
+bool Channel::isBusy(const Package &answer)
+{
+	return answer.getLength() == sizeof(busyMessage) - 1 && memcmp(answer.getData(), busyMessage, sizeof(busyMessage) - 1) == 0;
+}
+
+Package Channel::busyAnswer()
+{
+	return Package(busyMessage, sizeof(busyMessage) - 1);
+}
+
+Package Channel::compressionOptions()
+{
+	//The options don't depend on the Format
+	//which the members negotiated
+	Package options;
+	options.setFormat(Package::Format::fixed);
+	options<<string(Compression::name);
+	return options;
+}
+
+bool Channel::supportsCompression(const Package &content)
+{
+	Package options(content);
+	options.setFormat(Package::Format::fixed);
+
+	string option;
+	while(options>>option)
+	{
+		if(option == Compression::name)return true;
+	}
+	return false;
+}
+
+Package Channel::encode(ChannelFrame type, uint64_t id, const Package &content, bool compress)
+{
+	Package frame;
+
+	vector<char> compressed;
+	if(compress && content.getLength() >= Compression::threshold && Compression::compress(content.getData(), content.getLength(), compressed))
+	{
+		frame<<typeCharacter(type, true, content.getFormat());
+		frame<<id;
+		frame<<uint64_t(content.getLength());
+		frame.write(compressed.data(), compressed.size());
+		return frame;
+	}
+
+	//Empty content is sent as a single '\0' byte
+	//like on a plain connection
+	if(content.empty())frame<<'\0';
+	else frame<<content;
+
+	//The content is not copied if
+	//there is headroom in front of it
+	frame.prepend(id);
+	frame.prepend(typeCharacter(type, false, content.getFormat()));
+
+	return frame;
+}
+
+bool Channel::decodeHeader(const Package &frame, ChannelFrame &type, uint64_t &id, bool &compressed, Package::Format &format)
+{
+	char character;
+	if(!(frame>>character))return false;
+	if(!(frame>>id))return false;
+
+	format = (static_cast<unsigned char>(character) & compactTypeFlag) ? Package::Format::compact : Package::Format::fixed;
+	character = char(static_cast<unsigned char>(character) & ~compactTypeFlag);
+
+	compressed = (character >= 'A' && character <= 'Z');
+	type = ChannelFrame(compressed ? char(character + compressedTypeOffset) : character);
+	return (type == ChannelFrame::request || type == ChannelFrame::answer || type == ChannelFrame::message || type == ChannelFrame::busy || type == ChannelFrame::options);
+}
+
+bool Channel::decode(const Package &frame, ChannelFrame &type, uint64_t &id, Package &content)
+{
+	bool compressed;
+	Package::Format format;
+	if(!decodeHeader(frame, type, id, compressed, format))return false;
+
+	if(!compressed)
+	{
+		content = frame.subPackageFromCurrentPosition();
+		content.setFormat(format);
+		return true;
+	}
+
+	uint64_t originalLength;
+	if(!(frame>>originalLength))return false;
+	if(originalLength > numeric_limits<std::size_t>::max())return false;
+
+	//The size is checked before any memory is reserved
+	const Package data = frame.subPackageFromCurrentPosition();
+	if(originalLength / Compression::maxRatio > data.getLength())return false;
+
+	Package decompressed;
+	decompressed.setFormat(format);
+	if(!Compression::decompress(data.getData(), data.getLength(), std::size_t(originalLength), decompressed.extend(std::size_t(originalLength))))return false;
+
+	content = decompressed;
+	return true;
+}
+
+Channel::Channel(CommunicationSocket *s, function<void(const Address&, const Package&, Package&)> fn_messageCallback, unsigned int ui_timeout) :
+	socket(s),
+	messageCallback(fn_messageCallback),
+	timeout(ui_timeout),
+	open(true),
+	running(true),
+	compression(false),
+	sendMutex(),
+	nextId(0),
+	requests(),
+	messages(),
+	completions(),
+	lastActivity(time(nullptr)),
+	m(),
+	cv(),
+	closeMutex(),
+	readThread(nullptr),
+	messageThread(nullptr)
+{}
+
+Channel::~Channel()
+{
+	close();
+	delete socket;
+}
+
+const Address& Channel::getAddress() const
+{
+	return socket->getAddress();
+}
+
+bool Channel::ask(const Package &message, Package *answer)
+{
+	bool sent;
+	bool busy;
+	return ask(message, answer, sent, busy);
+}
+
+bool Channel::ask(const Package &message, Package *answer, bool &sent, bool &busy)
+{
+	Request request(answer, nullptr, nullptr, 0);
+
+	sent = false;
+	busy = false;
+	unique_lock<mutex> lock(m);
+	if(!open)return false;
+	const uint64_t id = nextId++;
+	requests[id] = &request;
+	lastActivity = time(nullptr);
+	lock.unlock();
+
+	bool success = sendFrame(encode(ChannelFrame::request, id, message, compression));
+	sent = success;
+
+	//Wait until the read thread received the answer
+	lock.lock();
+	if(success)
+	{
+		cv.wait_for(lock, chrono::seconds(timeout), [this,&request]{ return request.done || request.busy || !open; });
+		success = request.done;
+		busy = request.busy;
+	}
+	requests.erase(id);
+	lastActivity = time(nullptr);
+
+	return success;
+}
+
+void Channel::askAsync(const Package &message, Package *answer, function<void(bool)> callback)
+{
+	askAsync(message, answer, callback, [callback]{ callback(false); }, [callback]{ callback(false); });
+}
+
+void Channel::askAsync(const Package &message, Package *answer, function<void(bool)> callback, function<void()> notSent, function<void()> busy)
+{
+	Request *request = new Request(answer, callback, busy, time(nullptr) + timeout);
+
+	m.lock();
+	if(!open)
+	{
+		m.unlock();
+		delete request;
+		notSent();
+		return;
+	}
+	const uint64_t id = nextId++;
+	requests[id] = request;
+	lastActivity = time(nullptr);
+	m.unlock();
+
+	sendMutex.lock();
+	const bool sent = open && socket->send(encode(ChannelFrame::request, id, message, compression));
+	sendMutex.unlock();
+	if(sent)return;
+
+	//If the Channel was failed by another thread in the
+	//meantime, the callback of the request is called already
+	m.lock();
+	auto it = requests.find(id);
+	const bool failed = (it == requests.end());
+	if(!failed)
+	{
+		delete it->second;
+		requests.erase(it);
+	}
+	m.unlock();
+
+	//The stream is broken if a frame could not be sent
+	failRequests();
+
+	if(!failed)notSent();
+}
+
+bool Channel::send(const Package &message)
+{
+	return sendFrame(encode(ChannelFrame::message, 0, message, compression));
+}
+
+bool Channel::isIdle(unsigned int maxIdleTime)
+{
+	m.lock();
+	const bool idle = requests.empty() && messages.empty() && completions.empty() && difftime(time(nullptr), lastActivity) >= maxIdleTime;
+	m.unlock();
+	return idle;
+}
+
+void Channel::close()
+{
+	closeMutex.lock();
+	thread *r = readThread;
+	thread *mt = messageThread;
+	readThread = nullptr;
+	messageThread = nullptr;
+	closeMutex.unlock();
+
+	//Already closed
+	if(!r)return;
+
+	m.lock();
+	running = false;
+	m.unlock();
+	cv.notify_all();
+
+	r->join();
+	delete r;
+
+	failRequests();
+
+	//If the Channel is closed by a message callback,
+	//the message thread finishes on its own
+	if(mt->get_id() == this_thread::get_id())mt->detach();
+	else mt->join();
+	delete mt;
+
+	//The callbacks of the failed requests
+	//are called in any case
+	runCompletions();
+}
+
+bool Channel::sendFrame(const Package &frame)
+{
+	sendMutex.lock();
+	const bool success = open && socket->send(frame);
+	sendMutex.unlock();
+
+	//The stream is broken if a frame could not be sent
+	if(!success)failRequests();
+
+	return success;
+}
+
+void Channel::readFunction()
+{
+	while(running)
+	{
+		if(!socket->poll(pollInterval))
+		{
+			m.lock();
+			failExpiredRequests();
+			m.unlock();
+			cv.notify_all();
+			continue;
+		}
+
+		Package frame;
+		if(!socket->receive(&frame))break;
+
+		ChannelFrame type;
+		uint64_t id;
+		Package content;
+		if(!decode(frame, type, id, content))continue;
+
+		//The other side answered the options
+		if(type == ChannelFrame::options)
+		{
+			if(supportsCompression(content))compression = true;
+			continue;
+		}
+
+		m.lock();
+		lastActivity = time(nullptr);
+		if(type == ChannelFrame::answer)
+		{
+			auto it = requests.find(id);
+
+			//The request might have timed out already
+			if(it != requests.end())
+			{
+				Package *answer = it->second->answer;
+				if(answer && answer->empty())*answer = content;
+				else if(answer)answer->write(content.getData(), content.getLength());
+				it->second->done = true;
+
+				//Asynchronous requests are finished
+				//by the message thread
+				if(it->second->callback)
+				{
+					completions.push(make_pair(it->second->callback, true));
+					delete it->second;
+					requests.erase(it);
+				}
+			}
+		}
+		else if(type == ChannelFrame::busy)
+		{
+			auto it = requests.find(id);
+			if(it != requests.end())
+			{
+				it->second->busy = true;
+				if(it->second->callback)
+				{
+					function<void()> busyCallback = it->second->busyCallback;
+					completions.push(make_pair([busyCallback](bool){ busyCallback(); }, false));
+					delete it->second;
+					requests.erase(it);
+				}
+			}
+		}
+		else if(type == ChannelFrame::message)
+		{
+			messages.push(content);
+		}
+		failExpiredRequests();
+		m.unlock();
+		cv.notify_all();
+	}
+
+	failRequests();
+}
+
+void Channel::messageFunction(shared_ptr<Channel> /*self*/)
+{
+	unique_lock<mutex> lock(m);
+	while(running)
+	{
+		if(!completions.empty())
+		{
+			lock.unlock();
+			runCompletions();
+			lock.lock();
+			continue;
+		}
+		if(messages.empty())
+		{
+			cv.wait(lock);
+			continue;
+		}
+		Package message = messages.front();
+		messages.pop();
+		lock.unlock();
+
+		Package toSend;
+		if(messageCallback)messageCallback(getAddress(), message, toSend);
+		if(!toSend.empty())send(toSend);
+
+		lock.lock();
+	}
+}
+
+void Channel::failRequests()
+{
+	m.lock();
+	open = false;
+	for(auto it = requests.begin(); it != requests.end(); )
+	{
+		if(it->second->callback)
+		{
+			completions.push(make_pair(it->second->callback, false));
+			delete it->second;
+			it = requests.erase(it);
+		}
+		else ++it;
+	}
+	m.unlock();
+	cv.notify_all();
+}
+
+void Channel::failExpiredRequests()
+{
+	const time_t now = time(nullptr);
+	for(auto it = requests.begin(); it != requests.end(); )
+	{
+		if(it->second->callback && difftime(now, it->second->deadline) > 0)
+		{
+			completions.push(make_pair(it->second->callback, false));
+			delete it->second;
+			it = requests.erase(it);
+		}
+		else ++it;
+	}
+}
+
+void Channel::runCompletions()
+{
+	m.lock();
+	while(!completions.empty())
+	{
+		pair<function<void(bool)>,bool> completion = completions.front();
+		completions.pop();
+		m.unlock();
+
+		completion.first(completion.second);
+
+		m.lock();
+	}
+	m.unlock();
+}
@@ -7,162 +7,224 @@
  **/
 
 #include <cluster/client.hpp>
+#include <cluster/connectionpool.hpp>
+#include <cluster/channel.hpp>
 #include <cluster/prototypes/communicationsocket.hpp>
 #include <cluster/prototypes/protocol.hpp>
 #include <cluster/package.hpp>
-#include <assert.h>
-#include <iostream>
-#include <map>
-#include <mutex>
+#include <chrono>
 #include <thread>
-#include <sys/time.h>
-#include <unistd.h>
+#include <assert.h>
 
 using namespace std;
 using namespace cluster;
 
-/*multimap<string, pair<CommunicationSocket*,unsigned long> > sockets;
-mutex socketMutex;
-thread *cleanupThread = nullptr;
-mutex threadMutex;
-unsigned int clientsCounter = 0;
+Client::Client(const Address &a, const Protocol &p, ConnectionPool *cp) :
+	address(a.clone()),
+	protocol(&p),
+	pool(cp)
+{}
+
+Client::Client(const Client &c) :
+	address(c.address->clone()),
+	protocol(c.protocol),
+	pool(c.pool)
+{}
 
-CommunicationSocket* getSocket(const Address &address, const Protocol *protocol)
+Client& Client::operator=(const Client &c)
 {
-	CommunicationSocket *socket = nullptr;
+	assert(c.address != nullptr);
 
-	socketMutex.lock();
-	auto it = sockets.find(address.address);
-	if(it == sockets.cend())
-	{
-		socket = protocol->createCommunicationSocket(address);
-	}
-	else
-	{
-		socket = it->second.first;
-		sockets.erase(it);
-	}
-	socketMutex.unlock();
+	protocol = c.protocol;
+	pool = c.pool;
+	delete address;
+	address = c.address->clone();
+	return (*this);
+}
 
-	return socket;
+Client::~Client()
+{
+	delete address;
 }
 
-void cleanupThreadFunction()
+bool Client::send(const Package &message, Package *out) const
 {
-	while(clientsCounter != 0)
+	//A member which is too busy is asked
+	//again after a pause which grows each time
+	for(unsigned int attempt = 0; ; ++attempt)
 	{
-		struct timeval time;
-		gettimeofday(&time, nullptr);
+		bool busy;
+		if(sendOnce(message, out, busy))return true;
+		if(!busy || attempt == busyRetries)return false;
+		this_thread::sleep_for(chrono::milliseconds(busyBackoff << attempt));
+	}
+}
 
-		socketMutex.lock();
-		for(auto it = sockets.begin(); it != sockets.end(); ++it)
-		{
-			const unsigned long diff = time.tv_sec - it->second.second;
+void Client::sendAsync(const Package &message, Package *out, function<void(bool)> callback) const
+{
+	sendAsync(message, out, callback, 0);
+}
 
-			if(diff >= 10)
-			{
-				cout<<"Closing connection to "<<it->first<<endl;
-				delete it->second.first;
-				sockets.erase(it);
-				break;
-			}
-		}
-		socketMutex.unlock();
+bool Client::receive(CommunicationSocket *s, Package *out, bool &busy)
+{
+	Package answer;
+	if(!s->receive(&answer))return false;
 
-		sleep(1);
-	}
+	busy = Channel::isBusy(answer);
+	if(busy)return false;
 
-	socketMutex.lock();
-	for(auto it = sockets.begin(); it != sockets.end(); ++it)
-	{
-		delete it->second.first;
-	}
-	socketMutex.unlock();
-	sockets.clear();
+	if(out)out->write(answer);
+	return true;
 }
 
-void putSocket(const Address &address, CommunicationSocket *socket)
+bool Client::sendOnce(const Package &message, Package *out, bool &busy) const
 {
-	struct timeval time;
-	gettimeofday(&time, nullptr);
+	busy = false;
 
-	socketMutex.lock();
-	sockets.insert(pair<string,pair<CommunicationSocket*,unsigned long> >(address.address, pair<CommunicationSocket*,unsigned long>(socket, time.tv_sec)));
-	socketMutex.unlock();
+	//Only a Channel tells the other side that the
+	//Package is in the compact Format
+	const bool plainAllowed = (message.getFormat() == Package::Format::fixed);
 
-	threadMutex.lock();
-	if(!cleanupThread)
+	if(!pool)
 	{
-		cleanupThread = new thread(cleanupThreadFunction);
-	}
-	threadMutex.unlock();
-}*/
+		if(!plainAllowed)return false;
 
-/***********************************************/
+		//Create communication socket
+		if(CommunicationSocket *s = protocol->createCommunicationSocket(*address))
+		{
+			const bool success = s->send(message) && receive(s, out, busy);
+			delete s;
+			return success;
+		}
+		return false;
+	}
 
-Client::Client(const Address &a, const Protocol &p) :
-	address(a.clone()),
-	protocol(&p)
-{
-/*	threadMutex.lock();
-	++clientsCounter;
-	threadMutex.unlock();*/
-}
+	//A reused connection might have been closed by the
+	//other side in the meantime. In this case the message
+	//is sent again using a new connection, but only if it
+	//could not be written. Otherwise the other side might
+	//have received it already and would handle it twice
+	bool reused = true;
+	if(pool->getMultiplexing())
+	{
+		while(reused)
+		{
+			bool connected;
+			shared_ptr<Channel> channel = pool->getChannel(*address, reused, connected);
+			if(!connected)return false;
 
-Client::Client(const Client &c) :
-	address(c.address->clone()),
-	protocol(c.protocol)
-{
-/*	threadMutex.lock();
-	++clientsCounter;
-	threadMutex.unlock();*/
-}
+			//The other side does not support Channels
+			if(!channel)
+			{
+				reused = true;
+				break;
+			}
 
-Client& Client::operator=(const Client &c)
-{
-	assert(c.address != nullptr);
+			bool sent;
+			if(channel->ask(message, out, sent, busy))return true;
 
-	protocol = c.protocol;
-	delete address;
-	address = c.address->clone();
-	return (*this);
-}
+			//The Channel is still fine if the
+			//other side was only too busy
+			if(busy)return false;
 
-Client::~Client()
-{
-	delete address;
+			pool->removeChannel(channel);
+			if(sent)return false;
+		}
+		if(!reused)return false;
+	}
+	if(!plainAllowed)return false;
 
-/*	threadMutex.lock();
-	if(--clientsCounter == 0 && cleanupThread)
+	while(reused)
 	{
-		cleanupThread->join();
-		delete cleanupThread;
-		cleanupThread = nullptr;
+		CommunicationSocket *s = pool->get(*address, reused);
+		if(!s)return false;
+
+		if(!s->send(message))
+		{
+			delete s;
+			continue;
+		}
+
+		if(receive(s, out, busy))
+		{
+			pool->put(s);
+			return true;
+		}
+
+		//The connection can be reused if the
+		//other side was only too busy
+		if(busy)pool->put(s);
+		else delete s;
+		return false;
 	}
-	threadMutex.unlock();*/
+	return false;
 }
 
-bool Client::send(const Package &message, Package *out) const
+void Client::sendAsync(const Package &message, Package *out, function<void(bool)> callback, unsigned int attempt) const
 {
-	//Create communication socket
-	if(CommunicationSocket *s = protocol->createCommunicationSocket(*address))
+	if(pool && pool->getMultiplexing())
 	{
-		bool success = s->send(message) && s->receive(out);
-/*cout<<message.toString()<<(success ? " success" : " no success")<<endl;
-		if(!success)
+		bool reused;
+		bool connected;
+		shared_ptr<Channel> channel = pool->getChannel(*address, reused, connected);
+		if(!connected)
 		{
-			//Try again using a new connection*/
-			delete s;
+			callback(false);
+			return;
+		}
 
-/*			s = getSocket(*address, protocol);
-			success = s->send(message) && s->receive(out);
-cout<<(success ? " success" : " no success")<<endl;
+		if(channel)
+		{
+			const Client client(*this);
+			ConnectionPool *cp = pool;
+			channel->askAsync(message, out, [callback,channel,cp](bool success)
+			{
+				if(!success)cp->removeChannel(channel);
+				callback(success);
+			},
+			[client,message,out,callback,channel,reused,attempt,cp]()
+			{
+				cp->removeChannel(channel);
+
+				//A reused Channel might have been closed by the
+				//other side in the meantime. The request was not
+				//written, so it is sent again using a new Channel
+				if(reused)client.sendAsync(message, out, callback, attempt);
+				else callback(false);
+			},
+			[client,message,out,callback,attempt,cp]()
+			{
+				if(attempt == busyRetries)
+				{
+					callback(false);
+					return;
+				}
+
+				//The message thread of the Channel must not
+				//wait, so the pause is made by the Executor
+				if(!cp->getExecutor().execute([client,message,out,callback,attempt]()
+				{
+					this_thread::sleep_for(chrono::milliseconds(busyBackoff << attempt));
+					client.sendAsync(message, out, callback, attempt + 1);
+				}))callback(false);
+			});
+			return;
 		}
+	}
 
-		putSocket(*address, s);*/
-		return success;
+	if(!pool)
+	{
+		callback(send(message, out));
+		return;
 	}
-	return false;
+
+	//Plain connections block, so the Package is sent by the
+	//Executor which is stopped before the ConnectionPool
+	const Client client(*this);
+	if(!pool->getExecutor().execute([client,message,out,callback]()
+	{
+		callback(client.send(message, out));
+	}))callback(false);
 }
 
 bool Client::operator==(const Client &c)
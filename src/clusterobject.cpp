@@ -59,12 +59,13 @@ namespace cluster
 
 	/**
 	  * Adds the given signature to the package.
+	  * The content is not copied if there is
+	  * headroom in front of it
 	 **/
 	inline Package addSignature(const Package &a, ClusterObjectOperation type)
 	{
-		Package message;
-		message<<type;
-		message<<a;
+		Package message(a);
+		message.prepend(type);
 		return message;
 	}
 
@@ -191,17 +192,17 @@ bool ClusterObject::ClusterObject_received(const Address &ip, const Package &mes
 	}
 
 	//If something should be sent add child structure
-	if(to_send.getLength())
-	{
-		Package temp;
-		temp<<t;
-		temp<<to_send;
-		to_send = temp;
-	}
+	if(to_send.getLength())to_send.prepend(t);
 
 	return success;
 }
 
+bool ClusterObject::isForCurrent(const Package &message)
+{
+	char t;
+	return message.get(t) && t == char(ClusterObjectOperation::current);
+}
+
 Package ClusterObject::addChildSignature(const Package &a)
 {
 	return addSignature(a, ClusterObjectOperation::child);
@@ -258,7 +258,7 @@ void ClusterObjectDistributed::memberOffline(const Address &ip)
 					for(std::size_t otherIndex : ids)
 					{
 						const Address *address = onlineClients[otherIndex].address;
-						//cout<<"Asking "<<address->address<<endl;
+						//cout<<"Asking "<<address->toString()<<endl;
 						if(!address)continue;
 
 						//Ask for package
@@ -272,7 +272,7 @@ void ClusterObjectDistributed::memberOffline(const Address &ip)
 						//Insert package
 						if(performInsert(answer, newId, error))
 						{
-							cout<<"Took over data from "<<ip.address<<": "<<newId<<endl;
+							cout<<"Took over data from "<<ip.toString()<<": "<<newId<<endl;
 
 							onlineClients[0].ids.push_back(newId);
 							idsInClients[newId].push_back(0);
@@ -333,6 +333,11 @@ bool ClusterObjectDistributed::perform(const Address &address, const Package &p,
 			return true;
 		}
 		case OwnOperation::deleted: {
+			//The members which store the ids are not
+			//known while the WriteAheadLog is replayed.
+			//They are asked again when they are online
+			if(isReplaying())return true;
+
 			//ID was inserted in given client
 			string id;
 			if(!(p>>id))return false;
@@ -385,6 +390,11 @@ bool ClusterObjectDistributed::perform(const Address &address, const Package &p,
 			return true;
 		}
 		case OwnOperation::inserted: {
+			//The members which store the ids are not
+			//known while the WriteAheadLog is replayed.
+			//They are asked again when they are online
+			if(isReplaying())return true;
+
 			//ID was inserted in given client
 			std::size_t index = getOnlineClientId(address);
 			onlineClientsMutex.lock();
@@ -396,7 +406,7 @@ bool ClusterObjectDistributed::perform(const Address &address, const Package &p,
 			string id;
 			while(p>>id)
 			{
-//cout<<address.address<<" contains now "<<id<<endl;
+//cout<<address.toString()<<" contains now "<<id<<endl;
 				onlineClients[index].ids.push_back(id);
 				idsInClients[id].push_back(index);
 			}
@@ -625,28 +635,46 @@ void ClusterObjectDistributed::insertData(const list<Package> &data, std::string
 
 bool ClusterObjectDistributed::sendPackage(const Package &a, AnswerPackage *answer)
 {
-	Package message;
-	message<<ClusterObjectDistributedOperation::command;
-	message<<a;
+	Package message(a);
+	message.prepend(ClusterObjectDistributedOperation::command);
 	return ClusterObjectSerialized::sendPackage(message, answer);
 }
 
 bool ClusterObjectDistributed::sendPackageUnserialized(const Package &a, AnswerPackage *answer)
 {
-	Package message;
-	message<<ClusterObjectDistributedOperation::command;
-	message<<a;
+	Package message(a);
+	message.prepend(ClusterObjectDistributedOperation::command);
 	return ClusterObjectSerialized::sendPackageUnserialized(message, answer);
 }
 
 bool ClusterObjectDistributed::askPackage(const Address &ip, const Package &a, Package *answer)
 {
-	Package message;
-	message<<ClusterObjectDistributedOperation::command;
-	message<<a;
+	Package message(a);
+	message.prepend(ClusterObjectDistributedOperation::command);
 	return ClusterObjectSerialized::askPackage(ip, message, answer);
 }
 
+void ClusterObjectDistributed::sendPackageAsync(const Package &a, AnswerPackage *answer, function<void(bool)> callback)
+{
+	Package message(a);
+	message.prepend(ClusterObjectDistributedOperation::command);
+	ClusterObjectSerialized::sendPackageAsync(message, answer, callback);
+}
+
+void ClusterObjectDistributed::sendPackageUnserializedAsync(const Package &a, AnswerPackage *answer, function<void(bool)> callback)
+{
+	Package message(a);
+	message.prepend(ClusterObjectDistributedOperation::command);
+	ClusterObjectSerialized::sendPackageUnserializedAsync(message, answer, callback);
+}
+
+void ClusterObjectDistributed::askPackageAsync(const Address &ip, const Package &a, Package *answer, function<void(bool)> callback)
+{
+	Package message(a);
+	message.prepend(ClusterObjectDistributedOperation::command);
+	ClusterObjectSerialized::askPackageAsync(ip, message, answer, callback);
+}
+
 bool ClusterObjectDistributed::deleted(const std::string &id)
 {
 	Package message;
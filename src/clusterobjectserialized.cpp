@@ -7,7 +7,17 @@
  **/
 
 #include <cluster/clusterobjectserialized.hpp>
+#include <cluster/answerpackage.hpp>
+#include <cluster/digest.hpp>
+#include <cluster/writeaheadlog.hpp>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <typeinfo>
+#include <utility>
+#include <vector>
 
 using namespace std;
 using namespace cluster;
@@ -30,7 +40,28 @@ namespace cluster
 		  * Get package is used when a member missed
 		  * one or few packages and needs to rebuild it
 		 **/
-		get_package = 'g'
+		get_package = 'g',
+
+		/**
+		  * Full data chunk retrieves one chunk of the
+		  * Package that can be used to rebuild.
+		  * Older versions answer it with an empty Package
+		 **/
+		full_data_chunk = 'c',
+
+		/**
+		  * Get packages retrieves a range of packages
+		  * at once from one member. Older versions
+		  * answer it with an empty Package
+		 **/
+		get_packages = 'r',
+
+		/**
+		  * Get digest retrieves the digest of a range
+		  * of packages to confirm the packages which
+		  * were retrieved from another member
+		 **/
+		get_digest = 'h'
 	};
 
 	/**
@@ -75,7 +106,14 @@ namespace cluster
 		  * Indicates that the message is an ask
 		  * package for the child object
 		 **/
-		other_ask = 'a'
+		other_ask = 'a',
+
+		/**
+		  * Indicates that the message contains several
+		  * packages for the child object with
+		  * consecutive ids. Older versions reject it
+		 **/
+		batch = 'b'
 	};
 
 	/**
@@ -101,12 +139,130 @@ namespace cluster
 
 } //end namespace cluster
 
-ClusterObjectSerialized::ClusterObjectSerialized(ClusterObject *network, unsigned int ui_maxPackagesToRemember) :
+/**
+  * The amount of bytes of rebuild data
+  * which is sent in one chunk
+ **/
+static const std::size_t rebuildChunkSize = 262144;
+
+/**
+  * How often a rebuild in chunks is started again
+  * if the data changed before the data is fetched
+  * all at once
+ **/
+static const unsigned int maxChunkedRebuildAttempts = 3;
+
+/**
+  * How long in seconds catching up waits for the
+  * other members to confirm the missed packages
+ **/
+static const unsigned int confirmationTimeout = 2;
+
+/**
+  * The Address which is given to perform and rebuild
+  * while the object is restored from the WriteAheadLog
+  * and when the own Packages are performed. The member
+  * which sent the Packages originally is not stored
+ **/
+class LocalAddress : public Address
+{
+
+public:
+	virtual Address* clone() const override
+	{
+		return new LocalAddress();
+	}
+
+	virtual void increase() override
+	{}
+
+	virtual bool operator== (const Address &a) const override
+	{
+		return typeid(a) == typeid(LocalAddress);
+	}
+
+	virtual std::size_t hash() const override
+	{
+		return 0;
+	}
+
+	virtual std::string toString() const override
+	{
+		return "local";
+	}
+
+	virtual bool isLoopback() const override
+	{
+		return true;
+	}
+
+}; //end class LocalAddress
+
+struct ClusterObjectSerialized::Submission
+{
+	Submission(const Package &p, AnswerPackage *a, bool b_perform, function<void(bool)> f) :
+		package(p),
+		answer(a),
+		perform(b_perform),
+		callback(f)
+	{}
+
+	Submission(const Submission &s) = delete;
+	Submission& operator=(const Submission &s) = delete;
+
+	Package package;
+	AnswerPackage *answer;
+
+	/**
+	  * Whether the Package is performed locally
+	  * as soon as it gets its id
+	 **/
+	bool perform;
+
+	function<void(bool)> callback;
+};
+
+struct ClusterObjectSerialized::Batch
+{
+	Batch(const vector<Submission*> &v_submissions) :
+		submissions(v_submissions),
+		answers()
+	{}
+
+	~Batch()
+	{
+		for(Submission *s : submissions)delete s;
+	}
+
+	Batch(const Batch &b) = delete;
+	Batch& operator=(const Batch &b) = delete;
+
+	vector<Submission*> submissions;
+
+	/**
+	  * The answers of the members which contain
+	  * the answers of all Packages of the batch
+	 **/
+	AnswerPackage answers;
+};
+
+
+ClusterObjectSerialized::ClusterObjectSerialized(ClusterObject *network, unsigned int ui_maxPackagesToRemember, std::size_t ui_maxBytesToRemember) :
 	ClusterObject(network),
-	lastPackages(),
-	maxPackagesToRemember(ui_maxPackagesToRemember),
+	lastPackages(ui_maxPackagesToRemember, ui_maxBytesToRemember),
 	rebuildMutex(),
-	rebuilded(false)
+	rebuilded(false),
+	writeAheadLog(nullptr),
+	snapshotInterval(defaultSnapshotInterval),
+	restored(false),
+	replaying(false),
+	batchMutex(),
+	submissions(),
+	sender(nullptr),
+	submitted(),
+	stopping(false),
+	maxBatchPackages(defaultMaxBatchPackages),
+	maxBatchBytes(defaultMaxBatchBytes)
 {
 	addMemberCallback(this);
 }
@@ -114,6 +270,89 @@ ClusterObjectSerialized::ClusterObjectSerialized(ClusterObject *network, unsigne
 ClusterObjectSerialized::~ClusterObjectSerialized()
 {
 	removeMemberCallback(this);
+
+	batchMutex.lock();
+	stopping = true;
+	thread *toJoin = sender;
+	sender = nullptr;
+	batchMutex.unlock();
+	submitted.notify_all();
+
+	if(toJoin)
+	{
+		//If a callback destroys the object, the
+		//sender thread finishes on its own
+		if(toJoin->get_id() == this_thread::get_id())toJoin->detach();
+		else toJoin->join();
+		delete toJoin;
+	}
+
+	delete writeAheadLog;
+
+	for(Submission *s : submissions)
+	{
+		s->callback(false);
+		delete s;
+	}
+}
+
+void ClusterObjectSerialized::setReplayLimits(unsigned int ui_maxPackagesToRemember, std::size_t ui_maxBytesToRemember)
+{
+	rebuildMutex.lock();
+	lastPackages.setLimits(ui_maxPackagesToRemember, ui_maxBytesToRemember);
+	rebuildMutex.unlock();
+}
+
+void ClusterObjectSerialized::setBatchLimits(std::size_t ui_maxPackages, std::size_t ui_maxBytes)
+{
+	batchMutex.lock();
+	maxBatchPackages = max(ui_maxPackages, std::size_t(1));
+	maxBatchBytes = ui_maxBytes;
+	batchMutex.unlock();
+}
+
+bool ClusterObjectSerialized::openWriteAheadLog(const std::string &fileName, unsigned int ui_snapshotInterval)
+{
+	rebuildMutex.lock();
+	closeWriteAheadLog();
+	WriteAheadLog *log = new WriteAheadLog(fileName);
+	snapshotInterval = ui_snapshotInterval;
+
+	//The object is only restored if
+	//it didn't get any Package yet
+	unsigned long long snapshotId;
+	Package snapshot;
+	vector<pair<unsigned long long,Package> > packages;
+	if(!rebuilded && lastPackages.empty() && log->load(snapshotId, snapshot, packages))
+	{
+		const LocalAddress local;
+		replaying = true;
+		rebuildAll(snapshot, local);
+
+		Package tempAnswer;
+		Package tempToSend;
+		for(const auto &p : packages)
+		{
+			tempAnswer.clear();
+			tempToSend.clear();
+			lastPackages.add(p.first, p.second);
+			perform(local, p.second, tempAnswer, tempToSend);
+		}
+		replaying = false;
+
+		//An empty object is rebuilt as usual
+		restored = !lastPackages.empty();
+	}
+
+	//The log starts again with the restored object so
+	//that records at its end which are incomplete are
+	//not followed by new ones
+	writeAheadLog = log;
+	writeSnapshot();
+	const bool success = (writeAheadLog != nullptr);
+	rebuildMutex.unlock();
+
+	return success;
 }
 
 void ClusterObjectSerialized::memberOnline(const Address &ip, bool isMaster)
@@ -125,13 +364,11 @@ void ClusterObjectSerialized::memberOnline(const Address &ip, bool isMaster)
 	rebuildMutex.lock();
 	if(!rebuilded)
 	{
-//		std::cout<<"Rebuilding from master "<<ip.address<<std::endl;
-		Package p;
-		Package answer;
-		p<<ClusterObjectSerializedType::mine;
-		p<<ClusterObjectSerializedOperation::full_data;
-		ClusterObject::askPackage(ip, p, &answer);
-		rebuildAll(answer, ip);
+//		std::cout<<"Rebuilding from master "<<ip.toString()<<std::endl;
+		//A restored object only needs the
+		//packages which were missed
+		if(!restored || !continueRestored(ip))rebuildFrom(ip);
+		restored = false;
 		rebuilded = true;
 	}
 	rebuildMutex.unlock();
@@ -141,14 +378,139 @@ void ClusterObjectSerialized::memberOffline(const Address &/*ip*/)
 {}
 
 bool ClusterObjectSerialized::sendPackage(const Package &a, AnswerPackage *answer)
+{
+	shared_ptr<promise<bool> > sent(new promise<bool>());
+	future<bool> result = sent->get_future();
+	submit(a, answer, false, [sent](bool success){ sent->set_value(success); });
+	return result.get();
+}
+
+void ClusterObjectSerialized::sendPackageAsync(const Package &a, AnswerPackage *answer, function<void(bool)> callback)
+{
+	submit(a, answer, false, callback);
+}
+
+bool ClusterObjectSerialized::sendPackageAndPerform(const Package &a, AnswerPackage *answer)
+{
+	shared_ptr<promise<bool> > sent(new promise<bool>());
+	future<bool> result = sent->get_future();
+	submit(a, answer, true, [sent](bool success){ sent->set_value(success); });
+	return result.get();
+}
+
+void ClusterObjectSerialized::submit(const Package &a, AnswerPackage *answer, bool perform, function<void(bool)> callback)
+{
+	batchMutex.lock();
+	if(stopping)
+	{
+		batchMutex.unlock();
+		callback(false);
+		return;
+	}
+	submissions.push_back(new Submission(a, answer, perform, callback));
+
+	//The sender thread is started with the first Package
+	if(!sender)sender = new thread(&ClusterObjectSerialized::senderFunction, this);
+	batchMutex.unlock();
+	submitted.notify_one();
+}
+
+vector<ClusterObjectSerialized::Submission*> ClusterObjectSerialized::nextBatch()
+{
+	vector<Submission*> batch;
+	std::size_t bytes = 0;
+
+	unique_lock<mutex> lock(batchMutex);
+	submitted.wait(lock, [this]{ return stopping || !submissions.empty(); });
+	if(stopping)return batch;
+
+	//Members of older versions reject batches,
+	//so every Package is sent on its own
+	const std::size_t maxPackages = ClusterObject_readsBatches() ? maxBatchPackages : 1;
+
+	while(!submissions.empty() && batch.size() < maxPackages)
+	{
+		//A Package which is bigger than the limit is sent alone
+		const std::size_t length = submissions.front()->package.getLength();
+		if(!batch.empty() && bytes + length > maxBatchBytes)break;
+
+		//The Packages of a batch are read in the Format of the
+		//message, so Packages which were created in another
+		//Format are sent in the next batch
+		if(!batch.empty() && submissions.front()->package.getFormat() != batch.front()->package.getFormat())break;
+
+		bytes += length;
+		batch.push_back(submissions.front());
+		submissions.pop_front();
+	}
+
+	return batch;
+}
+
+void ClusterObjectSerialized::senderFunction()
+{
+	//Every batch is sent after the previous one
+	//arrived, so the ids arrive in order
+	for(vector<Submission*> next = nextBatch(); !next.empty(); next = nextBatch())
+	{
+		Batch batch(next);
+		Package message;
+		if(!serialize(batch.submissions, message))
+		{
+			finishBatch(batch, false);
+			continue;
+		}
+
+		//A single Package gets the answers directly
+		AnswerPackage *answers = nullptr;
+		if(next.size() == 1)answers = next.front()->answer;
+		else
+		{
+			for(const Submission *s : next)
+			{
+				if(s->answer)answers = &batch.answers;
+			}
+		}
+
+		const bool success = ClusterObject::ClusterObject_send(addCurrentSignature(message), answers);
+		finishBatch(batch, success);
+	}
+}
+
+void ClusterObjectSerialized::finishBatch(Batch &batch, bool success)
+{
+	//The answer of every member contains the
+	//answers of all Packages one after the other
+	if(batch.submissions.size() > 1)
+	{
+		for(auto it = batch.answers.cbegin(); it != batch.answers.cend(); ++it)
+		{
+			const Package &a = it->second;
+			for(Submission *s : batch.submissions)
+			{
+				uint64_t length;
+				Package answer;
+				answer.setFormat(a.getFormat());
+				if(!a.readLength(length) || length > a.getRemaining() || !a.getAndNext(answer.extend((std::size_t)length), (std::size_t)length))break;
+				if(s->answer)s->answer->add(*it->first, answer);
+			}
+		}
+	}
+
+	for(Submission *s : batch.submissions)
+	{
+		s->callback(success);
+	}
+}
+
+bool ClusterObjectSerialized::serialize(const vector<Submission*> &batch, Package &message)
 {
 //std::cout<<"Sending "<<a.toString()<<std::endl;
 	rebuildMutex.lock();
 	const bool localRebuilded = rebuilded;
 	rebuilded = false;
 
-	unsigned long long id = 0;
-	if(!lastPackages.empty())id = lastPackages.back().first + 1;
+	const unsigned long long id = lastPackages.nextId();
 
 	//Check if in the phase of rebuilding
 	if(localRebuilded)
@@ -158,34 +520,89 @@ bool ClusterObjectSerialized::sendPackage(const Package &a, AnswerPackage *answe
 		return false;
 	}
 
-	//Not rebuilding, so package is legal and can be remembered
-	packageToRemember(id, a);
+	//Not rebuilding, so packages are legal and can be remembered.
+	//The packages are performed in the order of their ids,
+	//before any package of another member is received
+	const LocalAddress local;
+	Package tempAnswer;
+	Package tempToSend;
+	for(std::size_t i = 0; i < batch.size(); ++i)
+	{
+		packageToRemember(id + i, batch[i]->package);
+		if(batch[i]->perform)
+		{
+			const Package p(batch[i]->package);
+			tempAnswer.clear();
+			tempToSend.clear();
+			perform(local, p, tempAnswer, tempToSend);
+		}
+	}
+	snapshotIfDue();
+
+	//The packages are on the disk before they are sent
+	syncWriteAheadLog();
 	rebuildMutex.unlock();
 
 //std::cout<<"Sent "<<a.toString()<<" ("<<id<<")"<<std::endl;
-	Package message;
-	message<<ClusterObjectSerializedType::other;
-	message<<id;
-	message<<a;
-	return ClusterObject::ClusterObject_send(addCurrentSignature(message), answer);
+	//The receiver reads the packages in the Format of the message
+	message.setFormat(batch.front()->package.getFormat());
+
+	//The headers are added in front of the content
+	if(batch.size() == 1)
+	{
+		message<<batch.front()->package;
+		message.prependInteger(id);
+		message.prepend(ClusterObjectSerializedType::other);
+		return true;
+	}
+
+	//Every package of a batch starts with its length
+	for(const Submission *s : batch)
+	{
+		message.writeLength(s->package.getLength());
+		message<<s->package;
+	}
+	message.prependInteger(uint64_t(batch.size()));
+	message.prependInteger(id);
+	message.prepend(ClusterObjectSerializedType::batch);
+	return true;
 }
 
 bool ClusterObjectSerialized::sendPackageUnserialized(const Package &a, AnswerPackage *answer)
 {
-	Package message;
-	message<<ClusterObjectSerializedType::other_ask;
-	message<<a;
+	Package message(a);
+	message.prepend(ClusterObjectSerializedType::other_ask);
 	return ClusterObject::ClusterObject_send(addCurrentSignature(message), answer);
 }
 
+void ClusterObjectSerialized::sendPackageUnserializedAsync(const Package &a, AnswerPackage *answer, function<void(bool)> callback)
+{
+	Package message(a);
+	message.prepend(ClusterObjectSerializedType::other_ask);
+	ClusterObject::ClusterObject_sendAsync(addCurrentSignature(message), answer, callback);
+}
+
+future<bool> ClusterObjectSerialized::sendPackageUnserializedFuture(const Package &a, AnswerPackage *answer)
+{
+	shared_ptr<promise<bool> > p(new promise<bool>());
+	sendPackageUnserializedAsync(a, answer, [p](bool success){ p->set_value(success); });
+	return p->get_future();
+}
+
 bool ClusterObjectSerialized::askPackage(const Address &ip, const Package &a, Package *answer)
 {
-	Package message;
-	message<<ClusterObjectSerializedType::other_ask;
-	message<<a;
+	Package message(a);
+	message.prepend(ClusterObjectSerializedType::other_ask);
 	return ClusterObject::ClusterObject_ask(ip, addCurrentSignature(message), answer);
 }
 
+void ClusterObjectSerialized::askPackageAsync(const Address &ip, const Package &a, Package *answer, function<void(bool)> callback)
+{
+	Package message(a);
+	message.prepend(ClusterObjectSerializedType::other_ask);
+	ClusterObject::ClusterObject_askAsync(ip, addCurrentSignature(message), answer, callback);
+}
+
 bool ClusterObjectSerialized::received(const Address &ip, const Package &message, Package &answer, Package &to_send)
 {
 	bool success = false;
@@ -202,20 +619,14 @@ bool ClusterObjectSerialized::received(const Address &ip, const Package &message
 		case ClusterObjectSerializedOperation::get_package:
 		{
 			unsigned long long id;
-			if(!(message>>id))return false;
-			Package *p = nullptr;
+			if(!message.readInteger(id))return false;
 			rebuildMutex.lock();
-			for(auto &pkg : lastPackages)
-			{
-				if(id == pkg.first)
-				{
-					p = &pkg.second;
-					break;
-				}
-			}
 
-			//Desired package found
-			if(p)answer<<(*p);
+			//Desired package found. A package which was created
+			//in another Format than the one of the request can't
+			//be read by the other member, it needs to rebuild
+			const Package *p = lastPackages.find(id);
+			if(p && p->getFormat() == answer.getFormat())answer<<(*p);
 
 			rebuildMutex.unlock();
 			break;
@@ -223,17 +634,88 @@ bool ClusterObjectSerialized::received(const Address &ip, const Package &message
 		case ClusterObjectSerializedOperation::full_data:
 		{
 			rebuildMutex.lock();
-			uint64_t length = 0;
-			if(lastPackages.empty())answer<<length;
-			else
+			writeRebuildHeader(answer);
+			getRebuildPackage(answer);
+			rebuildMutex.unlock();
+			break;
+		}
+		case ClusterObjectSerializedOperation::full_data_chunk:
+		{
+			uint64_t position;
+			if(!message.readInteger(position))return false;
+
+			//The mutex is only locked while one chunk
+			//is created so that the writers don't stall
+			Package chunk;
+			rebuildMutex.lock();
+			const uint64_t snapshot = lastPackages.nextId();
+			if(position == 0)writeRebuildHeader(chunk);
+			const bool last = getRebuildChunk(chunk, position, rebuildChunkSize);
+			rebuildMutex.unlock();
+
+			//The receiver uses the snapshot to check
+			//that the data didn't change in between
+			chunk.prependInteger(position);
+			chunk.prependInteger(snapshot);
+			chunk.prepend(last);
+			answer<<chunk;
+			break;
+		}
+		case ClusterObjectSerializedOperation::get_packages:
+		{
+			unsigned long long from;
+			unsigned long long to;
+			if(!message.readInteger(from) || !message.readInteger(to))return false;
+
+			//The answer is limited like a chunk of rebuild
+			//data. The rest is retrieved with another request.
+			//Every package is sent with its Digest so that
+			//the receiver can check it
+			Package packages;
+			uint64_t count = 0;
+			rebuildMutex.lock();
+			for(unsigned long long i = from; i < to && packages.getLength() < rebuildChunkSize; ++i, ++count)
 			{
-				length = lastPackages.back().second.getLength();
-				answer<<length;
-				answer<<lastPackages.back().first;
-				answer<<lastPackages.back().second;
+				const Package *p = lastPackages.find(i);
+				uint32_t digest;
+				if(!p || p->getFormat() != answer.getFormat() || !lastPackages.findDigest(i, digest))break;
+				packages<<digest;
+				packages.writeLength(p->getLength());
+				packages<<(*p);
 			}
-			getRebuildPackage(answer);
 			rebuildMutex.unlock();
+
+			answer<<true;
+			answer.writeInteger(count);
+			answer<<packages;
+			break;
+		}
+		case ClusterObjectSerializedOperation::get_digest:
+		{
+			unsigned long long from;
+			unsigned long long to;
+			if(!message.readInteger(from) || !message.readInteger(to))return false;
+
+			//The Digests of the packages are known, so
+			//the packages themselves are not read
+			bool complete = true;
+			uint32_t digest = 0;
+			rebuildMutex.lock();
+			for(unsigned long long i = from; i < to && complete; ++i)
+			{
+				uint32_t packageDigest;
+				if(lastPackages.findDigest(i, packageDigest))digest = Digest::combine(digest, packageDigest);
+				else complete = false;
+			}
+			rebuildMutex.unlock();
+
+			//Members which don't remember all
+			//packages of the range don't answer
+			if(complete)
+			{
+				answer<<true;
+				answer.writeInteger(digest);
+			}
 			break;
 		}
 		default:
@@ -249,147 +731,443 @@ bool ClusterObjectSerialized::received(const Address &ip, const Package &message
 	case ClusterObjectSerializedType::other:
 	{
 		unsigned long long id;
-		if(!(message>>id))return false;
+		if(!message.readInteger(id))return false;
 
 		rebuildMutex.lock();
+		success = receivedSerialized(ip, id, message.subPackageFromCurrentPosition(), answer, to_send);
+		syncWriteAheadLog();
+		rebuildMutex.unlock();
+		break;
+	}
+	case ClusterObjectSerializedType::batch:
+	{
+		unsigned long long id;
+		uint64_t count;
+		if(!message.readInteger(id) || !message.readInteger(count))return false;
 
-		unsigned long long checkId = 0;
-		if(!lastPackages.empty())checkId = lastPackages.back().first + 1;
-
-		//Check if no errors happened
-		if(id > checkId)
+		success = true;
+		rebuildMutex.lock();
+		for(uint64_t i = 0; i < count; ++i, ++id)
 		{
-//			std::cout<<"Missed package! Asking: "<<checkId<<" to "<<(id-1)<<std::endl;
-
-			bool needToRebuild = true;
-			rebuilded = true;
+			uint64_t length;
+			Package pkg;
+			pkg.setFormat(message.getFormat());
+			if(!message.readLength(length) || length > message.getRemaining() || !message.getAndNext(pkg.extend((std::size_t)length), (std::size_t)length))
+			{
+				success = false;
+				break;
+			}
 
-			Package tempAnswer;
-			Package tempToSend;
+			//Every package gets its own answer
+			Package packageAnswer;
+			packageAnswer.setFormat(answer.getFormat());
+			success = receivedSerialized(ip, id, pkg, packageAnswer, to_send) && success;
+			answer.writeLength(packageAnswer.getLength());
+			answer<<packageAnswer;
+		}
+		syncWriteAheadLog();
+		rebuildMutex.unlock();
+		break;
+	}
+	default:
+		//Error
+		success = false;
+		break;
+	}
 
-			//Oops we missed at least one package!
-			//Get packages before we perform current package
-			for(unsigned long long i = checkId; i < id; ++i)
-			{
-				tempAnswer.clear();
-				tempToSend.clear();
+	return success;
+}
 
-				needToRebuild = true;
+bool ClusterObjectSerialized::receivedSerialized(const Address &ip, unsigned long long id, const Package &pkg, Package &answer, Package &to_send)
+{
+	bool success = false;
+	const unsigned long long checkId = lastPackages.nextId();
 
-				AnswerPackage a;
-				Package toSend;
-				toSend<<ClusterObjectSerializedType::mine;
-				toSend<<ClusterObjectSerializedOperation::get_package;
-				toSend<<i;
-				ClusterObject::sendPackage(toSend, &a);
+	//Check if no errors happened
+	if(id > checkId)
+	{
+//		std::cout<<"Missed package! Asking: "<<checkId<<" to "<<(id-1)<<std::endl;
 
-				bool first = true;
-				auto firstPackage = a.cbegin();
-				for(auto it = a.cbegin(); it != a.cend(); ++it)
-				{
-					const Package &pkg = it->second;
-					if(first)
-					{
-						if(pkg.emptyOrNull())break;
-						else needToRebuild = false;
-
-						packageToRemember(i, pkg);
-						perform(*it->first, pkg, tempAnswer, tempToSend);
-
-						first = false;
-					}
-					else
-					{
-						if(pkg != firstPackage->second)
-						{
-							//Whole (local) network is corrupted. Rebuilding...
-							needToRebuild = true;
-							break;
-						}
-					}
-				}
+		rebuilded = true;
 
-				//Package is missing or packages are not equal
-				if(needToRebuild)break;
-			}
+		//Oops we missed at least one package! Get
+		//packages before we perform current package.
+		//Older versions send them one by one
+		bool supported = true;
+		bool needToRebuild = !catchUp(ip, checkId, id, supported);
+		if(!supported)needToRebuild = !catchUpOneByOne(checkId, id);
 
-			if(needToRebuild)
-			{
-//				std::cout<<"Rebuilding from "<<ip.address<<std::endl;
-				Package p;
-				Package a;
-				p<<ClusterObjectSerializedType::mine;
-				p<<ClusterObjectSerializedOperation::full_data;
-				ClusterObject::askPackage(ip, p, &a);
-				rebuildAll(a, ip);
-				success = true;
-			}
-			else
-			{
-				//Remember package if we managed to rebuild the object
-				packageToRemember(id, message.subPackageFromCurrentPosition());
-				success = perform(ip, message, answer, to_send);
-			}
-		}
-		else if(id < checkId)
+		if(needToRebuild)
 		{
-//			std::cout<<"Someone sent a wrong package. Ignoring: "<<id<<". Expected "<<checkId<<std::endl;
-			//Returning true which means that the
-			//Package was for ClusterObjectSerialized.
-			//This means that the child object doesn't
-			//perform this package
+//			std::cout<<"Rebuilding from "<<ip.toString()<<std::endl;
+			rebuildFrom(ip);
 			success = true;
 		}
 		else
 		{
-			//Only remembering correct packages
+			//Remember package if we managed to rebuild the object
+			packageToRemember(id, pkg);
+			success = perform(ip, pkg, answer, to_send);
+		}
+	}
+	else if(id < checkId)
+	{
+//		std::cout<<"Someone sent a wrong package. Ignoring: "<<id<<". Expected "<<checkId<<std::endl;
+		//Returning true which means that the
+		//Package was for ClusterObjectSerialized.
+		//This means that the child object doesn't
+		//perform this package
+		success = true;
+	}
+	else
+	{
+		//Only remembering correct packages
 //std::cout<<id;
-			packageToRemember(id, message.subPackageFromCurrentPosition());
-			success = perform(ip, message, answer, to_send);
-			rebuilded = false;
+		packageToRemember(id, pkg);
+		success = perform(ip, pkg, answer, to_send);
+		rebuilded = false;
+	}
+
+	//Every remembered package is performed now
+	snapshotIfDue();
+
+	return success;
+}
+
+bool ClusterObjectSerialized::catchUp(const Address &address, unsigned long long from, unsigned long long to, bool &supported)
+{
+	//The other members confirm the range with its digest
+	//while the packages are retrieved from the given member
+	shared_ptr<AnswerPackage> digests(new AnswerPackage());
+	Package digestRequest;
+	digestRequest<<ClusterObjectSerializedType::mine;
+	digestRequest<<ClusterObjectSerializedOperation::get_digest;
+	digestRequest.writeInteger(from);
+	digestRequest.writeInteger(to);
+	shared_ptr<promise<bool> > confirmed(new promise<bool>());
+	future<bool> confirmation = confirmed->get_future();
+	ClusterObject::sendPackageAsync(digestRequest, digests.get(), [confirmed,digests](bool success){ confirmed->set_value(success); });
+
+	uint32_t digest = 0;
+	if(fetchPackages(address, from, to, digest, supported) != to)return false;
+
+	//rebuildMutex is locked, but the broadcast is finished by
+	//other threads which might need it, e.g. while a member
+	//joins. So the confirmation is only awaited for some time
+	if(confirmation.wait_for(chrono::seconds(confirmationTimeout)) != future_status::ready)return true;
+
+	for(auto it = digests->cbegin(); it != digests->cend(); ++it)
+	{
+		const Package &a = it->second;
+		bool valid;
+		uint32_t otherDigest;
+		if(a.emptyOrNull() || !(a>>valid) || !a.readInteger(otherDigest))continue;
+
+		//Whole (local) network is corrupted
+		if(otherDigest != digest)return false;
+	}
+
+	return true;
+}
+
+unsigned long long ClusterObjectSerialized::fetchPackages(const Address &address, unsigned long long from, unsigned long long to, uint32_t &digest, bool &supported)
+{
+	Package tempAnswer;
+	Package tempToSend;
+	unsigned long long next = from;
+	for(bool complete = true; next < to && complete; )
+	{
+		Package request;
+		Package range;
+		request<<ClusterObjectSerializedType::mine;
+		request<<ClusterObjectSerializedOperation::get_packages;
+		request.writeInteger(next);
+		request.writeInteger(to);
+		if(!ClusterObject::askPackage(address, request, &range))break;
+
+		//Older versions don't know the operation
+		if(next == from && range.emptyOrNull())
+		{
+			supported = false;
+			break;
 		}
 
-		rebuildMutex.unlock();
+		//The member doesn't remember the next package
+		bool valid;
+		uint64_t count;
+		if(!(range>>valid) || !range.readInteger(count) || count == 0)break;
 
-		break;
+		for(uint64_t i = 0; i < count; ++i, ++next)
+		{
+			uint32_t packageDigest;
+			uint64_t length;
+			Package pkg;
+			if(!(range>>packageDigest) || !range.readLength(length) || length > range.getRemaining() || !range.getAndNext(pkg.extend((std::size_t)length), (std::size_t)length))
+			{
+				complete = false;
+				break;
+			}
+
+			//The package was corrupted on the way
+			if(Digest::compute(pkg) != packageDigest)
+			{
+				complete = false;
+				break;
+			}
+
+			tempAnswer.clear();
+			tempToSend.clear();
+			packageToRemember(next, pkg, packageDigest);
+			perform(address, pkg, tempAnswer, tempToSend);
+			digest = Digest::combine(digest, packageDigest);
+		}
 	}
-	default:
-		//Error
-		success = false;
-		break;
+
+	return next;
+}
+
+bool ClusterObjectSerialized::continueRestored(const Address &address)
+{
+	//The master needs to remember the last restored
+	//package, otherwise it is not known whether
+	//the object was changed in a different way
+	const unsigned long long last = lastPackages.lastId();
+	uint32_t localDigest;
+	if(!lastPackages.findDigest(last, localDigest))return false;
+
+	Package request;
+	Package answer;
+	request<<ClusterObjectSerializedType::mine;
+	request<<ClusterObjectSerializedOperation::get_digest;
+	request.writeInteger(last);
+	request.writeInteger(last + 1);
+	if(!ClusterObject::askPackage(address, request, &answer))return false;
+
+	bool valid;
+	uint32_t digest;
+	if(answer.emptyOrNull() || !(answer>>valid) || !answer.readInteger(digest))return false;
+	if(digest != Digest::combine(0, localDigest))return false;
+
+	//It is not known how many packages were missed, so
+	//they are retrieved until the master has no more.
+	//The master only sends packages in the Format of the
+	//request, which is the one of the restored packages
+	Package::FormatScope scope(lastPackages.last().getFormat());
+	uint32_t missedDigest = 0;
+	bool supported = true;
+	fetchPackages(address, last + 1, numeric_limits<unsigned long long>::max(), missedDigest, supported);
+	snapshotIfDue();
+	syncWriteAheadLog();
+	return supported;
+}
+
+bool ClusterObjectSerialized::catchUpOneByOne(unsigned long long from, unsigned long long to)
+{
+	Package tempAnswer;
+	Package tempToSend;
+
+	for(unsigned long long i = from; i < to; ++i)
+	{
+		tempAnswer.clear();
+		tempToSend.clear();
+
+		bool needToRebuild = true;
+
+		AnswerPackage a;
+		Package toSend;
+		toSend<<ClusterObjectSerializedType::mine;
+		toSend<<ClusterObjectSerializedOperation::get_package;
+		toSend.writeInteger(i);
+		ClusterObject::sendPackage(toSend, &a);
+
+		bool first = true;
+		auto firstPackage = a.cbegin();
+		for(auto it = a.cbegin(); it != a.cend(); ++it)
+		{
+			const Package &pkg = it->second;
+			if(first)
+			{
+				if(pkg.emptyOrNull())break;
+				else needToRebuild = false;
+
+				packageToRemember(i, pkg);
+				perform(*it->first, pkg, tempAnswer, tempToSend);
+
+				first = false;
+			}
+			else
+			{
+				if(pkg != firstPackage->second)
+				{
+					//Whole (local) network is corrupted. Rebuilding...
+					needToRebuild = true;
+					break;
+				}
+			}
+		}
+
+		//Package is missing or packages are not equal
+		if(needToRebuild)return false;
 	}
 
-	return success;
+	return true;
 }
 
 void ClusterObjectSerialized::packageToRemember(const unsigned long long id, const Package &pkg)
 {
-	lastPackages.push_back(std::pair<unsigned long long,Package>(id, pkg));
-	while(lastPackages.size() > maxPackagesToRemember)lastPackages.pop_front();
+	packageToRemember(id, pkg, Digest::compute(pkg));
 }
 
-void ClusterObjectSerialized::rebuildAll(const Package &a, const Address &address)
+void ClusterObjectSerialized::packageToRemember(const unsigned long long id, const Package &pkg, uint32_t digest)
+{
+	lastPackages.add(id, pkg, digest);
+	if(writeAheadLog && !writeAheadLog->append(id, pkg, digest))closeWriteAheadLog();
+}
+
+void ClusterObjectSerialized::writeSnapshot()
+{
+	//The snapshot contains the same
+	//as the full data for a rebuild
+	Package snapshot;
+	writeRebuildHeader(snapshot);
+	getRebuildPackage(snapshot);
+	if(!writeAheadLog->writeSnapshot(lastPackages.nextId(), snapshot))closeWriteAheadLog();
+}
+
+void ClusterObjectSerialized::snapshotIfDue()
+{
+	if(writeAheadLog && writeAheadLog->getAppended() >= snapshotInterval)writeSnapshot();
+}
+
+void ClusterObjectSerialized::syncWriteAheadLog()
+{
+	if(writeAheadLog && !writeAheadLog->sync())closeWriteAheadLog();
+}
+
+void ClusterObjectSerialized::closeWriteAheadLog()
+{
+	delete writeAheadLog;
+	writeAheadLog = nullptr;
+}
+
+bool ClusterObjectSerialized::getRebuildChunk(Package &out, uint64_t &/*position*/, std::size_t /*maxSize*/) const
+{
+	getRebuildPackage(out);
+	return true;
+}
+
+void ClusterObjectSerialized::rebuildChunk(const Package &chunk, bool first, const Address &address)
+{
+	if(first)rebuild(chunk, address);
+}
+
+void ClusterObjectSerialized::writeRebuildHeader(Package &out) const
+{
+	uint64_t length = 0;
+	if(lastPackages.empty())out<<length;
+	else
+	{
+		length = lastPackages.last().getLength();
+		out<<length;
+		out<<lastPackages.lastId();
+		out<<lastPackages.last();
+	}
+}
+
+bool ClusterObjectSerialized::readRebuildHeader(const Package &a)
 {
 	lastPackages.clear();
 
 	uint64_t length;
 
 	//Read all Packages to remember
-	if(!(a>>length))return;
+	if(!(a>>length))return false;
 	if(length > 0)
 	{
-		vector<char> data((std::size_t)length);
 		unsigned long long id;
-		if(!(a>>id))return;
-		a.getAndNext(&data[0], (std::size_t)length);
+		if(!(a>>id))return false;
 		Package p;
-		p.write(&data[0], (std::size_t)length);
-		lastPackages.push_back(std::pair<unsigned long long,Package>(id, p));
+		if(!a.getAndNext(p.extend((std::size_t)length), (std::size_t)length))return false;
+		lastPackages.add(id, p);
 	}
 
+	return true;
+}
+
+void ClusterObjectSerialized::rebuildAll(const Package &a, const Address &address)
+{
+	if(!readRebuildHeader(a))return;
+
 	//Rebuild subobject
 	rebuild(a, address);
 
 //std::cout<<"Last rebuild id was "<<id<<std::endl;
 //std::cout<<"Rebuilded"<<std::endl;
 }
+
+void ClusterObjectSerialized::rebuildFrom(const Address &address)
+{
+	bool supported = true;
+	bool rebuiltInChunks = false;
+	for(unsigned int i = 0; i < maxChunkedRebuildAttempts && supported && !rebuiltInChunks; ++i)
+	{
+		rebuiltInChunks = rebuildInChunks(address, supported);
+	}
+
+	//Older versions and data which changes
+	//too often are rebuilt all at once
+	if(!rebuiltInChunks)
+	{
+		Package p;
+		Package a;
+		p<<ClusterObjectSerializedType::mine;
+		p<<ClusterObjectSerializedOperation::full_data;
+		ClusterObject::askPackage(address, p, &a);
+		rebuildAll(a, address);
+	}
+
+	//The log continues with the rebuilt object
+	if(writeAheadLog)writeSnapshot();
+}
+
+bool ClusterObjectSerialized::rebuildInChunks(const Address &address, bool &supported)
+{
+	uint64_t position = 0;
+	uint64_t snapshot = 0;
+	bool last = false;
+
+	for(bool first = true; !last; first = false)
+	{
+		Package p;
+		Package chunk;
+		p<<ClusterObjectSerializedType::mine;
+		p<<ClusterObjectSerializedOperation::full_data_chunk;
+		p.writeInteger(position);
+		if(!ClusterObject::askPackage(address, p, &chunk))return false;
+
+		//Older versions don't know the operation
+		if(first && chunk.emptyOrNull())
+		{
+			supported = false;
+			return false;
+		}
+
+		uint64_t chunkSnapshot;
+		if(!(chunk>>last))return false;
+		if(!chunk.readInteger(chunkSnapshot))return false;
+		if(!chunk.readInteger(position))return false;
+
+		if(first)
+		{
+			snapshot = chunkSnapshot;
+			if(!readRebuildHeader(chunk))return false;
+		}
+
+		//The chunks don't fit together
+		else if(chunkSnapshot != snapshot)return false;
+
+		rebuildChunk(chunk, first, address);
+	}
+
+	return true;
+}
@@ -128,7 +128,7 @@ void ClusterSpeedTest::printStatistics() const
 	{
 		if(it.second.empty())
 		{
-			cout<<"No data for "<<it.first->address<<endl;
+			cout<<"No data for "<<it.first->toString()<<endl;
 			continue;
 		}
 
@@ -143,7 +143,7 @@ void ClusterSpeedTest::printStatistics() const
 		}
 		avg /= it.second.size();
 
-		cout<<it.first->address<<": AVG: "<<avg<<", MIN: "<<min<<", MAX: "<<max<<endl;
+		cout<<it.first->toString()<<": AVG: "<<avg<<", MIN: "<<min<<", MAX: "<<max<<endl;
 	}
 	mapMutex.unlock();
 }
@@ -0,0 +1,195 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/compression.hpp>
+#include <stdint.h>
+#include <string.h>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The amount of bits of the hash
+  * which finds the matches
+ **/
+static const unsigned int hashBits = 12;
+
+/**
+  * The minimum length of a match
+ **/
+static const std::size_t minMatch = 4;
+
+/**
+  * The last bytes are always literals
+ **/
+static const std::size_t lastLiterals = 5;
+
+/**
+  * A match needs to start this
+  * many bytes before the end
+ **/
+static const std::size_t matchFindLimit = 12;
+
+/**
+  * The maximum distance of a match
+ **/
+static const std::size_t maxOffset = 65535;
+
+const char Compression::name[] = "lz4";
+
+/**
+  * Reads 4 bytes at the given position
+ **/
+static inline uint32_t read32(const char *data)
+{
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+/**
+  * Returns the position in the hash
+  * table of the given 4 bytes
+ **/
+static inline uint32_t hashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761U) >> (32 - hashBits);
+}
+
+/**
+  * Writes the rest of a length which
+  * doesn't fit into the token
+ **/
+static void writeLength(vector<char> &out, std::size_t length)
+{
+	length -= 15;
+	for(; length >= 255; length -= 255)out.push_back(char(255));
+	out.push_back(char(length));
+}
+
+/**
+  * Reads the rest of a length which
+  * doesn't fit into the token
+ **/
+static bool readLength(const char *data, std::size_t dataLength, std::size_t &position, std::size_t &length)
+{
+	unsigned char byte;
+	do
+	{
+		if(position == dataLength)return false;
+		byte = (unsigned char)data[position++];
+		length += byte;
+	}
+	while(byte == 255);
+
+	return true;
+}
+
+/**
+  * Writes the literals from anchor to position
+  * and the match of the given length
+ **/
+static void writeSequence(vector<char> &out, const char *data, std::size_t anchor, std::size_t position, std::size_t offset, std::size_t matchLength)
+{
+	const std::size_t literals = position - anchor;
+	const std::size_t match = matchLength - minMatch;
+
+	out.push_back(char(((literals < 15 ? literals : 15) << 4) | (match < 15 ? match : 15)));
+	if(literals >= 15)writeLength(out, literals);
+	out.insert(out.end(), data + anchor, data + position);
+	out.push_back(char(offset & 0xFF));
+	out.push_back(char(offset >> 8));
+	if(match >= 15)writeLength(out, match);
+}
+
+bool Compression::compress(const char *data, std::size_t length, vector<char> &out)
+{
+	out.clear();
+	out.reserve(length);
+
+	vector<std::size_t> table(std::size_t(1) << hashBits, 0);
+	std::size_t anchor = 0;
+	std::size_t position = 0;
+
+	if(length > matchFindLimit)
+	{
+		const std::size_t matchLimit = length - lastLiterals;
+		while(position < length - matchFindLimit)
+		{
+			const uint32_t sequence = read32(data + position);
+			std::size_t &entry = table[hashSequence(sequence)];
+			const std::size_t candidate = entry;
+			entry = position;
+
+			//Data without matches is skipped faster
+			if(candidate >= position || position - candidate > maxOffset || read32(data + candidate) != sequence)
+			{
+				position += 1 + ((position - anchor) >> 6);
+				continue;
+			}
+
+			std::size_t matchLength = minMatch;
+			while(position + matchLength < matchLimit && data[candidate + matchLength] == data[position + matchLength])++matchLength;
+
+			writeSequence(out, data, anchor, position, position - candidate, matchLength);
+			position += matchLength;
+			anchor = position;
+
+			if(out.size() >= length)return false;
+		}
+	}
+
+	//The last sequence only consists of literals
+	const std::size_t literals = length - anchor;
+	out.push_back(char((literals < 15 ? literals : 15) << 4));
+	if(literals >= 15)writeLength(out, literals);
+	out.insert(out.end(), data + anchor, data + length);
+
+	return out.size() < length;
+}
+
+bool Compression::decompress(const char *data, std::size_t length, std::size_t originalLength, char *out)
+{
+	if(originalLength / maxRatio > length)return false;
+
+	std::size_t in = 0;
+	std::size_t position = 0;
+	while(in < length)
+	{
+		const unsigned char token = (unsigned char)data[in++];
+
+		std::size_t literals = token >> 4;
+		if(literals == 15 && !readLength(data, length, in, literals))return false;
+		if(literals > length - in || literals > originalLength - position)return false;
+		memcpy(out + position, data + in, literals);
+		in += literals;
+		position += literals;
+
+		//The last sequence has no match
+		if(in == length)break;
+
+		if(length - in < 2)return false;
+		const std::size_t offset = (unsigned char)data[in] | std::size_t((unsigned char)data[in+1]) << 8;
+		in += 2;
+		if(offset == 0 || offset > position)return false;
+
+		std::size_t matchLength = token & 15;
+		if(matchLength == 15 && !readLength(data, length, in, matchLength))return false;
+		matchLength += minMatch;
+		if(matchLength > originalLength - position)return false;
+
+		//The match may overlap with the bytes it creates
+		char *destination = out + position;
+		const char *source = destination - offset;
+		if(offset >= matchLength)memcpy(destination, source, matchLength);
+		else for(std::size_t i = 0; i < matchLength; ++i)destination[i] = source[i];
+		position += matchLength;
+	}
+
+	return position == originalLength;
+}
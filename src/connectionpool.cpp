@@ -0,0 +1,272 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/connectionpool.hpp>
+#include <cluster/channel.hpp>
+#include <cluster/prototypes/protocol.hpp>
+#include <cluster/prototypes/communicationsocket.hpp>
+
+using namespace std;
+using namespace cluster;
+
+ConnectionPool::ConnectionPool(const Protocol &p_protocol, unsigned int ui_maxIdleTime, unsigned int ui_maxIdlePerAddress) :
+	protocol(&p_protocol),
+	maxIdleTime(ui_maxIdleTime),
+	maxIdlePerAddress(ui_maxIdlePerAddress),
+	sockets(),
+	multiplexing(false),
+	compression(true),
+	messageCallback(nullptr),
+	channels(),
+	plainAddresses(),
+	socketsMutex(),
+	executor()
+{}
+
+ConnectionPool::~ConnectionPool()
+{
+	//The tasks might still use connections
+	executor.shutdown();
+	clear();
+}
+
+CommunicationSocket* ConnectionPool::get(const Address &address, bool &reused)
+{
+	CommunicationSocket *socket = nullptr;
+	const time_t now = time(nullptr);
+
+	socketsMutex.lock();
+	auto it = sockets.find(AddressKey(address));
+	if(it != sockets.end())
+	{
+		//The most recently used connection is taken first
+		while(!socket && !it->second.empty())
+		{
+			CommunicationSocket *s = it->second.back().first;
+			const time_t idleSince = it->second.back().second;
+			it->second.pop_back();
+
+			//If there is something to read on an unused
+			//connection, the other side has closed it
+			if(difftime(now, idleSince) > maxIdleTime || s->poll(0))delete s;
+			else socket = s;
+		}
+		if(it->second.empty())sockets.erase(it);
+	}
+	socketsMutex.unlock();
+
+	reused = (socket != nullptr);
+	if(!socket)socket = protocol->createCommunicationSocket(address);
+
+	return socket;
+}
+
+void ConnectionPool::put(CommunicationSocket *socket)
+{
+	socketsMutex.lock();
+	auto &unused = sockets[AddressKey(socket->getAddress())];
+	if(unused.size() < maxIdlePerAddress)
+	{
+		unused.push_back(pair<CommunicationSocket*,time_t>(socket, time(nullptr)));
+		socket = nullptr;
+	}
+	socketsMutex.unlock();
+
+	//Too many unused connections
+	delete socket;
+}
+
+shared_ptr<Channel> ConnectionPool::getChannel(const Address &address, bool &reused, bool &connected)
+{
+	shared_ptr<Channel> channel;
+	shared_ptr<Channel> closed;
+	const time_t now = time(nullptr);
+
+	reused = false;
+	connected = true;
+	if(!multiplexing)return nullptr;
+
+	socketsMutex.lock();
+
+	//The other side is asked again after
+	//maxIdleTime whether it supports Channels
+	auto plain = plainAddresses.find(AddressKey(address));
+	if(plain != plainAddresses.end() && difftime(now, plain->second) <= maxIdleTime)
+	{
+		socketsMutex.unlock();
+		return nullptr;
+	}
+
+	auto it = channels.find(AddressKey(address));
+	if(it != channels.end())
+	{
+		if(it->second->isOpen())channel = it->second;
+		else
+		{
+			closed = it->second;
+			channels.erase(it);
+		}
+	}
+	socketsMutex.unlock();
+
+	if(closed)closed->close();
+	if(channel)
+	{
+		reused = true;
+		return channel;
+	}
+
+	//Establish a new Channel
+	CommunicationSocket *socket = protocol->createCommunicationSocket(address);
+	bool supported = false;
+	if(!socket || !Channel::handshake(socket, supported))
+	{
+		delete socket;
+		connected = false;
+		return nullptr;
+	}
+
+	if(!supported)
+	{
+		//The connection can still be used without Channel
+		socketsMutex.lock();
+		plainAddresses[AddressKey(address)] = now;
+		socketsMutex.unlock();
+		put(socket);
+		return nullptr;
+	}
+
+	channel = Channel::create(socket, messageCallback, 10, compression);
+
+	//Another thread might have established
+	//a Channel in the meantime
+	socketsMutex.lock();
+	shared_ptr<Channel> &existing = channels[AddressKey(address)];
+	if(existing && existing->isOpen())
+	{
+		closed = channel;
+		channel = existing;
+	}
+	else
+	{
+		closed = existing;
+		existing = channel;
+	}
+	socketsMutex.unlock();
+
+	if(closed)closed->close();
+
+	return channel;
+}
+
+void ConnectionPool::removeChannel(const shared_ptr<Channel> &channel)
+{
+	socketsMutex.lock();
+	auto it = channels.find(AddressKey(channel->getAddress()));
+	if(it != channels.end() && it->second == channel)channels.erase(it);
+	socketsMutex.unlock();
+
+	channel->close();
+}
+
+void ConnectionPool::remove(const Address &address)
+{
+	list<pair<CommunicationSocket*,time_t> > toClose;
+	shared_ptr<Channel> channel;
+
+	socketsMutex.lock();
+	auto it = sockets.find(AddressKey(address));
+	if(it != sockets.end())
+	{
+		toClose.swap(it->second);
+		sockets.erase(it);
+	}
+	auto channelIt = channels.find(AddressKey(address));
+	if(channelIt != channels.end())
+	{
+		channel = channelIt->second;
+		channels.erase(channelIt);
+	}
+	plainAddresses.erase(AddressKey(address));
+	socketsMutex.unlock();
+
+	for(auto &socket : toClose)
+	{
+		delete socket.first;
+	}
+	if(channel)channel->close();
+}
+
+void ConnectionPool::cleanup()
+{
+	const time_t now = time(nullptr);
+
+	socketsMutex.lock();
+	for(auto it = sockets.begin(); it != sockets.end(); )
+	{
+		//The oldest connections are at the front
+		while(!it->second.empty() && difftime(now, it->second.front().second) > maxIdleTime)
+		{
+			delete it->second.front().first;
+			it->second.pop_front();
+		}
+
+		if(it->second.empty())it = sockets.erase(it);
+		else ++it;
+	}
+
+	list<shared_ptr<Channel> > toClose;
+	for(auto it = channels.begin(); it != channels.end(); )
+	{
+		if(!it->second->isOpen() || it->second->isIdle(maxIdleTime))
+		{
+			toClose.push_back(it->second);
+			it = channels.erase(it);
+		}
+		else ++it;
+	}
+
+	for(auto it = plainAddresses.begin(); it != plainAddresses.end(); )
+	{
+		if(difftime(now, it->second) > maxIdleTime)it = plainAddresses.erase(it);
+		else ++it;
+	}
+	socketsMutex.unlock();
+
+	for(auto &channel : toClose)
+	{
+		channel->close();
+	}
+}
+
+void ConnectionPool::clear()
+{
+	list<shared_ptr<Channel> > toClose;
+
+	socketsMutex.lock();
+	for(auto &address : sockets)
+	{
+		for(auto &socket : address.second)
+		{
+			delete socket.first;
+		}
+	}
+	sockets.clear();
+	for(auto &channel : channels)
+	{
+		toClose.push_back(channel.second);
+	}
+	channels.clear();
+	plainAddresses.clear();
+	socketsMutex.unlock();
+
+	for(auto &channel : toClose)
+	{
+		channel->close();
+	}
+}
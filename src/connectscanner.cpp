@@ -0,0 +1,118 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifdef __linux__
+
+#include <cluster/connectscanner.hpp>
+#include <chrono>
+#include <map>
+#include <utility>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * Returns the size of the given socket address
+ **/
+static socklen_t addressLength(const struct sockaddr_storage &address)
+{
+	return address.ss_family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+}
+
+void ConnectScanner::scan(const vector<struct sockaddr_storage> &addresses, vector<bool> &reachable, unsigned int concurrency, unsigned int timeout)
+{
+	reachable.assign(addresses.size(), false);
+	if(concurrency == 0)concurrency = 1;
+
+	const int fd_epoll = epoll_create1(EPOLL_CLOEXEC);
+	if(fd_epoll == -1)return;
+
+	//The connects which are in progress with
+	//the index of their address and their deadline
+	map<int,pair<std::size_t,chrono::steady_clock::time_point> > connecting;
+
+	std::size_t next = 0;
+	while(next < addresses.size() || !connecting.empty())
+	{
+		//Start connects until the limit is reached
+		while(next < addresses.size() && connecting.size() < concurrency)
+		{
+			const std::size_t index = next++;
+			const struct sockaddr_storage &address = addresses[index];
+			if(address.ss_family != AF_INET && address.ss_family != AF_INET6)continue;
+
+			const int fd = socket(address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+			if(fd == -1)continue;
+
+			if(connect(fd, reinterpret_cast<const struct sockaddr*>(&address), addressLength(address)) == 0)
+			{
+				reachable[index] = true;
+				close(fd);
+				continue;
+			}
+
+			struct epoll_event event;
+			memset(&event, 0, sizeof(event));
+			event.events = EPOLLOUT;
+			event.data.fd = fd;
+			if(errno != EINPROGRESS || epoll_ctl(fd_epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+			{
+				close(fd);
+				continue;
+			}
+
+			connecting[fd] = make_pair(index, chrono::steady_clock::now() + chrono::milliseconds(timeout));
+		}
+		if(connecting.empty())continue;
+
+		//Wait until the next connect times out at most
+		const auto now = chrono::steady_clock::now();
+		auto deadline = connecting.cbegin()->second.second;
+		for(const auto &c : connecting)deadline = min(deadline, c.second.second);
+		const int wait = deadline > now ? int(chrono::duration_cast<chrono::milliseconds>(deadline - now).count()) + 1 : 0;
+
+		static const int maxEvents = 64;
+		struct epoll_event events[maxEvents];
+		const int count = epoll_wait(fd_epoll, events, maxEvents, wait);
+
+		for(int i = 0; i < count; ++i)
+		{
+			const int fd = events[i].data.fd;
+			auto it = connecting.find(fd);
+			if(it == connecting.end())continue;
+
+			int error = 0;
+			socklen_t size = sizeof(error);
+			if(getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size) == 0 && error == 0)reachable[it->second.first] = true;
+
+			close(fd);
+			connecting.erase(it);
+		}
+
+		//Give up on the connects which took too long
+		const auto end = chrono::steady_clock::now();
+		for(auto it = connecting.begin(); it != connecting.end(); )
+		{
+			if(it->second.second <= end)
+			{
+				close(it->first);
+				it = connecting.erase(it);
+			}
+			else ++it;
+		}
+	}
+
+	::close(fd_epoll);
+}
+
+#endif //__linux__
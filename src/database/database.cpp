@@ -8,8 +8,8 @@
 
 #include <cluster/database/database.hpp>
 #include <cluster/database/sqlfetchresult.hpp>
+#include <future>
 #include <iostream>
-#include <thread>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -75,21 +75,43 @@ void Database::sendToNetwork(const SQLQuery &query, mutex *m, SQLResult *result)
 	while(!send(DatabaseOperation::query, query, &answer))
 		usleep(1000);
 
-	if(result)
+	addResults(answer, m, result);
+}
+
+void Database::addResults(const AnswerPackage &answer, mutex *m, SQLResult *result)
+{
+	if(!result)return;
+
+	SQLResult res;
+	for(const auto &package : answer)
 	{
-		SQLResult res;
-		for(const auto &package : answer)
-		{
-			const Address *address = package.first;
-			const Package &pkg = package.second;
+		const Address *address = package.first;
+		const Package &pkg = package.second;
 
-			if(m)m->lock();
-			if(pkg>>res)result->add(res, *address, getOnlineClientId(*address));
-			if(m)m->unlock();
-		}
+		if(m)m->lock();
+		if(pkg>>res)result->add(res, *address, getOnlineClientId(*address));
+		if(m)m->unlock();
 	}
 }
 
+void Database::sendToNetworkWhile(const SQLQuery &query, SQLResult *result, function<void()> local)
+{
+	//The query is sent to the network without
+	//waiting while the local part is executed.
+	//The answer needs to stay valid until it is sent
+	AnswerPackage answer;
+	future<bool> sent = sendAsync(DatabaseOperation::query, query, &answer);
+	try {
+		local();
+	} catch(...) {
+		sent.wait();
+		throw;
+	}
+
+	if(sent.get())addResults(answer, nullptr, result);
+	else sendToNetwork(query, nullptr, result);
+}
+
 void Database::sendToNetwork(const Address &address, const SQLQuery &query, mutex *m, SQLResult *result)
 {
 	Package answer;
@@ -350,6 +372,46 @@ void Database::rebuild(const Package &out, const Address &address)
 	databaseMutex.unlock();
 }
 
+bool Database::getRebuildChunk(Package &out, uint64_t &position, std::size_t maxSize) const
+{
+	if(position == 0)ClusterObjectDistributed::getRebuildPackage(out);
+
+	const std::size_t start = out.getLength();
+	for(; position < tables.size() && out.getLength() - start < maxSize; ++position)
+	{
+		const Table *t = tables[(std::size_t)position];
+		out<<t->getName();
+		out<<(*t);
+	}
+	return position >= tables.size();
+}
+
+void Database::rebuildChunk(const Package &chunk, bool first, const Address &address)
+{
+	if(first)ClusterObjectDistributed::rebuild(chunk, address);
+
+	databaseMutex.lock();
+	if(first)
+	{
+		for(unsigned int i = 0; i < tables.size(); ++i)
+			delete tables[i];
+		tables.clear();
+	}
+
+	string tableName;
+	while(chunk>>tableName)
+	{
+		Table *t = new Table(tableName, string("databases/") + name);
+		if(!(chunk>>(*t)))
+		{
+			delete t;
+			break;
+		}
+		tables.push_back(t);
+	}
+	databaseMutex.unlock();
+}
+
 
 SQLResult Database::execute(SQLQuery query)
 {
@@ -363,12 +425,9 @@ SQLResult Database::execute(SQLQuery query)
 
 void Database::select(const string &table, const vector<Column> &cols, SQLResult *result, bool isCoordinator, const SQLQuery &q)
 {
-	mutex m;
 	if(isCoordinator)
 	{
-		thread th([this,q,&result,&m] () { sendToNetwork(q, &m, result); });
-		select(table, cols, result, false, q);
-		th.join();
+		sendToNetworkWhile(q, result, [this,&table,&cols,result,&q] () { select(table, cols, result, false, q); });
 	}
 	else
 	{
@@ -379,9 +438,7 @@ void Database::select(const string &table, const vector<Column> &cols, SQLResult
 		it.table = table;
 		t->select(cols, it);
 
-		m.lock();
 		if(result)result->addResult(it);
-		m.unlock();
 	}
 }
 
@@ -389,10 +446,8 @@ Table* Database::createTable(const string &tableName, SQLResult *result, bool is
 {
 	if(isCoordinator)
 	{
-		mutex m;
-		thread th([this,q,&result,&m] () { sendToNetwork(q, &m, result); });
-		Table *t = createTable(tableName, result, false, q);
-		th.join();
+		Table *t = nullptr;
+		sendToNetworkWhile(q, result, [this,&t,&tableName,result,&q] () { t = createTable(tableName, result, false, q); });
 		return t;
 	}
 	else
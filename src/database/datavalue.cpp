@@ -734,7 +734,7 @@ bool DataValue::retrieve(const Package &pkg)
 	deleteValue();
 
 	if(!(pkg>>type))return false;
-	if(!(pkg>>length))return false;
+	if(!pkg.readInteger(length))return false;
 
 	bool valueSet;
 	if(!(pkg>>valueSet))return false;
@@ -763,17 +763,17 @@ bool DataValue::retrieve(const Package &pkg)
 	case ValueType::c_time:
 	case ValueType::c_smallint:
 		value = new int16_t();
-		success = pkg>>(*static_cast<int16_t*>(value));
+		success = pkg.readInteger(*static_cast<int16_t*>(value));
 		break;
 	case ValueType::c_mediumint:
 		value = new int32_t();
-		success = pkg>>(*static_cast<int32_t*>(value));
+		success = pkg.readInteger(*static_cast<int32_t*>(value));
 		break;
 	case ValueType::c_timestamp:
 	case ValueType::c_int:
 	case ValueType::c_bigint:
 		value = new int64_t();
-		success = pkg>>(*static_cast<int64_t*>(value));
+		success = pkg.readInteger(*static_cast<int64_t*>(value));
 		break;
 	case ValueType::c_text:
 	case ValueType::c_decimal:
@@ -811,7 +811,7 @@ bool DataValue::retrieve(const Package &pkg)
 void DataValue::insert(Package &pkg) const
 {
 	pkg<<type;
-	pkg<<length;
+	pkg.writeInteger(length);
 
 	const bool valueSet = (value != nullptr);
 	pkg<<valueSet;
@@ -833,15 +833,15 @@ void DataValue::insert(Package &pkg) const
 		break;
 	case ValueType::c_time:
 	case ValueType::c_smallint:
-		pkg<<(*static_cast<const int16_t*>(value));
+		pkg.writeInteger(*static_cast<const int16_t*>(value));
 		break;
 	case ValueType::c_mediumint:
-		pkg<<(*static_cast<const int32_t*>(value));
+		pkg.writeInteger(*static_cast<const int32_t*>(value));
 		break;
 	case ValueType::c_timestamp:
 	case ValueType::c_int:
 	case ValueType::c_bigint:
-		pkg<<(*static_cast<const int64_t*>(value));
+		pkg.writeInteger(*static_cast<const int64_t*>(value));
 		break;
 	case ValueType::c_text:
 	case ValueType::c_decimal:
@@ -79,6 +79,7 @@ Table::Table(const string &str_name, const string &str_folder) :
 		vector<char> buffer(fileSize);
 		if(!colFile.read(&buffer[0], fileSize))throw SQLException("Unable to read column file");
 		Package pkg(buffer);
+		pkg.setFormat(Package::Format::fixed);
 		pkg>>columns;
 	}
 
@@ -93,6 +94,7 @@ Table::Table(const string &str_name, const string &str_folder) :
 		vector<char> buffer(fileSize);
 		if(!indFile.read(&buffer[0], fileSize))throw SQLException("Unable to read indices file");
 		Package pkg(buffer);
+		pkg.setFormat(Package::Format::fixed);
 		pkg>>indices;
 	}
 
@@ -168,7 +170,9 @@ void Table::addColumn(const Column &column)
 	//Save columns to file
 	const string columnsFileName = folder + "/" + name + ".cols";
 	ofstream colFile(columnsFileName, ios_base::binary | ios_base::trunc);
+	//The files always use the fixed Format
 	Package pkg;
+	pkg.setFormat(Package::Format::fixed);
 	pkg<<columns;
 	colFile.write(pkg.getData(), pkg.getLength());
 
@@ -176,6 +180,7 @@ void Table::addColumn(const Column &column)
 	const string indicesFileName = folder + "/" + name + ".indices";
 	ofstream indFile(indicesFileName, ios_base::binary | ios_base::trunc);
 	Package pkg2;
+	pkg2.setFormat(Package::Format::fixed);
 	pkg2<<indices;
 	indFile.write(pkg2.getData(), pkg2.getLength());
 }
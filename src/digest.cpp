@@ -0,0 +1,146 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/digest.hpp>
+#include <cluster/package.hpp>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define DIGEST_HARDWARE
+#include <nmmintrin.h>
+#endif //__x86_64__ && __GNUC__
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The reversed CRC32C polynomial
+ **/
+static const uint32_t polynomial = 0x82F63B78;
+
+/**
+  * The tables to compute the CRC32C eight
+  * bytes at once without the crc32 instruction
+ **/
+struct DigestTable
+{
+	DigestTable() :
+		entries()
+	{
+		for(uint32_t i = 0; i < 256; ++i)
+		{
+			uint32_t crc = i;
+			for(unsigned int bit = 0; bit < 8; ++bit)
+			{
+				crc = (crc & 1) ? (crc >> 1) ^ polynomial : crc >> 1;
+			}
+			entries[0][i] = crc;
+		}
+
+		for(uint32_t i = 0; i < 256; ++i)
+		{
+			for(unsigned int t = 1; t < 8; ++t)
+			{
+				entries[t][i] = (entries[t-1][i] >> 8) ^ entries[0][entries[t-1][i] & 0xFF];
+			}
+		}
+	}
+
+	uint32_t entries[8][256];
+};
+
+/**
+  * Computes the CRC32C using the tables
+ **/
+static uint32_t computeSoftware(uint32_t crc, const unsigned char *data, std::size_t size)
+{
+	static const DigestTable table;
+	const uint32_t (&t)[8][256] = table.entries;
+
+	while(size >= 8)
+	{
+		const uint32_t low = crc ^ (uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24);
+		crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+			t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+		data += 8;
+		size -= 8;
+	}
+
+	while(size--)
+	{
+		crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+	}
+
+	return crc;
+}
+
+#ifdef DIGEST_HARDWARE
+/**
+  * Computes the CRC32C using the crc32 instruction
+ **/
+__attribute__((target("sse4.2")))
+static uint32_t computeHardware(uint32_t crc, const unsigned char *data, std::size_t size)
+{
+	uint64_t crc64 = crc;
+	while(size >= 8)
+	{
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		crc64 = _mm_crc32_u64(crc64, value);
+		data += 8;
+		size -= 8;
+	}
+
+	crc = uint32_t(crc64);
+	while(size--)
+	{
+		crc = _mm_crc32_u8(crc, *data++);
+	}
+
+	return crc;
+}
+#endif //DIGEST_HARDWARE
+
+uint32_t Digest::compute(const void *data, std::size_t size, uint32_t crc)
+{
+	const unsigned char *bytes = static_cast<const unsigned char*>(data);
+
+#ifdef DIGEST_HARDWARE
+	static const bool hardware = isHardwareSupported();
+	if(hardware)return ~computeHardware(~crc, bytes, size);
+#endif //DIGEST_HARDWARE
+
+	return ~computeSoftware(~crc, bytes, size);
+}
+
+uint32_t Digest::compute(const Package &p, uint32_t crc)
+{
+	return compute(p.getData(), p.getLength(), crc);
+}
+
+uint32_t Digest::combine(uint32_t crc, uint32_t digest)
+{
+	//The byte order is fixed so that
+	//all processors get the same result
+	const unsigned char bytes[] = {
+		(unsigned char)(digest & 0xFF),
+		(unsigned char)((digest >> 8) & 0xFF),
+		(unsigned char)((digest >> 16) & 0xFF),
+		(unsigned char)(digest >> 24)
+	};
+	return compute(bytes, sizeof(bytes), crc);
+}
+
+bool Digest::isHardwareSupported()
+{
+#ifdef DIGEST_HARDWARE
+	return __builtin_cpu_supports("sse4.2");
+#else
+	return false;
+#endif //DIGEST_HARDWARE
+}
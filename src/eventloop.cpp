@@ -0,0 +1,399 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifdef __linux__
+
+#include <cluster/eventloop.hpp>
+#include <cluster/server.hpp>
+#include <cluster/package.hpp>
+#include <cluster/framing.hpp>
+#include <cluster/prototypes/listenersocket.hpp>
+#include <cluster/prototypes/communicationsocket.hpp>
+#include <limits>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The amount of bytes which are read at least
+  * with one call
+ **/
+static const std::size_t minimumReadSize = 16384;
+
+/**
+  * The receive buffer of an idle connection is
+  * released if it is bigger than this
+ **/
+static const std::size_t maximumIdleBufferSize = 1048576;
+
+EventConnection::EventConnection(CommunicationSocket *s, EventLoop *l) :
+	compression(false),
+	socket(s),
+	fd(s->getDescriptor()),
+	loop(l),
+	in(),
+	inPosition(0),
+	inEnd(0),
+	out(),
+	outPosition(0),
+	outMutex(),
+	closed(false),
+	lastActivity(time(nullptr)),
+	pending(0),
+	channel(false)
+{}
+
+EventConnection::~EventConnection()
+{
+	delete socket;
+}
+
+const Address& EventConnection::getAddress() const
+{
+	return socket->getAddress();
+}
+
+void EventConnection::send(const Package &data)
+{
+	//Sending 0 byte packages is illegal
+	static const char emptyData = '\0';
+	const char *content = data.getLength() ? data.getData() : &emptyData;
+	const std::size_t messageSize = data.getLength() ? data.getLength() : 1;
+
+	char header[Framing::maxHeaderSize];
+	const std::size_t headerSize = Framing::encodeHeader(messageSize, header);
+
+	outMutex.lock();
+	lastActivity = time(nullptr);
+	if(closed)
+	{
+		outMutex.unlock();
+		return;
+	}
+
+	//Try to write the Package at once if
+	//nothing else is waiting to be written
+	std::size_t written = 0;
+	if(out.empty())
+	{
+		struct iovec parts[2];
+		parts[0].iov_base = header;
+		parts[0].iov_len = headerSize;
+		parts[1].iov_base = const_cast<char*>(content);
+		parts[1].iov_len = messageSize;
+
+		struct msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = parts;
+		message.msg_iovlen = 2;
+
+		const ssize_t result = sendmsg(fd, &message, MSG_NOSIGNAL);
+		if(result > 0)written = std::size_t(result);
+	}
+
+	//The rest is written by the EventLoop
+	if(written < headerSize + messageSize)
+	{
+		vector<char> rest;
+		rest.reserve(headerSize + messageSize - written);
+		if(written < headerSize)rest.insert(rest.end(), header + written, header + headerSize);
+		const std::size_t contentWritten = written > headerSize ? written - headerSize : 0;
+		rest.insert(rest.end(), content + contentWritten, content + messageSize);
+
+		const bool wasEmpty = out.empty();
+		out.push_back(vector<char>());
+		out.back().swap(rest);
+		if(wasEmpty)loop->watchWrite(fd, true);
+	}
+	outMutex.unlock();
+}
+
+void EventConnection::finished()
+{
+	outMutex.lock();
+	--pending;
+	lastActivity = time(nullptr);
+	outMutex.unlock();
+}
+
+bool EventConnection::read(const function<void(const Package&)> &callback)
+{
+	while(true)
+	{
+		//Make room for new data
+		if(in.size() - inEnd < minimumReadSize)
+		{
+			if(inPosition > 0)
+			{
+				memmove(&in[0], &in[inPosition], inEnd - inPosition);
+				inEnd -= inPosition;
+				inPosition = 0;
+			}
+			if(in.size() - inEnd < minimumReadSize)in.resize(inEnd + minimumReadSize);
+		}
+
+		const ssize_t result = recv(fd, &in[inEnd], in.size() - inEnd, 0);
+		if(result == 0)return false;
+		if(result < 0)
+		{
+			if(errno == EINTR)continue;
+			return (errno == EAGAIN);
+		}
+		inEnd += std::size_t(result);
+
+		outMutex.lock();
+		lastActivity = time(nullptr);
+		outMutex.unlock();
+
+		//Split the data into Packages
+		while(true)
+		{
+			uint64_t messageSize = 0;
+			const std::size_t headerSize = Framing::decodeHeader(&in[inPosition], inEnd - inPosition, messageSize);
+			if(headerSize == 0)break;
+
+			//The frame does not fit into memory or the length
+			//is invalid. The connection is closed in this case
+			if(messageSize > socket->getMaxFrameSize())return false;
+			if(messageSize > numeric_limits<std::size_t>::max() - headerSize - inPosition)return false;
+
+			const std::size_t frameSize = headerSize + std::size_t(messageSize);
+			if(inEnd - inPosition < frameSize)
+			{
+				//Reserve the memory for the whole Package at once
+				if(inPosition + frameSize > in.size())in.resize(inPosition + frameSize);
+				break;
+			}
+
+			++pending;
+			callback(Package(&in[inPosition + headerSize], std::size_t(messageSize)));
+			inPosition += frameSize;
+		}
+
+		if(inPosition == inEnd)
+		{
+			inPosition = 0;
+			inEnd = 0;
+		}
+	}
+}
+
+bool EventConnection::write()
+{
+	bool success = true;
+
+	outMutex.lock();
+	while(!out.empty())
+	{
+		const vector<char> &data = out.front();
+		const ssize_t result = ::send(fd, &data[outPosition], data.size() - outPosition, MSG_NOSIGNAL);
+		if(result < 0)
+		{
+			if(errno == EINTR)continue;
+			success = (errno == EAGAIN);
+			break;
+		}
+
+		outPosition += std::size_t(result);
+		if(outPosition == data.size())
+		{
+			out.pop_front();
+			outPosition = 0;
+		}
+	}
+	lastActivity = time(nullptr);
+	if(out.empty())loop->watchWrite(fd, false);
+	outMutex.unlock();
+
+	return success;
+}
+
+/******************************************************/
+
+EventLoop::EventLoop(function<void(const shared_ptr<EventConnection>&, const Package&)> fn_callback, const unsigned int &ui_idleTimeout) :
+	fd_epoll(epoll_create1(EPOLL_CLOEXEC)),
+	running(true),
+	callback(fn_callback),
+	idleTimeout(ui_idleTimeout),
+	listener(nullptr),
+	acceptCallback(nullptr),
+	connections(),
+	connectionsMutex(),
+	t(nullptr)
+{
+	if(fd_epoll == -1)throw ServerException(string("Unable to create epoll instance: ")+strerror(errno));
+
+	t = new thread(&EventLoop::loopFunction, this);
+}
+
+EventLoop::~EventLoop()
+{
+	running = false;
+	t->join();
+	delete t;
+
+	connectionsMutex.lock();
+	for(auto &connection : connections)
+	{
+		connection.second->outMutex.lock();
+		connection.second->closed = true;
+		connection.second->outMutex.unlock();
+	}
+	connections.clear();
+	connectionsMutex.unlock();
+
+	::close(fd_epoll);
+}
+
+void EventLoop::add(CommunicationSocket *socket)
+{
+	shared_ptr<EventConnection> connection(new EventConnection(socket, this));
+
+	connectionsMutex.lock();
+	connections[connection->fd] = connection;
+	connectionsMutex.unlock();
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | EPOLLRDHUP;
+	event.data.fd = connection->fd;
+	if(epoll_ctl(fd_epoll, EPOLL_CTL_ADD, connection->fd, &event) != 0)close(connection->fd);
+}
+
+void EventLoop::setListener(ListenerSocket *l, function<void(CommunicationSocket*)> fn_acceptCallback)
+{
+	listener = l;
+	acceptCallback = fn_acceptCallback;
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = listener->getDescriptor();
+	epoll_ctl(fd_epoll, EPOLL_CTL_ADD, listener->getDescriptor(), &event);
+}
+
+void EventLoop::watchWrite(int fd, bool write)
+{
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | EPOLLRDHUP;
+	if(write)event.events |= EPOLLOUT;
+	event.data.fd = fd;
+	epoll_ctl(fd_epoll, EPOLL_CTL_MOD, fd, &event);
+}
+
+void EventLoop::close(int fd)
+{
+	shared_ptr<EventConnection> connection;
+
+	connectionsMutex.lock();
+	auto it = connections.find(fd);
+	if(it != connections.end())
+	{
+		connection = it->second;
+		connections.erase(it);
+	}
+	connectionsMutex.unlock();
+
+	if(!connection)return;
+	epoll_ctl(fd_epoll, EPOLL_CTL_DEL, fd, nullptr);
+
+	//The socket is closed as soon as no
+	//answer is being prepared anymore
+	connection->outMutex.lock();
+	connection->closed = true;
+	connection->out.clear();
+	connection->outMutex.unlock();
+}
+
+void EventLoop::closeIdleConnections()
+{
+	const time_t now = time(nullptr);
+	vector<int> idle;
+
+	connectionsMutex.lock();
+	for(auto &connection : connections)
+	{
+		EventConnection &c = *connection.second;
+		c.outMutex.lock();
+		if(c.pending == 0 && c.out.empty() && difftime(now, c.lastActivity) >= idleTimeout)
+		{
+			idle.push_back(connection.first);
+		}
+		else if(c.pending == 0 && c.inEnd == 0 && c.in.size() > maximumIdleBufferSize)
+		{
+			//Release the memory of big Packages
+			vector<char>().swap(c.in);
+		}
+		c.outMutex.unlock();
+	}
+	connectionsMutex.unlock();
+
+	for(int fd : idle)close(fd);
+}
+
+void EventLoop::loopFunction()
+{
+	static const int maxEvents = 64;
+	struct epoll_event events[maxEvents];
+	time_t lastCheck = time(nullptr);
+
+	while(running)
+	{
+		const int count = epoll_wait(fd_epoll, events, maxEvents, 1000);
+
+		for(int i = 0; i < count; ++i)
+		{
+			const int fd = events[i].data.fd;
+
+			//Accept new connection
+			if(listener && fd == listener->getDescriptor())
+			{
+				if(CommunicationSocket *socket = listener->listenNonBlocking())
+				{
+					acceptCallback(socket);
+				}
+				continue;
+			}
+
+			connectionsMutex.lock();
+			auto it = connections.find(fd);
+			shared_ptr<EventConnection> connection;
+			if(it != connections.end())connection = it->second;
+			connectionsMutex.unlock();
+			if(!connection)continue;
+
+			bool success = true;
+			if(events[i].events & EPOLLOUT)success = connection->write();
+			if(success && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+			{
+				success = connection->read([this,&connection](const Package &data)
+				{
+					callback(connection, data);
+				});
+			}
+			if(!success)close(fd);
+		}
+
+		//Check for idle connections every second
+		const time_t now = time(nullptr);
+		if(difftime(now, lastCheck) >= 1)
+		{
+			closeIdleConnections();
+			lastCheck = now;
+		}
+	}
+}
+
+#endif //__linux__
@@ -0,0 +1,177 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/executor.hpp>
+#include <memory>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The state of a forEach call which is shared
+  * by the calling thread and the worker threads
+ **/
+struct Executor::ForEach
+{
+	ForEach(std::size_t ui_count, const function<void(std::size_t)> *fn_fn) :
+		count(ui_count),
+		fn(fn_fn),
+		next(0),
+		finished(0),
+		m(),
+		cv()
+	{}
+
+	ForEach(const ForEach &f) = delete;
+	ForEach& operator=(const ForEach &f) = delete;
+
+	/**
+	  * Calls the function for the indices which
+	  * are not taken yet
+	 **/
+	void run()
+	{
+		unique_lock<mutex> lock(m);
+		while(next < count)
+		{
+			const std::size_t index = next++;
+			lock.unlock();
+
+			(*fn)(index);
+
+			lock.lock();
+			if(++finished == count)cv.notify_all();
+		}
+	}
+
+	/**
+	  * Waits until all calls are finished
+	 **/
+	void wait()
+	{
+		unique_lock<mutex> lock(m);
+		cv.wait(lock, [this]{ return finished == count; });
+	}
+
+	std::size_t count;
+
+	//Only used while an index is taken, so
+	//it stays valid until forEach returns
+	const function<void(std::size_t)> *fn;
+
+	std::size_t next;
+	std::size_t finished;
+	mutex m;
+	condition_variable cv;
+};
+
+Executor::Executor(unsigned int ui_maxThreads) :
+	maxThreads(ui_maxThreads),
+	threads(),
+	idle(0),
+	tasks(),
+	running(true),
+	m(),
+	cv()
+{}
+
+Executor::~Executor()
+{
+	shutdown();
+}
+
+bool Executor::execute(function<void()> task)
+{
+	m.lock();
+	if(!running)
+	{
+		m.unlock();
+		return false;
+	}
+	tasks.push(task);
+
+	//A new worker thread is only started
+	//if none of them is waiting
+	if(idle < tasks.size() && threads.size() < maxThreads)threads.push_back(new thread(&Executor::workerFunction, this));
+	m.unlock();
+	cv.notify_one();
+
+	return true;
+}
+
+void Executor::forEach(std::size_t count, const function<void(std::size_t)> &fn)
+{
+	//A single call doesn't need a worker thread
+	if(count == 1)
+	{
+		fn(0);
+		return;
+	}
+
+	shared_ptr<ForEach> state(new ForEach(count, &fn));
+	for(std::size_t i = 1; i < count; ++i)
+	{
+		if(!execute([state]{ state->run(); }))break;
+	}
+
+	//The calling thread takes the indices which no worker
+	//thread took yet, so it never waits for a worker thread
+	//which is busy with other tasks
+	state->run();
+	state->wait();
+}
+
+void Executor::shutdown()
+{
+	m.lock();
+	running = false;
+	vector<thread*> toJoin;
+	toJoin.swap(threads);
+	m.unlock();
+	cv.notify_all();
+
+	for(thread *t : toJoin)
+	{
+		//If a task shuts the Executor down, its
+		//worker thread finishes on its own
+		if(t->get_id() == this_thread::get_id())t->detach();
+		else t->join();
+		delete t;
+	}
+}
+
+void Executor::start()
+{
+	m.lock();
+	running = true;
+	m.unlock();
+}
+
+void Executor::workerFunction()
+{
+	unique_lock<mutex> lock(m);
+	while(true)
+	{
+		if(tasks.empty())
+		{
+			if(!running)break;
+			++idle;
+			cv.wait(lock);
+			--idle;
+			continue;
+		}
+
+		function<void()> task = tasks.front();
+		tasks.pop();
+		lock.unlock();
+
+		task();
+
+		lock.lock();
+	}
+}
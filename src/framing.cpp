@@ -0,0 +1,210 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/framing.hpp>
+#include <cluster/package.hpp>
+#include <limits>
+
+#ifdef __linux__
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#else
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif //__linux__
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The maximum amount of bytes which is passed
+  * to one send or receive call
+ **/
+static const std::size_t maxChunkSize = 1073741824;
+
+/**
+  * The 4 byte length which announces an 8 byte length
+ **/
+static const uint32_t longLengthMarker = 0xFFFFFFFF;
+
+/**
+  * Sends the given parts with one call. Returns
+  * the amount of bytes sent or -1 on error
+ **/
+static long long sendParts(Framing::Descriptor fd, const char *data[2], const std::size_t length[2])
+{
+#ifdef __linux__
+	struct iovec parts[2];
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = parts;
+	for(unsigned int i = 0; i < 2; ++i)
+	{
+		if(length[i] == 0)continue;
+		parts[message.msg_iovlen].iov_base = const_cast<char*>(data[i]);
+		parts[message.msg_iovlen].iov_len = min(length[i], maxChunkSize);
+		++message.msg_iovlen;
+	}
+
+	ssize_t result;
+	do result = sendmsg(fd, &message, MSG_NOSIGNAL);
+	while(result < 0 && errno == EINTR);
+
+	return result;
+#else
+	WSABUF parts[2];
+	DWORD count = 0;
+	for(unsigned int i = 0; i < 2; ++i)
+	{
+		if(length[i] == 0)continue;
+		parts[count].buf = const_cast<char*>(data[i]);
+		parts[count].len = ULONG(min(length[i], maxChunkSize));
+		++count;
+	}
+
+	DWORD sent = 0;
+	if(WSASend(fd, parts, count, &sent, 0, nullptr, nullptr) != 0)return -1;
+
+	return (long long)sent;
+#endif //__linux__
+}
+
+size_t Framing::encodeHeader(uint64_t length, char *header)
+{
+	if(length < longLengthMarker)
+	{
+		for(unsigned int i = 0; i < 4; ++i)header[i] = char((length >> (8*i)) & 0xFF);
+		return 4;
+	}
+
+	for(unsigned int i = 0; i < 4; ++i)header[i] = char(0xFF);
+	for(unsigned int i = 0; i < 8; ++i)header[4+i] = char((length >> (8*i)) & 0xFF);
+	return 12;
+}
+
+size_t Framing::decodeHeader(const char *data, std::size_t available, uint64_t &length)
+{
+	if(available < 4)return 0;
+
+	uint32_t shortLength = 0;
+	for(unsigned int i = 0; i < 4; ++i)shortLength |= uint32_t((unsigned char)data[i]) << (8*i);
+	if(shortLength != longLengthMarker)
+	{
+		length = shortLength;
+		return 4;
+	}
+
+	if(available < 12)return 0;
+
+	length = 0;
+	for(unsigned int i = 0; i < 8; ++i)length |= uint64_t((unsigned char)data[4+i]) << (8*i);
+	return 12;
+}
+
+bool Framing::send(Descriptor fd, const Package &message)
+{
+	//Sending 0 byte packages is illegal
+	static const char emptyData = '\0';
+	const char *content = message.getLength() ? message.getData() : &emptyData;
+	const std::size_t messageSize = message.getLength() ? message.getLength() : 1;
+
+	char header[maxHeaderSize];
+	const char *data[2] = { header, content };
+	std::size_t length[2] = { encodeHeader(messageSize, header), messageSize };
+
+	//Header and content are sent with one call.
+	//If only a part was sent, the rest is retried
+	while(length[0] + length[1] > 0)
+	{
+		long long result = sendParts(fd, data, length);
+		if(result <= 0)return false;
+
+		for(unsigned int i = 0; i < 2 && result > 0; ++i)
+		{
+			const std::size_t sent = min(length[i], std::size_t(result));
+			data[i] += sent;
+			length[i] -= sent;
+			result -= (long long)sent;
+		}
+	}
+
+	return true;
+}
+
+bool Framing::receive(Descriptor fd, Package *out, uint64_t maxFrameSize)
+{
+	//First reading the header. The first 4 bytes
+	//tell whether there is an 8 byte length
+	char header[maxHeaderSize];
+	uint64_t messageSize = 0;
+	if(!receiveAll(fd, header, 4))return false;
+	if(!decodeHeader(header, 4, messageSize))
+	{
+		if(!receiveAll(fd, header+4, 8))return false;
+		decodeHeader(header, 12, messageSize);
+	}
+
+	//The frame does not fit into memory or the other
+	//side sends an invalid length. The stream can't be
+	//used anymore because the frame is not read
+	if(messageSize > maxFrameSize || messageSize > numeric_limits<std::size_t>::max())return false;
+
+	//The content is received directly into the Package
+	Package data;
+	if(!receiveAll(fd, data.extend((std::size_t)messageSize), (std::size_t)messageSize))return false;
+
+	if(out)out->write(data);
+	return true;
+}
+
+bool Framing::receiveAll(Descriptor fd, char *data, std::size_t length)
+{
+	while(length > 0)
+	{
+#ifdef __linux__
+		const ssize_t result = recv(fd, data, min(length, maxChunkSize), 0);
+		if(result < 0 && errno == EINTR)continue;
+#else
+		const int result = recv(fd, data, int(min(length, maxChunkSize)), 0);
+#endif //__linux__
+		if(result <= 0)return false;
+
+		data += result;
+		length -= std::size_t(result);
+	}
+
+	return true;
+}
+
+void Framing::setOptions(Descriptor fd, unsigned int timeout, bool noDelay)
+{
+	//Set timeout
+#ifdef __linux__
+	struct timeval tv;
+	tv.tv_sec = timeout;
+	tv.tv_usec = 0;
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+#else
+	//Windows expects the timeout in milliseconds
+	DWORD tv = timeout * 1000;
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<char*>(&tv), sizeof(tv));
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char*>(&tv), sizeof(tv));
+#endif //__linux__
+
+	//TCP_NODELAY is an option of the TCP level
+	if(noDelay)
+	{
+		int set = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char*>(&set), sizeof(set));
+	}
+}
@@ -7,10 +7,13 @@
  **/
 
 #include <cluster/ipv4/ipv4.hpp>
+#include <cluster/multicastdiscovery.hpp>
+#include <cluster/connectscanner.hpp>
 
 #ifdef __linux__
 #include <ifaddrs.h>
 #include <arpa/inet.h>
+#include <string.h>
 #else
 #include <winsock2.h>
 #endif //__linux__
@@ -22,7 +25,8 @@ IPv4::IPv4(uint16_t ui_port, unsigned int ui_timeout, unsigned int ui_listenBack
 	Protocol(),
 	port(ui_port),
 	timeout(ui_timeout),
-	listenBacklog(ui_listenBacklog)
+	listenBacklog(ui_listenBacklog),
+	discovery(nullptr)
 {
 #ifndef __linux__
 	WSAData data;
@@ -32,6 +36,10 @@ IPv4::IPv4(uint16_t ui_port, unsigned int ui_timeout, unsigned int ui_listenBack
 
 IPv4::~IPv4()
 {
+#ifdef __linux__
+	delete discovery;
+#endif //__linux__
+
 #ifndef __linux__
 	WSACleanup();
 #endif //__linux__
@@ -50,15 +58,17 @@ CommunicationSocket* IPv4::createCommunicationSocket(const Address &address) con
 {
 	CommunicationSocket *socket = nullptr;
 
-	//Decode Address
-	const IPv4Address *a = static_cast<IPv4Address*>(decodeAddress(address.address));
-	if(!a)throw AddressException("Wrong IPv4 Address");
+	//Other Addresses need to be decoded
+	const IPv4Address *a = dynamic_cast<const IPv4Address*>(&address);
+	const IPv4Address *decoded = a ? nullptr : static_cast<IPv4Address*>(decodeAddress(address.toString()));
+	if(!a && !decoded)throw AddressException("Wrong IPv4 Address");
 
 	try {
-		socket = new IPv4CommunicationSocket(*a, port, timeout);
+		socket = new IPv4CommunicationSocket(a ? *a : *decoded, port, timeout);
+		socket->setMaxFrameSize(getMaxFrameSize());
 	}catch(const CommunicationException &e) {}
 
-	delete a;
+	delete decoded;
 	return socket;
 }
 
@@ -111,3 +121,68 @@ Address* IPv4::decodeAddress(const std::string &address) const
 
 	return nullptr;
 }
+
+bool IPv4::enableDiscovery(const std::string &group, uint16_t groupPort, unsigned int interval)
+{
+#ifdef __linux__
+	try {
+		MulticastDiscovery *d = new MulticastDiscovery(AF_INET, group.empty() ? MulticastDiscovery::defaultGroupIPv4 : group, groupPort ? groupPort : port, port, interval);
+		delete discovery;
+		discovery = d;
+		return true;
+	} catch(const ListenerException &e) {}
+#else
+	(void)group;
+	(void)groupPort;
+	(void)interval;
+#endif //__linux__
+
+	return false;
+}
+
+bool IPv4::discoverAddresses(std::list<Address*> &out) const
+{
+#ifdef __linux__
+	if(!discovery)return false;
+
+	list<string> discovered;
+	discovery->getDiscovered(discovered);
+	for(const string &address : discovered)
+	{
+		if(Address *a = decodeAddress(address))
+		{
+			out.push_back(a);
+		}
+	}
+	return true;
+#else
+	(void)out;
+	return false;
+#endif //__linux__
+}
+
+bool IPv4::probeAddresses(const std::vector<const Address*> &addresses, std::vector<bool> &reachable, unsigned int concurrency, unsigned int probeTimeout) const
+{
+#ifdef __linux__
+	//Addresses which can't be converted keep AF_UNSPEC
+	vector<struct sockaddr_storage> socketAddresses(addresses.size());
+	for(std::size_t i = 0; i < addresses.size(); ++i)
+	{
+		memset(&socketAddresses[i], 0, sizeof(socketAddresses[i]));
+		const IPv4Address *a = dynamic_cast<const IPv4Address*>(addresses[i]);
+		if(!a)continue;
+		struct sockaddr_in *addr4 = reinterpret_cast<struct sockaddr_in*>(&socketAddresses[i]);
+		(*addr4) = a->getSocketAddress();
+		addr4->sin_port = uint16_t(htons(port));
+	}
+
+	ConnectScanner::scan(socketAddresses, reachable, concurrency, probeTimeout);
+	return true;
+#else
+	(void)addresses;
+	(void)reachable;
+	(void)concurrency;
+	(void)probeTimeout;
+	return false;
+#endif //__linux__
+}
@@ -9,27 +9,30 @@
 #include <cluster/ipv4/ipv4address.hpp>
 #include <string>
 #include <sstream>
+#include <typeinfo>
 #include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
 
 using namespace std;
 using namespace cluster;
 
 IPv4Address::IPv4Address(const uint8_t uc_a[4]) :
-	Address(IPv4Address::encode(uc_a)),
-	a()
+	Address(),
+	socketAddress()
 {
-	for(unsigned int i = 0; i < 4; i++)
-	{
-		this->a[i] = uc_a[i];
-	}
+	memset(&socketAddress, 0, sizeof(socketAddress));
+	socketAddress.sin_family = AF_INET;
+	memcpy(bytes(), uc_a, 4);
 }
 
 IPv4Address::IPv4Address(const string &str_address) :
-	Address(str_address),
-	a()
+	Address(),
+	socketAddress()
 {
-	decode(this->address, a);
+	memset(&socketAddress, 0, sizeof(socketAddress));
+	socketAddress.sin_family = AF_INET;
+	decode(str_address, bytes());
 }
 
 void IPv4Address::decode(const std::string &address, uint8_t a[4])
@@ -73,6 +76,7 @@ Address* IPv4Address::clone() const
 
 void IPv4Address::increase()
 {
+	uint8_t *a = bytes();
 	bool success = false;
 
 	//Increase the address from right to left
@@ -111,11 +115,25 @@ void IPv4Address::increase()
 		a[2] = 0;
 		a[3] = 1;
 	}
-
-	address = encode(a);
 }
 
 bool IPv4Address::isLoopback() const
 {
-	return a[0] == 127;
+	return bytes()[0] == 127;
+}
+
+bool IPv4Address::operator==(const Address &other) const
+{
+	if(typeid(other) != typeid(*this))return false;
+	return socketAddress.sin_addr.s_addr == static_cast<const IPv4Address&>(other).socketAddress.sin_addr.s_addr;
+}
+
+std::size_t IPv4Address::hash() const
+{
+	return std::hash<uint32_t>()(socketAddress.sin_addr.s_addr);
+}
+
+string IPv4Address::toString() const
+{
+	return encode(bytes());
 }
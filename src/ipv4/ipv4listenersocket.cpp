@@ -130,8 +130,19 @@ CommunicationSocket* IPv4ListenerSocket::listen()
 		cout<<strerror(errno)<<endl;
 		return nullptr;
 	}
-	char addressBuffer[INET_ADDRSTRLEN];
-	inet_ntop(AF_INET, &clientAddr.sin_addr.s_addr, addressBuffer, INET_ADDRSTRLEN);
-	IPv4Address ipAddress(addressBuffer);
+	IPv4Address ipAddress(reinterpret_cast<const uint8_t*>(&clientAddr.sin_addr));
 	return new IPv4CommunicationSocket(ipAddress, port, fd_client, timeout);
 }
+
+#ifdef __linux__
+CommunicationSocket* IPv4ListenerSocket::listenNonBlocking()
+{
+	struct sockaddr_in clientAddr;
+	socklen_t size = sizeof(struct sockaddr_in);
+	int fd_client = accept4(fd_socket, reinterpret_cast<struct sockaddr*>(&clientAddr), &size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if(fd_client == -1)return nullptr;
+
+	IPv4Address ipAddress(reinterpret_cast<const uint8_t*>(&clientAddr.sin_addr));
+	return new IPv4CommunicationSocket(ipAddress, port, fd_client, timeout);
+}
+#endif //__linux__
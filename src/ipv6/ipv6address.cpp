@@ -7,7 +7,9 @@
  **/
 
 #include <cluster/ipv6/ipv6address.hpp>
+#include <typeinfo>
 #include <ctype.h>
+#include <string.h>
 
 #ifdef __linux__
 #include <arpa/inet.h>
@@ -19,20 +21,21 @@ using namespace std;
 using namespace cluster;
 
 IPv6Address::IPv6Address(const uint8_t uc_a[16]) :
-	Address(IPv6Address::encode(uc_a)),
-	a()
+	Address(),
+	socketAddress()
 {
-	for(unsigned int i = 0; i < 16; i++)
-	{
-		this->a[i] = uc_a[i];
-	}
+	memset(&socketAddress, 0, sizeof(socketAddress));
+	socketAddress.sin6_family = AF_INET6;
+	memcpy(bytes(), uc_a, 16);
 }
 
 IPv6Address::IPv6Address(const string &str_address) :
-	Address(str_address),
-	a()
+	Address(),
+	socketAddress()
 {
-	decode(this->address, a);
+	memset(&socketAddress, 0, sizeof(socketAddress));
+	socketAddress.sin6_family = AF_INET6;
+	decode(str_address, bytes());
 }
 
 void IPv6Address::decode(const std::string &address, uint8_t a[16])
@@ -67,6 +70,7 @@ Address* IPv6Address::clone() const
 
 void IPv6Address::increase()
 {
+	uint8_t *a = bytes();
 	bool success = false;
 
 	//Increase the address from right to left
@@ -104,12 +108,11 @@ void IPv6Address::increase()
 		}
 		a[15] = 1;
 	}
-
-	address = encode(a);
 }
 
 bool IPv6Address::isLoopback() const
 {
+	const uint8_t *a = bytes();
 	if(a[15] != 1)return false;
 	for(unsigned int i = 0; i < 15; i++)
 	{
@@ -117,3 +120,21 @@ bool IPv6Address::isLoopback() const
 	}
 	return true;
 }
+
+bool IPv6Address::operator==(const Address &other) const
+{
+	if(typeid(other) != typeid(*this))return false;
+	return memcmp(bytes(), static_cast<const IPv6Address&>(other).bytes(), 16) == 0;
+}
+
+std::size_t IPv6Address::hash() const
+{
+	uint64_t parts[2];
+	memcpy(parts, bytes(), sizeof(parts));
+	return std::hash<uint64_t>()(parts[0] ^ (parts[1] * 0x9e3779b97f4a7c15ULL));
+}
+
+string IPv6Address::toString() const
+{
+	return encode(bytes());
+}
@@ -9,6 +9,7 @@
 #include <cluster/ipv6/ipv6communicationsocket.hpp>
 #include <cluster/ipv6/ipv6address.hpp>
 #include <cluster/package.hpp>
+#include <cluster/framing.hpp>
 #include <unistd.h>
 
 #ifdef __linux__
@@ -16,6 +17,7 @@
 #include <sys/un.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <poll.h>
 #else
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -36,15 +38,7 @@ IPv6CommunicationSocket::IPv6CommunicationSocket(const IPv6Address &ipAddress, u
 	fd_client(client),
 	counter(new int(1))
 {
-	//Set timeout
-	struct timeval tv;
-	tv.tv_sec = timeout;
-	tv.tv_usec = 0;
-	setsockopt(fd_client, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<char*>(&tv), sizeof(struct timeval));
-	setsockopt(fd_client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char*>(&tv), sizeof(struct timeval));
-
-	int set = 1;
-	setsockopt(fd_client, SOL_SOCKET, TCP_NODELAY, reinterpret_cast<char*>(&set), sizeof(set));
+	Framing::setOptions(fd_client, timeout, true);
 }
 
 IPv6CommunicationSocket::IPv6CommunicationSocket(const IPv6Address &ipAddress, uint16_t ui_port, unsigned int timeout) :
@@ -64,18 +58,8 @@ IPv6CommunicationSocket::IPv6CommunicationSocket(const IPv6Address &ipAddress, u
 #endif //__linux__
 
 	//Open port
-	struct sockaddr_in6 addr;
-	addr.sin6_family = AF_INET6;
+	struct sockaddr_in6 addr = ipAddress.getSocketAddress();
 	addr.sin6_port = uint16_t(htons(port));
-	if(inet_pton(AF_INET6, ipAddress.address.c_str(), &addr.sin6_addr) != 1)
-	{
-#ifdef __linux__
-		close(fd_client);
-#else
-		closesocket(fd_client);
-#endif //__linux__
-		throw CommunicationException(string("Couldn't convert ip address"));
-	}
 
 	//Connect socket
 	if(connect(fd_client, (struct sockaddr*)&addr, sizeof(addr)) != 0)
@@ -89,15 +73,7 @@ IPv6CommunicationSocket::IPv6CommunicationSocket(const IPv6Address &ipAddress, u
 #endif //__linux__
 	}
 
-	//Set timeout
-	struct timeval tv;
-	tv.tv_sec = timeout;
-	tv.tv_usec = 0;
-	setsockopt(fd_client, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<char*>(&tv), sizeof(struct timeval));
-	setsockopt(fd_client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char*>(&tv), sizeof(struct timeval));
-
-	int set = 1;
-	setsockopt(fd_client, SOL_SOCKET, TCP_NODELAY, reinterpret_cast<char*>(&set), sizeof(set));
+	Framing::setOptions(fd_client, timeout, true);
 
 	counter = new int(1);
 }
@@ -156,40 +132,33 @@ IPv6CommunicationSocket::~IPv6CommunicationSocket()
 
 bool IPv6CommunicationSocket::send(const Package &message)
 {
-#ifndef __linux__
-	//Fake flag.
-	//This flag is not needed in windows because
-	//SO_NOSIGPIPE can be set instead
-	const static int MSG_NOSIGNAL = 0;
-#endif //__linux__
-
-	unsigned int messageSize = (unsigned int)message.getLength();
-
-	//First sending package size then package content
-
-	//Sending 0 byte packages is illegal
-	if(messageSize == 0)
-	{
-		messageSize = 1;
-		char data = '\0';
-		if(::send(fd_client, reinterpret_cast<const char*>(&messageSize), sizeof(messageSize), MSG_NOSIGNAL) != sizeof(messageSize))return false;
-		if(::send(fd_client, &data, messageSize, MSG_NOSIGNAL) != int(messageSize))return false;
-	}
-	else
-	{
-		if(::send(fd_client, reinterpret_cast<const char*>(&messageSize), sizeof(messageSize), MSG_NOSIGNAL) != sizeof(messageSize))return false;
-		if(::send(fd_client, message.getData(), messageSize, MSG_NOSIGNAL) != int(messageSize))return false;
-	}
-	return true;
+	return Framing::send(fd_client, message);
 }
 
 bool IPv6CommunicationSocket::receive(Package *out)
 {
-	//First reading package size then package content
-	unsigned int messageSize = 0;
-	if(recv(fd_client, reinterpret_cast<char*>(&messageSize), sizeof(messageSize), 0) < 0)return false;
-	vector<char> data(messageSize);
-	if(recv(fd_client, &data[0], messageSize, 0) < 0)return false;
-	if(out)out->write(&data[0], messageSize);
-	return true;
+	return Framing::receive(fd_client, out, maxFrameSize);
+}
+
+bool IPv6CommunicationSocket::poll(unsigned int time)
+{
+#ifdef __linux__
+	struct pollfd fd;
+	fd.fd = fd_client;
+	fd.events = POLLIN;
+	const int result = ::poll(&fd, 1, int(time));
+#else
+	fd_set fds;
+	struct timeval to;
+
+	to.tv_sec = time / 1000;
+	to.tv_usec = (time % 1000) * 1000;
+
+	FD_ZERO(&fds);
+	FD_SET(fd_client, &fds);
+
+	const int result = select(1, &fds, nullptr, nullptr, &to);
+#endif //__linux__
+
+	return result > 0;
 }
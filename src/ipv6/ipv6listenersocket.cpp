@@ -116,11 +116,11 @@ CommunicationSocket* IPv6ListenerSocket::listen()
 {
 	struct sockaddr_in6 clientAddr;
 #ifdef __linux__
-	socklen_t size = sizeof(struct sockaddr_in);
+	socklen_t size = sizeof(struct sockaddr_in6);
 	int fd_client = accept(fd_socket, reinterpret_cast<struct sockaddr*>(&clientAddr), &size);
 	if(fd_client == -1)
 #else
-	int size = sizeof(struct sockaddr_in);
+	int size = sizeof(struct sockaddr_in6);
 	SOCKET fd_client = accept(fd_socket, reinterpret_cast<struct sockaddr*>(&clientAddr), &size);
 	if(fd_client == INVALID_SOCKET)
 #endif //__linux__
@@ -130,8 +130,19 @@ CommunicationSocket* IPv6ListenerSocket::listen()
 		//cout<<strerror(errno)<<endl;
 		return nullptr;
 	}
-	char addressBuffer[INET6_ADDRSTRLEN];
-	inet_ntop(AF_INET6, &clientAddr.sin6_addr, addressBuffer, INET6_ADDRSTRLEN);
-	IPv6Address ipAddress(addressBuffer);
+	IPv6Address ipAddress(clientAddr.sin6_addr.s6_addr);
 	return new IPv6CommunicationSocket(ipAddress, port, fd_client, timeout);
 }
+
+#ifdef __linux__
+CommunicationSocket* IPv6ListenerSocket::listenNonBlocking()
+{
+	struct sockaddr_in6 clientAddr;
+	socklen_t size = sizeof(struct sockaddr_in6);
+	int fd_client = accept4(fd_socket, reinterpret_cast<struct sockaddr*>(&clientAddr), &size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if(fd_client == -1)return nullptr;
+
+	IPv6Address ipAddress(clientAddr.sin6_addr.s6_addr);
+	return new IPv6CommunicationSocket(ipAddress, port, fd_client, timeout);
+}
+#endif //__linux__
@@ -8,6 +8,7 @@
 
 #include <cluster/ipv4/ipv4.hpp>
 #include <cluster/ipv6/ipv6.hpp>
+#include <cluster/simulated/simulated.hpp>
 #include <cluster/package.hpp>
 #include <cluster/p2p.hpp>
 #include <cluster/clustercontainer.hpp>
@@ -27,6 +28,7 @@ using namespace cluster;
 void testDatabase(const string &ip1, const string &ip2);
 void testClusterContainer(const string &ip1, const string &ip2);
 void testSpeed(const string &ip1, const string &ip2);
+void testSimulation(unsigned int nodes, unsigned int rows);
 void signalHandler(int signal);
 template<class Index, class Container> void controller(const ClusterContainer<Index, int, Container> *c);
 
@@ -44,11 +46,13 @@ int main(int /*argc*/, char* /*args*/[])
 	//testClusterContainer(ip1, ip2);
 	testDatabase(ip1, ip2);
 	//testSpeed(ip1, ip2);
+	//testSimulation(4, 1000);
 }
 
 void testDatabase(const string &ip1, const string &ip2)
 {
 	IPv4 p(1234);
+	p.enableDiscovery();
 	p2p network(p);
 	if(!ip1.empty() && !ip2.empty())network.addAddressRange(IPv4Address(ip1), IPv4Address(ip2));
 	Database db(&network, "test", 2, 2);
@@ -105,11 +109,16 @@ void testDatabase(const string &ip1, const string &ip2)
 void testClusterContainer(const string &ip1, const string &ip2)
 {
 	IPv4 p(1234);
+	p.enableDiscovery();
 	p2p network(p);
 	if(!ip1.empty() && !ip2.empty())network.addAddressRange(IPv4Address(ip1), IPv4Address(ip2));
 	ClusterList<int> v(&network);
 	ClusterMutex m(&network);
 
+	//After a restart the list is restored from the
+	//disk and only the missed numbers are fetched
+	if(!v.openWriteAheadLog("clusterlist.log"))cout<<"Can't write clusterlist.log"<<endl;
+
 	cout<<"Network structure:"<<endl<<network.getWholeStructure();
 
 	//thread t(controller, &v);
@@ -145,6 +154,7 @@ void testClusterContainer(const string &ip1, const string &ip2)
 void testSpeed(const string &ip1, const string &ip2)
 {
 	IPv4 p(1234);
+	p.enableDiscovery();
 	p2p network(p);
 	if(!ip1.empty() && !ip2.empty())network.addAddressRange(IPv4Address(ip1), IPv4Address(ip2));
 	ClusterSpeedTest test(&network, 10000);
@@ -162,6 +172,72 @@ void testSpeed(const string &ip1, const string &ip2)
 	network.close();
 }
 
+void testSimulation(unsigned int nodes, unsigned int rows)
+{
+	//All nodes run in this process. The links have
+	//a latency of 200us and a bandwidth of 1 GBit/s
+	SimulatedNetwork network(1);
+	network.setDefaultLink(SimulatedLink(200, 125000000, 0));
+
+	vector<Simulated*> protocols;
+	vector<p2p*> networks;
+	vector<Database*> databases;
+	for(unsigned int i = 0; i < nodes; ++i)
+	{
+		protocols.push_back(new Simulated(network, "node"+to_string(i+1)));
+		networks.push_back(new p2p(*protocols.back()));
+		//The name is the directory of the
+		//data, so every node needs its own
+		databases.push_back(new Database(networks.back(), "simulation"+to_string(i+1), 2, 2));
+	}
+
+	//Wait until the nodes found each other
+	sleep(3);
+	cout<<"Network structure:"<<endl<<networks[0]->getWholeStructure();
+
+	struct timeval t1;
+	struct timeval t2;
+	gettimeofday(&t1, nullptr);
+	SQLResult res = databases[0]->execute("create table test (id int primary key, name text)");
+	if(!res.wasSuccess())cout<<res.getErrorMessage()<<endl;
+	for(unsigned int i = 0; i < rows && running; ++i)
+	{
+		res = databases[i % nodes]->execute("insert into test (id, name) values ("+to_string(i)+", 'row"+to_string(i)+"')");
+		if(!res.wasSuccess())cout<<res.getErrorMessage()<<endl;
+	}
+	gettimeofday(&t2, nullptr);
+	double time = double(t2.tv_sec-t1.tv_sec) + double(t2.tv_usec-t1.tv_usec)/1000000;
+	cout<<"Inserted "<<rows<<" rows: "<<time<<" s"<<endl;
+
+	gettimeofday(&t1, nullptr);
+	unsigned int count = 0;
+	res = databases[0]->execute("select * from test");
+	if(res.wasSuccess() && res.hasResult())
+	{
+		vector<DataValue> row(res.colsCount());
+		while(res.fetchRow(*databases[0], row))count++;
+	}
+	gettimeofday(&t2, nullptr);
+	time = double(t2.tv_sec-t1.tv_sec) + double(t2.tv_usec-t1.tv_usec)/1000000;
+	cout<<"Selected "<<count<<" rows: "<<time<<" s"<<endl;
+
+	//The last node is cut off so that the
+	//others take over its data
+	network.setPartition("node"+to_string(nodes), 1);
+	gettimeofday(&t1, nullptr);
+	while(running && networks[0]->getMembersCount() + 1 >= nodes)usleep(10000);
+	gettimeofday(&t2, nullptr);
+	time = double(t2.tv_sec-t1.tv_sec) + double(t2.tv_usec-t1.tv_usec)/1000000;
+	cout<<"Detected the partition: "<<time<<" s"<<endl;
+
+	for(unsigned int i = 0; i < nodes; ++i)
+	{
+		delete databases[i];
+		delete networks[i];
+		delete protocols[i];
+	}
+}
+
 template<class Index, class Container> void controller(const ClusterContainer<Index, int, Container> *c)
 {
 	while(running)
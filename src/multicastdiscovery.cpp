@@ -0,0 +1,190 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifdef __linux__
+
+#include <cluster/multicastdiscovery.hpp>
+#include <cluster/prototypes/listenersocket.hpp>
+#include <chrono>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The interval in milliseconds in which the
+  * thread checks whether it should stop
+ **/
+static const int pollInterval = 100;
+
+/**
+  * Every announcement starts with this text
+  * which is followed by the port in network
+  * byte order
+ **/
+static const char announcementMessage[] = "cluster-discovery-1";
+
+/**
+  * The size of an announcement
+ **/
+static const std::size_t announcementSize = sizeof(announcementMessage) - 1 + sizeof(uint16_t);
+
+const char MulticastDiscovery::defaultGroupIPv4[] = "239.255.67.76";
+
+const char MulticastDiscovery::defaultGroupIPv6[] = "ff15::c1:5757";
+
+MulticastDiscovery::MulticastDiscovery(int family, const string &group, uint16_t groupPort, uint16_t ui_servicePort, unsigned int ui_interval) :
+	fd(socket(family, SOCK_DGRAM, 0)),
+	groupAddress(),
+	groupAddressLength(0),
+	servicePort(ui_servicePort),
+	interval(ui_interval),
+	discovered(),
+	discoveredMutex(),
+	running(true),
+	t(nullptr)
+{
+	if(fd == -1)throw ListenerException(string("Unable to create discovery socket: ")+strerror(errno));
+
+	//Many members of the same computer
+	//can be in the group
+	static const int yes = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+	setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes));
+
+	bool joined = false;
+	if(family == AF_INET)
+	{
+		struct sockaddr_in addr4;
+		memset(&addr4, 0, sizeof(addr4));
+		addr4.sin_family = AF_INET;
+		addr4.sin_port = htons(groupPort);
+		addr4.sin_addr.s_addr = htonl(INADDR_ANY);
+
+		struct ip_mreq membership;
+		memset(&membership, 0, sizeof(membership));
+		membership.imr_interface.s_addr = htonl(INADDR_ANY);
+
+		if(inet_pton(AF_INET, group.c_str(), &membership.imr_multiaddr) == 1 && IN_MULTICAST(ntohl(membership.imr_multiaddr.s_addr)) &&
+			bind(fd, reinterpret_cast<const sockaddr*>(&addr4), sizeof(addr4)) == 0 &&
+			setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) == 0)
+		{
+			addr4.sin_addr = membership.imr_multiaddr;
+			memcpy(&groupAddress, &addr4, sizeof(addr4));
+			groupAddressLength = sizeof(addr4);
+			joined = true;
+		}
+	}
+	else if(family == AF_INET6)
+	{
+		struct sockaddr_in6 addr6;
+		memset(&addr6, 0, sizeof(addr6));
+		addr6.sin6_family = AF_INET6;
+		addr6.sin6_port = htons(groupPort);
+		addr6.sin6_addr = in6addr_any;
+
+		struct ipv6_mreq membership;
+		memset(&membership, 0, sizeof(membership));
+		membership.ipv6mr_interface = 0;
+
+		if(inet_pton(AF_INET6, group.c_str(), &membership.ipv6mr_multiaddr) == 1 && IN6_IS_ADDR_MULTICAST(&membership.ipv6mr_multiaddr) &&
+			bind(fd, reinterpret_cast<const sockaddr*>(&addr6), sizeof(addr6)) == 0 &&
+			setsockopt(fd, IPPROTO_IPV6, IPV6_JOIN_GROUP, &membership, sizeof(membership)) == 0)
+		{
+			addr6.sin6_addr = membership.ipv6mr_multiaddr;
+			memcpy(&groupAddress, &addr6, sizeof(addr6));
+			groupAddressLength = sizeof(addr6);
+			joined = true;
+		}
+	}
+
+	if(!joined)
+	{
+		const string error = strerror(errno);
+		close(fd);
+		throw ListenerException(string("Unable to join multicast group ")+group+": "+error);
+	}
+
+	t = new thread(&MulticastDiscovery::discoveryFunction, this);
+}
+
+MulticastDiscovery::~MulticastDiscovery()
+{
+	running = false;
+	t->join();
+	delete t;
+
+	close(fd);
+}
+
+void MulticastDiscovery::getDiscovered(list<string> &out)
+{
+	discoveredMutex.lock();
+	out.insert(out.end(), discovered.begin(), discovered.end());
+	discovered.clear();
+	discoveredMutex.unlock();
+}
+
+void MulticastDiscovery::announce()
+{
+	char announcement[announcementSize];
+	const uint16_t port = htons(servicePort);
+	memcpy(announcement, announcementMessage, sizeof(announcementMessage) - 1);
+	memcpy(announcement + sizeof(announcementMessage) - 1, &port, sizeof(port));
+
+	sendto(fd, announcement, announcementSize, 0, reinterpret_cast<const sockaddr*>(&groupAddress), groupAddressLength);
+}
+
+void MulticastDiscovery::discoveryFunction()
+{
+	auto lastAnnouncement = chrono::steady_clock::now() - chrono::seconds(interval);
+
+	while(running)
+	{
+		const auto now = chrono::steady_clock::now();
+		if(now - lastAnnouncement >= chrono::seconds(interval))
+		{
+			announce();
+			lastAnnouncement = now;
+		}
+
+		struct pollfd p;
+		p.fd = fd;
+		p.events = POLLIN;
+		if(::poll(&p, 1, pollInterval) <= 0)continue;
+
+		char announcement[announcementSize + 1];
+		struct sockaddr_storage sender;
+		socklen_t senderLength = sizeof(sender);
+		const ssize_t size = recvfrom(fd, announcement, sizeof(announcement), 0, reinterpret_cast<sockaddr*>(&sender), &senderLength);
+
+		if(size != ssize_t(announcementSize) || memcmp(announcement, announcementMessage, sizeof(announcementMessage) - 1) != 0)continue;
+
+		//Only members of the same cluster use the same port
+		uint16_t port;
+		memcpy(&port, announcement + sizeof(announcementMessage) - 1, sizeof(port));
+		if(ntohs(port) != servicePort)continue;
+
+		char address[INET6_ADDRSTRLEN];
+		const void *source = nullptr;
+		if(sender.ss_family == AF_INET)source = &reinterpret_cast<const sockaddr_in*>(&sender)->sin_addr;
+		else if(sender.ss_family == AF_INET6)source = &reinterpret_cast<const sockaddr_in6*>(&sender)->sin6_addr;
+		if(!source || !inet_ntop(sender.ss_family, source, address, sizeof(address)))continue;
+
+		discoveredMutex.lock();
+		discovered.insert(address);
+		discoveredMutex.unlock();
+	}
+}
+
+#endif //__linux__
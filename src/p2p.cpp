@@ -15,7 +15,11 @@
 #include <string>
 #include <list>
 #include <iostream>
+#include <fstream>
 #include <algorithm>
+#include <unordered_map>
+#include <condition_variable>
+#include <cmath>
 #include <unistd.h>
 #include <time.h>
 #include <assert.h>
@@ -64,7 +68,31 @@ namespace cluster
 		/**
 		  * This messages means that the sender went offline
 		 **/
-		went_offline = 'w'
+		went_offline = 'w',
+
+		/**
+		  * A ping is sent to a member to check whether it
+		  * is still online. It is answered with a ping ack.
+		  * Both carry the gossip of the sender
+		 **/
+		ping = 'g',
+
+		/**
+		  * The answer to a ping
+		 **/
+		ping_ack = 'k',
+
+		/**
+		  * This message asks the target member to ping a
+		  * member which didn't answer the ping of the sender
+		 **/
+		ping_request = 'q',
+
+		/**
+		  * This message tells the member which sent
+		  * a ping request that the member answered
+		 **/
+		indirect_ack = 'i'
 
 	}; //end enum p2pOperation
 
@@ -91,35 +119,149 @@ namespace cluster
 
 } //end namespace cluster
 
+/**
+  * The interval in seconds in which the
+  * addresses of the seed files are checked
+ **/
+static const double seedInterval = 10;
+
+/**
+  * The version which is sent in the echo. Older
+  * versions don't send it and are pinged using
+  * the echo message
+ **/
+static const char protocolVersion = 2;
+
+/**
+  * The first version which supports
+  * the failure detection
+ **/
+static const char gossipVersion = 1;
+
+/**
+  * The first version which reads the
+  * batches of ClusterObjectSerialized
+ **/
+static const char batchVersion = 2;
+
+/**
+  * The maximum amount of member changes
+  * which are piggybacked on one message
+ **/
+static const std::size_t maxPiggybackedGossip = 8;
+
+/**
+  * Every member change is piggybacked this many
+  * times the logarithm of the amount of members
+ **/
+static const double gossipRetransmitMultiplier = 3;
+
+/**
+  * Checks whether the given message is handled by
+  * p2p itself like the pings and the echo messages.
+  * The Server handles these before the messages
+  * of the child objects
+ **/
+static bool isControlMessage(const Package &message)
+{
+	return ClusterObject::isForCurrent(message);
+}
+
+/**
+  * An immutable snapshot of the members. Readers load
+  * the current snapshot without locking memberMutex.
+  * Writers copy it, change the copy and replace the
+  * snapshot while they hold memberMutex
+ **/
+struct p2p::MemberTable
+{
+	MemberTable() :
+		clients(),
+		index()
+	{}
+
+	/**
+	  * Returns whether a member has the given address
+	 **/
+	bool contains(const Address &address) const
+	{
+		return index.find(AddressKey(address)) != index.end();
+	}
+
+	/**
+	  * The members in no particular order
+	 **/
+	vector<Client> clients;
+
+	/**
+	  * The position of every member in clients
+	 **/
+	unordered_map<AddressKey,std::size_t> index;
+};
+
 p2p::p2p(const Protocol &p) :
 	ClusterObject(nullptr),
 	addressRangeMutex(),
 	addressRanges(),
+	seeds(),
 	protocol(p),
+	pool(p),
 	isConnected(true),
 	otherPeersToCheck(),
 	otherPeersToCheckMutex(),
 	addresses(),
-	members(),
+	members(new MemberTable()),
 	server(nullptr),
 	testAliveThread(nullptr),
+	failureDetectorThread(nullptr),
 	memberMutex(),
 	memberCallbacks(),
 	startTime(),
 	reconnectRetries(3),
 	continueWithoutMembers(true),
-	callbackMutex()
+	scanConcurrency(256),
+	scanTimeout(1000),
+	compactFormat(true),
+	usesCompactFormat(false),
+	unbatchedMembers(),
+	callbackMutex(),
+	protocolPeriod(1000),
+	indirectProbes(3),
+	suspicionMultiplier(4),
+	memberStates(),
+	probeOrder(),
+	probeIndex(0),
+	randomGenerator(std::random_device()()),
+	incarnation(0),
+	gossip(),
+	pendingProbes(),
+	gossipedMembers(),
+	gossipMutex()
 {
+	//A network without members can use the compact
+	//Format, it is changed when members join
+	updateFormat();
+
 	//Measure start time to determine master host
 	struct timeval t;
 	gettimeofday(&t, nullptr);
 	startTime = (unsigned long long)t.tv_sec * 1000000 + t.tv_usec;
 
+	//Requests to other members are multiplexed over one
+	//connection. Messages which are received over it are
+	//handled like messages received by the server
+	pool.setMultiplexing(true);
+	pool.setMessageCallback([this](const Address &ip, const Package &message, Package &to_send)
+	{
+		Package answer;
+		this->received_channel(ip, message, answer, to_send);
+	});
+
 	//Get Addresses of current computer
 	protocol.getAddresses(addresses);
 	for(auto it = addresses.cbegin(); it != addresses.cend(); it++)
 	{
-		cout<<"Server address: "<<(*it)->address<<endl;
+		cout<<"Server address: "<<(*it)->toString()<<endl;
 	}
 
 	//Open server socket and search thread
@@ -146,10 +288,36 @@ p2p::~p2p()
 		delete it->first;
 		delete it->second;
 	}
+
+	//Delete seed addresses
+	for(Address *a : seeds)
+	{
+		delete a;
+	}
+}
+
+void p2p::setCompactFormat(bool b_compactFormat)
+{
+	compactFormat = b_compactFormat;
+	updateFormat();
+}
+
+void p2p::updateFormat()
+{
+	bool compact = compactFormat;
+	memberMutex.lock();
+	for(const auto &state : memberStates)
+	{
+		if(state.second.format != Package::Format::compact)compact = false;
+	}
+	usesCompactFormat = compact;
+	memberMutex.unlock();
 }
 
 void p2p::open()
 {
+	pool.getExecutor().start();
+
 	if(!server)
 	{
 		//Open Server socket
@@ -164,6 +332,11 @@ void p2p::open()
 				{
 					this->received_internal(ip, message, answer);
 				});
+				server->setChannelCallback([this](const Address &ip, const Package &message, Package &answer, Package &to_send)
+				{
+					this->received_channel(ip, message, answer, to_send);
+				});
+				server->setPriorityCallback(&isControlMessage);
 				connected = true;
 			}catch(const ServerException &e){
 				cout<<"ServerException: "<<e.text<<" Retrying..."<<endl;
@@ -176,6 +349,11 @@ void p2p::open()
 	{
 		testAliveThread = new thread(&p2p::connectToHosts, this);
 	}
+
+	if(!failureDetectorThread)
+	{
+		failureDetectorThread = new thread(&p2p::detectFailures, this);
+	}
 }
 
 void p2p::close()
@@ -189,11 +367,26 @@ void p2p::close()
 		testAliveThread = nullptr;
 	}
 
+	if(failureDetectorThread)
+	{
+		failureDetectorThread->join();
+		delete failureDetectorThread;
+		failureDetectorThread = nullptr;
+	}
+
 	if(server)
 	{
 		delete server;
 		server = nullptr;
 	}
+
+	//The tasks of the Executor use the network,
+	//so they are finished first
+	pool.getExecutor().shutdown();
+
+	//Close the Channels so that no more
+	//messages are received
+	pool.clear();
 }
 
 bool p2p::isOwnAddress(const Address &a) const
@@ -206,6 +399,11 @@ bool p2p::isOwnAddress(const Address &a) const
 	return false;
 }
 
+ServerStatistics p2p::getServerStatistics() const
+{
+	return server ? server->getStatistics() : ServerStatistics();
+}
+
 void p2p::addAddressRange(const Address &start, const Address &end)
 {
 	addressRangeMutex.lock();
@@ -213,15 +411,52 @@ void p2p::addAddressRange(const Address &start, const Address &end)
 	addressRangeMutex.unlock();
 }
 
+bool p2p::addSeedFile(const string &fileName)
+{
+	ifstream in(fileName);
+	if(!in)return false;
+
+	string line;
+	while(getline(in, line))
+	{
+		//Remove whitespace around the address
+		const std::size_t start = line.find_first_not_of(" \t\r");
+		if(start == string::npos || line[start] == '#')continue;
+		line = line.substr(start, line.find_last_not_of(" \t\r") - start + 1);
+
+		if(Address *a = protocol.decodeAddress(line))
+		{
+			addressRangeMutex.lock();
+			seeds.push_back(a);
+			addressRangeMutex.unlock();
+		}
+		else cout<<"Invalid seed address: "<<line<<endl;
+	}
+
+	return true;
+}
+
 void p2p::received_internal(const Address &ip, const Package &message, Package &answer)
 {
 	Package to_send;
+	received_channel(ip, message, answer, to_send);
+	if(!to_send.empty())Client(ip, protocol, &pool).send(to_send);
+}
+
+void p2p::received_channel(const Address &ip, const Package &message, Package &answer, Package &to_send)
+{
+	//The answer and all Packages which are created while
+	//handling the message use the Format of the message.
+	//The Channel tells in which Format it was sent
+	Package::FormatScope scope(message.getFormat());
+	answer.setFormat(message.getFormat());
+	to_send.setFormat(message.getFormat());
+
 	bool success = this->ClusterObject_received(ip, message, answer, to_send);
 	if(!success)
 	{
 		cout<<"Invalid package: "<<message.toString()<<endl;
 	}
-	if(!to_send.empty())Client(ip,protocol).send(to_send);
 }
 
 void p2p::connectToHosts()
@@ -230,33 +465,43 @@ void p2p::connectToHosts()
 	time_t t2;
 	time(&t1);
 
-	unsigned int memberIndex = 0;
-	bool askMember = true;
+	time_t lastDiscovery = 0;
+	time_t lastSeedCheck = 0;
+
+	//Check whether the Protocol can probe
+	//many Addresses at once
+	vector<bool> reachable;
+	const bool probing = protocol.probeAddresses(vector<const Address*>(), reachable, 1, 0);
 
 	auto it = addressRanges.cbegin();
 	Address *currentAddress = nullptr;
 	Address *currentAddressEnd = nullptr;
 	while(isConnected)
 	{
-		//Members are checked every second time
-		if((askMember = !askMember))
-		{
-			Address *a = nullptr;
+		//Close connections which were not used for a while
+		pool.cleanup();
 
-			memberMutex.lock();
-			if(memberIndex >= members.size())memberIndex = 0;
-			if(memberIndex < members.size())
-			{
-				auto memberIt = members.cbegin();
-				for(unsigned int i = 0; i < memberIndex; ++i, ++memberIt);
-				a = memberIt->getAddress().clone();
-			}
-			memberMutex.unlock();
+		//Members which the Protocol finds
+		//on its own are checked every second
+		const time_t now = time(nullptr);
+		if(difftime(now, lastDiscovery) >= 1)
+		{
+			discoverMembers();
+			lastDiscovery = now;
+		}
 
-			if(a)testConnection(*a, 1);
-			delete a;
+		//The seeds are checked less often because
+		//most of them are members already
+		if(difftime(now, lastSeedCheck) >= seedInterval)
+		{
+			connectToSeeds();
+			lastSeedCheck = now;
 		}
 
+		//The members are checked by the failureDetectorThread,
+		//it only tells which members it heard of
+		connectToGossipedMembers();
+
 		//Continue if no address ranges exist
 		if(it == addressRanges.cend())
 		{
@@ -265,108 +510,300 @@ void p2p::connectToHosts()
 			continue;
 		}
 
-		//Create address ranges from iterator
-		if(!currentAddress || !currentAddressEnd)
+		//Protocols which can probe many Addresses at
+		//once get a whole batch, the others one Address
+		const std::size_t batchSize = probing ? max(scanConcurrency.load(), 1U) : 1;
+		vector<Address*> batch;
+		bool sweepFinished = false;
+		while(batch.size() < batchSize && !sweepFinished)
 		{
-			currentAddress = it->first->clone();
-			currentAddressEnd = it->second->clone();
+			//Create address ranges from iterator
+			if(!currentAddress || !currentAddressEnd)
+			{
+				currentAddress = it->first->clone();
+				currentAddressEnd = it->second->clone();
+			}
+
+			//Increase iterator if address range end reached
+			if((*currentAddress) == (*currentAddressEnd))
+			{
+				delete currentAddress;
+				delete currentAddressEnd;
+				currentAddress = nullptr;
+				currentAddressEnd = nullptr;
+
+				addressRangeMutex.lock();
+				if(++it == addressRanges.cend())
+				{
+					it = addressRanges.cbegin();
+					sweepFinished = true;
+				}
+				addressRangeMutex.unlock();
+				continue;	//Continuing to create address ranges from iterator
+			}
+
+			if(!isOwnAddress(*currentAddress))batch.push_back(currentAddress->clone());
+			currentAddress->increase();
 		}
 
-		//Increase iterator if address range end reached
-		if((*currentAddress) == (*currentAddressEnd))
+		if(probing)
 		{
-			delete currentAddress;
-			delete currentAddressEnd;
-			currentAddress = nullptr;
-			currentAddressEnd = nullptr;
+			//Only the Addresses which accept connections are
+			//asked, members are checked on their own
+			const vector<const Address*> toProbe(batch.begin(), batch.end());
+			protocol.probeAddresses(toProbe, reachable, scanConcurrency, scanTimeout);
+			for(std::size_t i = 0; i < batch.size(); ++i)
+			{
+				if(reachable[i] && !isMember(*batch[i]))testConnection(*batch[i], 1);
+			}
 
-			addressRangeMutex.lock();
-			if(++it == addressRanges.cend())
+			//Every sweep over all address ranges takes
+			//at least one second
+			if(sweepFinished)
 			{
-				it = addressRanges.cbegin();
+				time(&t2);
+				if(difftime(t2, t1) < 1)sleep(1);
+				time(&t1);
 			}
-			addressRangeMutex.unlock();
-			continue;	//Continuing to create address ranges from iterator
 		}
-		
-		
-		if(!isOwnAddress(*currentAddress))
+		else if(!batch.empty())
 		{
-			bool is_online = testConnection(*currentAddress, 1);
+			bool is_online = testConnection(*batch.front(), 1);
 			time(&t2);
 			if(difftime(t2, t1) < 0.2 && !is_online)sleep(1);
 			t1 = t2;
 		}
 
-		currentAddress->increase();
+		for(Address *a : batch)delete a;
 	}
 
 	delete currentAddress;
 	delete currentAddressEnd;
 }
 
+void p2p::discoverMembers()
+{
+	list<Address*> discovered;
+	if(!protocol.discoverAddresses(discovered))return;
+
+	for(Address *a : discovered)
+	{
+		if(!isOwnAddress(*a) && !isMember(*a))testConnection(*a, 1);
+		delete a;
+	}
+}
+
+void p2p::connectToSeeds()
+{
+	list<Address*> toCheck;
+	addressRangeMutex.lock();
+	for(const Address *a : seeds)
+	{
+		toCheck.push_back(a->clone());
+	}
+	addressRangeMutex.unlock();
+
+	for(Address *a : toCheck)
+	{
+		if(!isOwnAddress(*a) && !isMember(*a))testConnection(*a, 1);
+		delete a;
+	}
+}
+
+void p2p::connectToGossipedMembers()
+{
+	list<string> toCheck;
+	gossipMutex.lock();
+	toCheck.swap(gossipedMembers);
+	gossipMutex.unlock();
+
+	for(const string &address : toCheck)
+	{
+		Address *a = protocol.decodeAddress(address);
+		if(!a)continue;
+		if(!isOwnAddress(*a) && !isMember(*a))testConnection(*a, 1);
+		delete a;
+	}
+}
+
 bool p2p::testConnection(const Address &ip, unsigned int retry)
 {
 	/*if(members.empty())
 	{
-		cout<<"Trying connection to "<<ip.address<<endl;
+		cout<<"Trying connection to "<<ip.toString()<<endl;
 	}*/
 
 	for(unsigned int i = 0; i < retry; i++)
 	{
 		if(i > 0)
 		{
-			cout<<"Retrying connection to "<<ip.address<<endl;
+			cout<<"Retrying connection to "<<ip.toString()<<endl;
 			sleep(1);
 		}
 
-		if(ask(ip, p2pOperation::echo_message, startTime, nullptr))return true;
+		//The echo is sent to members which might not
+		//support the compact Format
+		Package::FormatScope scope(Package::Format::fixed);
+		Package message;
+		message<<p2pOperation::echo_message;
+		message<<startTime;
+		message<<supportedFormat();
+		message<<protocolVersion;
+		if(askPackage(ip, message, nullptr))return true;
 	}
 	offline(ip);
 	return false;
 }
 
+bool p2p::readsFormat(const Address &address, Package::Format format)
+{
+	if(format != Package::Format::compact)return true;
+
+	memberMutex.lock();
+	auto state = memberStates.find(AddressKey(address));
+	const bool compact = (state != memberStates.end() && state->second.format == Package::Format::compact);
+	memberMutex.unlock();
+
+	return compact;
+}
+
+bool p2p::ClusterObject_readsBatches()
+{
+	memberMutex.lock();
+	const bool readsBatches = unbatchedMembers.empty();
+	memberMutex.unlock();
+
+	return readsBatches;
+}
+
+Package::Format p2p::ClusterObject_getFormat()
+{
+	return usesCompactFormat ? Package::Format::compact : Package::Format::fixed;
+}
+
 bool p2p::ClusterObject_ask(const Address &ip, const Package &message, Package *answer)
 {
 	assert(message.getLength() > 0);
+	if(!readsFormat(ip, message.getFormat()))return false;
+
+	//The answer has the Format of the message
+	const bool success = Client(ip, protocol, &pool).send(message, answer);
+	if(answer)answer->setFormat(message.getFormat());
+	return success;
+}
+
+void p2p::ClusterObject_askAsync(const Address &ip, const Package &message, Package *answer, function<void(bool)> callback)
+{
+	assert(message.getLength() > 0);
+	if(!readsFormat(ip, message.getFormat()))
+	{
+		callback(false);
+		return;
+	}
+
+	const Package::Format format = message.getFormat();
+	Client(ip, protocol, &pool).sendAsync(message, answer, [answer,format,callback](bool success)
+	{
+		if(answer)answer->setFormat(format);
+		callback(success);
+	});
+}
+
+shared_ptr<const p2p::MemberTable> p2p::getMembers() const
+{
+	return atomic_load(&members);
+}
 
-	return Client(ip, protocol).send(message, answer);
+bool p2p::addMember(const Client &client)
+{
+	shared_ptr<const MemberTable> current = getMembers();
+	if(current->contains(client.getAddress()))return false;
+
+	shared_ptr<MemberTable> table(new MemberTable(*current));
+	table->index[AddressKey(client.getAddress())] = table->clients.size();
+	table->clients.push_back(client);
+	atomic_store(&members, shared_ptr<const MemberTable>(table));
+	return true;
+}
+
+bool p2p::removeMember(const Address &address)
+{
+	shared_ptr<const MemberTable> current = getMembers();
+	auto it = current->index.find(AddressKey(address));
+	if(it == current->index.end())return false;
+
+	//The last member takes the place of the removed one
+	shared_ptr<MemberTable> table(new MemberTable(*current));
+	const std::size_t position = it->second;
+	if(position + 1 != table->clients.size())
+	{
+		table->clients[position] = table->clients.back();
+		table->index[AddressKey(table->clients[position].getAddress())] = position;
+	}
+	table->clients.pop_back();
+	table->index.erase(AddressKey(address));
+	atomic_store(&members, shared_ptr<const MemberTable>(table));
+	return true;
+}
+
+std::size_t p2p::getMembersCount() const
+{
+	return getMembers()->clients.size();
 }
 
 bool p2p::isMember(const Client &client)
 {
-	memberMutex.lock();
-	bool member = find(members.begin(), members.end(), client) != members.end();
-	memberMutex.unlock();
-	return member;
+	return getMembers()->contains(client.getAddress());
 }
 
 bool p2p::isMember(const Address &address)
 {
-	memberMutex.lock();
-	bool member = find(members.begin(), members.end(), address) != members.end();
-	memberMutex.unlock();
-	return member;
+	return getMembers()->contains(address);
+}
+
+char p2p::supportedFormat() const
+{
+	return char(compactFormat ? Package::Format::compact : Package::Format::fixed);
 }
 
-void p2p::online(const Address &address, unsigned long long otherTime)
+void p2p::online(const Address &address, unsigned long long otherTime, bool compact, bool supportsGossip, bool readsBatches)
 {
 	//The one with the smaller startTime is the master
 	bool isMaster = (otherTime < startTime);
-	const Client client(address, protocol);
+	const Client client(address, protocol, &pool);
+
+	//Add to members. The echo and its response can
+	//arrive at the same time, only the first one counts
+	memberMutex.lock();
+	if(!addMember(client))
+	{
+		memberMutex.unlock();
+		return;
+	}
+	if(!readsBatches)unbatchedMembers.push_back(client);
+	MemberState &state = memberStates[AddressKey(address)];
+	state.gossip = supportsGossip;
+	state.format = compact ? Package::Format::compact : Package::Format::fixed;
+	memberMutex.unlock();
+	updateFormat();
 
 	//Remember host that it needs to answer its members
 	otherPeersToCheckMutex.lock();
 	otherPeersToCheck.push_back(client);
 	otherPeersToCheckMutex.unlock();
 
-	//Add to members
-	memberMutex.lock();
-	members.push_back(client);
-	memberMutex.unlock();
+	//The other members learn about the new one
+	addGossip(address.toString(), MemberStatus::alive, 0);
 
-	//Ask for other peers
-	ask(address, p2pOperation::other_peers, nullptr);
+	//Ask for other peers. If the member can't be asked,
+	//its answer is not waited for before sending. It is
+	//tested by the failure detector like all members
+	if(!ask(address, p2pOperation::other_peers, nullptr))uncheckOtherPeers(address);
+
+	//The echo might have been received in the fixed Format.
+	//The callbacks create their Packages in the Format of
+	//the network, e.g. the requests to catch up
+	Package::FormatScope scope(ClusterObject_getFormat());
 
 	//Notify callbacks
 	callbackMutex.lock();
@@ -382,13 +819,18 @@ void p2p::offline(const Address &address)
 	bool wasMember = false;
 
 	memberMutex.lock();
-	auto index = find(members.begin(), members.end(), address);
-	if(index != members.end())
-	{
-		wasMember = true;
-		members.erase(index);
-	}
+	wasMember = removeMember(address);
+	auto unbatchedIndex = find(unbatchedMembers.begin(), unbatchedMembers.end(), address);
+	if(unbatchedIndex != unbatchedMembers.end())unbatchedMembers.erase(unbatchedIndex);
+	memberStates.erase(AddressKey(address));
 	memberMutex.unlock();
+	updateFormat();
+
+	//Its other peers are not waited for anymore
+	uncheckOtherPeers(address);
+
+	//Connections to the member are not needed anymore
+	pool.remove(address);
 
 	//Notify callbacks
 	if(wasMember)
@@ -402,7 +844,132 @@ void p2p::offline(const Address &address)
 	}
 }
 
+/**
+  * The state of an asynchronous broadcast which
+  * is shared by the callbacks of all members
+ **/
+struct p2p::Broadcast
+{
+	Broadcast(const Package &p_message, AnswerPackage *p_answer, function<void(bool)> fn_callback) :
+		message(p_message),
+		answer(p_answer),
+		callback(fn_callback),
+		clients(),
+		answers(),
+		success(),
+		remaining(0),
+		answerMutex()
+	{}
+
+	Broadcast(const Broadcast &b) = delete;
+	Broadcast& operator=(const Broadcast &b) = delete;
+
+	Package message;
+	AnswerPackage *answer;
+	function<void(bool)> callback;
+	vector<Client> clients;
+	vector<Package> answers;
+	vector<char> success;
+	std::size_t remaining;
+	mutex answerMutex;
+};
+
 bool p2p::ClusterObject_send(const Package &message, AnswerPackage *answer)
+{
+	checkOtherPeers();
+
+	//Sending Package to every member
+	shared_ptr<const MemberTable> current = getMembers();
+	const list<Client> toSend(current->clients.cbegin(), current->clients.cend());
+
+	mutex answerMutex;
+	return sendToMembers(message, answer, toSend, answerMutex);
+}
+
+void p2p::ClusterObject_sendAsync(const Package &message, AnswerPackage *answer, function<void(bool)> callback)
+{
+	//Joining members need to be checked before sending
+	//which can take a while, so this is done by the Executor
+	otherPeersToCheckMutex.lock();
+	const bool checkPeers = !otherPeersToCheck.empty();
+	otherPeersToCheckMutex.unlock();
+	if(checkPeers)
+	{
+		if(!pool.getExecutor().execute([this,message,answer,callback]()
+		{
+			callback(ClusterObject_send(message, answer));
+		}))callback(false);
+		return;
+	}
+
+	shared_ptr<Broadcast> broadcast(new Broadcast(message, answer, callback));
+	for(const Client &client : getMembers()->clients)
+	{
+		if(readsFormat(client.getAddress(), message.getFormat()))broadcast->clients.push_back(client);
+	}
+	broadcast->answers.resize(broadcast->clients.size());
+	broadcast->success.resize(broadcast->clients.size(), false);
+	broadcast->remaining = broadcast->clients.size();
+
+	if(broadcast->clients.empty())
+	{
+		callback(true);
+		return;
+	}
+
+	//The Package is sent to all members at once without
+	//waiting. The last answer finishes the broadcast
+	for(std::size_t i = 0; i < broadcast->clients.size(); ++i)
+	{
+		broadcast->clients[i].sendAsync(broadcast->message, answer ? &broadcast->answers[i] : nullptr, [this,broadcast,i](bool success)
+		{
+			broadcastAnswered(broadcast, i, success);
+		});
+	}
+}
+
+void p2p::broadcastAnswered(const shared_ptr<Broadcast> &broadcast, std::size_t index, bool success)
+{
+	broadcast->answerMutex.lock();
+	broadcast->success[index] = success;
+	if(success && broadcast->answer)
+	{
+		broadcast->answers[index].setFormat(broadcast->message.getFormat());
+		broadcast->answer->add(broadcast->clients[index].getAddress(), broadcast->answers[index]);
+	}
+	const bool last = (--broadcast->remaining == 0);
+	broadcast->answerMutex.unlock();
+
+	if(!last)return;
+
+	list<Client> toSend;
+	for(std::size_t i = 0; i < broadcast->clients.size(); ++i)
+	{
+		if(!broadcast->success[i])toSend.push_back(broadcast->clients[i]);
+	}
+
+	if(toSend.empty())
+	{
+		broadcast->callback(true);
+		return;
+	}
+
+	//The members which didn't answer are tested and
+	//the Package is sent again like in a synchronous
+	//broadcast. This blocks, so it is done by the Executor
+	shared_ptr<Broadcast> b(broadcast);
+	if(!pool.getExecutor().execute([this,b,toSend]()
+	{
+		retestMembers(toSend);
+
+		//Wait for some time to let clients respond
+		usleep(1000);
+
+		b->callback(sendToMembers(b->message, b->answer, toSend, b->answerMutex));
+	}))b->callback(false);
+}
+
+void p2p::checkOtherPeers()
 {
 	//Other peers need to be checked before sending
 	otherPeersToCheckMutex.lock();
@@ -419,72 +986,67 @@ bool p2p::ClusterObject_send(const Package &message, AnswerPackage *answer)
 		memberMutex.lock();
 		for(const Client &c : otherPeersToCheck)
 		{
-			auto it = find(members.begin(), members.end(), c);
-			if(it == members.end())cout<<"Strange: Waited for p2pOperation::other_peers_response for a client who isn't a memeber"<<endl;
-			else members.erase(it);
+			if(!removeMember(c.getAddress()))cout<<"Strange: Waited for p2pOperation::other_peers_response for a client who isn't a memeber"<<endl;
+			memberStates.erase(AddressKey(c.getAddress()));
 		}
 		memberMutex.unlock();
 		otherPeersToCheck.clear();
 	}
 	otherPeersToCheckMutex.unlock();
+	updateFormat();
 
-	//Sending Package to every member
-	list<Client> toSend;
-	memberMutex.lock();
-	for(auto it = members.cbegin(); it != members.cend(); it++)
-	{
-		toSend.push_back(*it);
-	}
-	memberMutex.unlock();
+}
 
+void p2p::uncheckOtherPeers(const Address &address)
+{
+	otherPeersToCheckMutex.lock();
+	auto it = find(otherPeersToCheck.begin(), otherPeersToCheck.end(), address);
+	if(it != otherPeersToCheck.end())otherPeersToCheck.erase(it);
+	otherPeersToCheckMutex.unlock();
+}
+
+bool p2p::sendToMembers(const Package &message, AnswerPackage *answer, list<Client> toSend, mutex &answerMutex)
+{
 	while((!continueWithoutMembers || !toSend.empty()) && !toSend.empty())
 	{
-		for(auto it = toSend.begin(); it != toSend.end(); it++)
+		//Members which went offline in the meantime or
+		//which can't read the Package are skipped
+		shared_ptr<const MemberTable> current = getMembers();
+		for(auto it = toSend.begin(); it != toSend.end(); )
 		{
-			//Lock member mutex and check if the client is still
-			//member of the cluster.
-			memberMutex.lock();
-			if(find(members.begin(), members.end(), (*it)) == members.end())
-			{
-				memberMutex.unlock();
-				continue;
-			}
+			if(!current->contains(it->getAddress()) || !readsFormat(it->getAddress(), message.getFormat()))it = toSend.erase(it);
+			else ++it;
+		}
 
-			bool success;
-			if(answer)
-			{
-				Package temp_answer;
-				success = it->send(message, &temp_answer);
-				if(success)answer->add(it->getAddress(), temp_answer);
-			}
-			else
+		//The Package is sent to all members at once.
+		//The answers are added as they arrive
+		vector<char> success(toSend.size(), false);
+		auto sendTo = [&message,answer,&answerMutex,&success](const Client &client, std::size_t index)
+		{
+			Package temp_answer;
+			success[index] = client.send(message, answer ? &temp_answer : nullptr);
+			if(success[index] && answer)
 			{
-				success = it->send(message, nullptr);
+				temp_answer.setFormat(message.getFormat());
+				answerMutex.lock();
+				answer->add(client.getAddress(), temp_answer);
+				answerMutex.unlock();
 			}
+		};
+		forEachConcurrently(toSend, sendTo);
 
-			if(success)
-			{
-				auto temp = it--;
-				toSend.erase(temp);
-			}
-			memberMutex.unlock();
+		//Remove the members which got the Package
+		std::size_t index = 0;
+		for(auto it = toSend.begin(); it != toSend.end(); ++index)
+		{
+			if(success[index])it = toSend.erase(it);
+			else ++it;
 		}
 
 		//Test connection if not enough members answered
 		if(!toSend.empty())
 		{
-			for(auto it = toSend.begin(); it != toSend.end(); it++)
-			{
-				memberMutex.lock();
-				auto found = find(members.begin(), members.end(), (*it));
-				memberMutex.unlock();
-				if(found == members.cend())
-				{
-					auto temp = it--;
-					toSend.erase(temp);
-				}
-				else testConnection(it->getAddress(), reconnectRetries);
-			}
+			retestMembers(toSend);
 
 			//Wait for some time to let clients respond
 			usleep(1000);
@@ -494,7 +1056,381 @@ bool p2p::ClusterObject_send(const Package &message, AnswerPackage *answer)
 	return true;
 }
 
-bool p2p::received(const Address &ip, const Package &message, Package &/*answer*/, Package &to_send)
+void p2p::retestMembers(const list<Client> &clients)
+{
+	forEachConcurrently(clients, [this](const Client &client, std::size_t)
+	{
+		testConnection(client.getAddress(), reconnectRetries);
+	});
+}
+
+void p2p::forEachConcurrently(const list<Client> &clients, const function<void(const Client &client, std::size_t index)> &fn)
+{
+	vector<const Client*> indexed;
+	for(const Client &client : clients)indexed.push_back(&client);
+
+	pool.getExecutor().forEach(indexed.size(), [&indexed,&fn](std::size_t index)
+	{
+		fn(*indexed[index], index);
+	});
+}
+
+/**
+  * The state of a ping which is shared with the
+  * callbacks of the members which answer it
+ **/
+struct p2p::Probe
+{
+	Probe() :
+		answer(),
+		done(false),
+		acked(false),
+		m(),
+		cv()
+	{}
+
+	Probe(const Probe &p) = delete;
+	Probe& operator=(const Probe &p) = delete;
+
+	/**
+	  * Called when the member answered or when
+	  * one of the pings failed
+	 **/
+	void answered(bool success)
+	{
+		m.lock();
+		done = true;
+		if(success)acked = true;
+		m.unlock();
+		cv.notify_all();
+	}
+
+	/**
+	  * Waits until the deadline or until the member
+	  * answered. If anyAnswer is set, a failed ping
+	  * stops waiting as well. Returns whether the
+	  * member answered
+	 **/
+	bool wait(chrono::steady_clock::time_point deadline, bool anyAnswer)
+	{
+		unique_lock<mutex> lock(m);
+		cv.wait_until(lock, deadline, [this,anyAnswer]{ return acked || (anyAnswer && done); });
+		return acked;
+	}
+
+	Package answer;
+	bool done;
+	bool acked;
+	mutex m;
+	condition_variable cv;
+};
+
+void p2p::detectFailures()
+{
+	while(isConnected)
+	{
+		const auto start = chrono::steady_clock::now();
+
+		expireSuspects();
+
+		Address *target = nextProbeTarget();
+		if(target)probe(*target);
+		delete target;
+
+		//Every protocol period takes the same time, so
+		//the load doesn't depend on the amount of members
+		const auto end = start + chrono::milliseconds(protocolPeriod.load());
+		while(isConnected && chrono::steady_clock::now() < end)usleep(10000);
+	}
+}
+
+Address* p2p::nextProbeTarget()
+{
+	//A new round starts in a random order
+	//when all members were pinged
+	if(probeIndex >= probeOrder.size())
+	{
+		probeOrder.clear();
+		probeIndex = 0;
+
+		memberMutex.lock();
+		for(const auto &state : memberStates)
+		{
+			probeOrder.push_back(state.first);
+		}
+		memberMutex.unlock();
+
+		shuffle(probeOrder.begin(), probeOrder.end(), randomGenerator);
+	}
+
+	//Members which went offline in the meantime are skipped
+	shared_ptr<const MemberTable> current = getMembers();
+	while(probeIndex < probeOrder.size())
+	{
+		const Address &address = probeOrder[probeIndex++].get();
+		if(current->contains(address))return address.clone();
+	}
+
+	return nullptr;
+}
+
+void p2p::probe(const Address &target)
+{
+	const chrono::milliseconds period(protocolPeriod.load());
+	const auto start = chrono::steady_clock::now();
+	const string targetName = target.toString();
+	shared_ptr<Probe> p(new Probe());
+
+	//The member has half of the protocol period to answer
+	askPackageAsync(target, createPing(target), &p->answer, [p](bool success)
+	{
+		p->answered(success);
+	});
+	if(p->wait(start + period / 2, true))
+	{
+		p2pOperation t;
+		if(p->answer>>t && t == p2pOperation::ping_ack)readGossip(target, p->answer);
+		return;
+	}
+
+	//Other members which support the ping
+	//request are asked to ping the member
+	vector<Client> helpers;
+	shared_ptr<const MemberTable> current = getMembers();
+	memberMutex.lock();
+	for(const Client &client : current->clients)
+	{
+		auto state = memberStates.find(AddressKey(client.getAddress()));
+		if(client.getAddress() != target && state != memberStates.end() && state->second.gossip)helpers.push_back(client);
+	}
+	memberMutex.unlock();
+
+	//Some of them are chosen randomly
+	vector<std::size_t> order(helpers.size());
+	for(std::size_t i = 0; i < order.size(); ++i)order[i] = i;
+	shuffle(order.begin(), order.end(), randomGenerator);
+	order.resize(min(order.size(), std::size_t(indirectProbes)));
+
+	if(!order.empty())
+	{
+		gossipMutex.lock();
+		pendingProbes[targetName] = p;
+		gossipMutex.unlock();
+
+		for(std::size_t i : order)
+		{
+			Package request;
+			request<<p2pOperation::ping_request;
+			request<<targetName;
+			writeGossip(request);
+			askPackageAsync(helpers[i].getAddress(), request, nullptr, [](bool){});
+		}
+	}
+
+	//A late answer to the first ping counts as well
+	const bool acked = p->wait(start + period, false);
+
+	if(!order.empty())
+	{
+		gossipMutex.lock();
+		auto it = pendingProbes.find(targetName);
+		if(it != pendingProbes.end() && it->second == p)pendingProbes.erase(it);
+		gossipMutex.unlock();
+	}
+	if(acked)return;
+
+	//Nobody got an answer, so the member is suspected.
+	//It can refute this until the suspicion timeout
+	bool suspected = false;
+	unsigned long long memberIncarnation = 0;
+	memberMutex.lock();
+	auto state = memberStates.find(AddressKey(target));
+	if(state != memberStates.end() && state->second.status == MemberStatus::alive)
+	{
+		state->second.status = MemberStatus::suspect;
+		state->second.suspected = chrono::steady_clock::now();
+		memberIncarnation = state->second.incarnation;
+		suspected = true;
+	}
+	memberMutex.unlock();
+
+	if(suspected)addGossip(targetName, MemberStatus::suspect, memberIncarnation);
+}
+
+Package p2p::createPing(const Address &target)
+{
+	memberMutex.lock();
+	auto state = memberStates.find(AddressKey(target));
+	const bool supportsGossip = (state == memberStates.end() || state->second.gossip);
+	memberMutex.unlock();
+
+	if(supportsGossip)
+	{
+		Package message;
+		message<<p2pOperation::ping;
+		writeGossip(message);
+		return message;
+	}
+
+	//Older members only know the echo
+	Package::FormatScope scope(Package::Format::fixed);
+	Package message;
+	message<<p2pOperation::echo_message;
+	message<<startTime;
+	message<<supportedFormat();
+	return message;
+}
+
+void p2p::expireSuspects()
+{
+	const auto now = chrono::steady_clock::now();
+	const chrono::milliseconds timeout = suspicionTimeout();
+
+	list<pair<AddressKey,unsigned long long> > expired;
+	memberMutex.lock();
+	for(const auto &state : memberStates)
+	{
+		if(state.second.status == MemberStatus::suspect && now - state.second.suspected >= timeout)
+		{
+			expired.push_back(make_pair(state.first, state.second.incarnation));
+		}
+	}
+	memberMutex.unlock();
+
+	for(const auto &e : expired)
+	{
+		const string address = e.first.get().toString();
+		cout<<"Member "<<address<<" didn't refute the suspicion"<<endl;
+		offline(e.first.get());
+		addGossip(address, MemberStatus::dead, e.second);
+	}
+}
+
+chrono::milliseconds p2p::suspicionTimeout()
+{
+	const double count = double(getMembersCount());
+
+	//Larger networks need more time to
+	//spread the suspicion to the member
+	const double factor = max(1.0, ceil(log10(count + 1)));
+	return chrono::milliseconds((unsigned long long)(factor * suspicionMultiplier * protocolPeriod));
+}
+
+void p2p::addGossip(const string &address, MemberStatus status, unsigned long long memberIncarnation)
+{
+	gossipMutex.lock();
+	for(auto it = gossip.begin(); it != gossip.end(); ++it)
+	{
+		//The new change replaces the old one
+		if(it->address == address)
+		{
+			gossip.erase(it);
+			break;
+		}
+	}
+
+	gossip.push_front(GossipUpdate(address, status, memberIncarnation));
+	gossipMutex.unlock();
+}
+
+void p2p::writeGossip(Package &message)
+{
+	const double count = double(getMembersCount());
+	const unsigned int maxTransmissions = (unsigned int)(gossipRetransmitMultiplier * max(1.0, ceil(log10(count + 1))));
+
+	//The changes which were sent the least often are sent first
+	gossipMutex.lock();
+	gossip.sort([](const GossipUpdate &a, const GossipUpdate &b)
+	{
+		return a.transmissions < b.transmissions;
+	});
+
+	std::size_t written = 0;
+	for(auto it = gossip.begin(); it != gossip.end() && written < maxPiggybackedGossip; ++written)
+	{
+		message<<it->address;
+		message<<char(it->status);
+		message<<it->incarnation;
+
+		if(++it->transmissions >= maxTransmissions)it = gossip.erase(it);
+		else ++it;
+	}
+	gossipMutex.unlock();
+}
+
+void p2p::readGossip(const Address &ip, const Package &message)
+{
+	string address;
+	char status;
+	unsigned long long memberIncarnation;
+	while(message>>address && message>>status && message>>memberIncarnation)
+	{
+		if(address.empty())address = ip.toString();
+		Address *a = protocol.decodeAddress(address);
+		if(!a)continue;
+
+		//A suspicion of the current computer is refuted
+		//by gossiping a higher incarnation
+		if(isOwnAddress(*a))
+		{
+			delete a;
+			if(status == char(MemberStatus::alive))continue;
+
+			gossipMutex.lock();
+			incarnation = max(incarnation, memberIncarnation) + 1;
+			const unsigned long long ownIncarnation = incarnation;
+			gossipMutex.unlock();
+			addGossip("", MemberStatus::alive, ownIncarnation);
+			continue;
+		}
+
+		bool known = false;
+		bool changed = false;
+		memberMutex.lock();
+		auto state = memberStates.find(AddressKey(*a));
+		if(state != memberStates.end())
+		{
+			known = true;
+			MemberState &s = state->second;
+			switch(MemberStatus(status))
+			{
+			case MemberStatus::alive:
+				changed = (memberIncarnation > s.incarnation);
+				if(changed)s.status = MemberStatus::alive;
+				break;
+			case MemberStatus::suspect:
+				changed = (memberIncarnation > s.incarnation || (memberIncarnation == s.incarnation && s.status == MemberStatus::alive));
+				if(changed)
+				{
+					if(s.status != MemberStatus::suspect)s.suspected = chrono::steady_clock::now();
+					s.status = MemberStatus::suspect;
+				}
+				break;
+			case MemberStatus::dead:
+				changed = (memberIncarnation >= s.incarnation);
+				break;
+			}
+			if(changed)s.incarnation = memberIncarnation;
+		}
+		memberMutex.unlock();
+
+		if(changed)
+		{
+			if(status == char(MemberStatus::dead))offline(*a);
+			addGossip(address, MemberStatus(status), memberIncarnation);
+		}
+		else if(!known && status == char(MemberStatus::alive))
+		{
+			//The member is connected by the testAliveThread
+			gossipMutex.lock();
+			if(find(gossipedMembers.begin(), gossipedMembers.end(), address) == gossipedMembers.end())gossipedMembers.push_back(address);
+			gossipMutex.unlock();
+		}
+		delete a;
+	}
+}
+
+bool p2p::received(const Address &ip, const Package &message, Package &answer, Package &to_send)
 {
 	p2pOperation type;
 	if(!(message>>type))return false;
@@ -503,36 +1439,44 @@ bool p2p::received(const Address &ip, const Package &message, Package &/*answer*
 	case p2pOperation::echo_message:
 		if(!isMember(ip))
 		{
-			//Save client as memeber
+			//Save client as memeber. Older
+			//versions don't send their Format
 			unsigned long long otherTime;
+			char format = char(Package::Format::fixed);
+			char version = 0;
 			if(!(message>>otherTime))return false;
-			online(ip, otherTime);
+			message>>format;
+			message>>version;
+			online(ip, otherTime, format == char(Package::Format::compact), version >= gossipVersion, version >= batchVersion);
 		}
 		to_send<<p2pOperation::echo_response_message;
 		to_send<<startTime;
+		to_send<<supportedFormat();
+		to_send<<protocolVersion;
 		return true;
 	case p2pOperation::echo_response_message:
 		if(!isMember(ip))
 		{
 			//Save client as memeber
 			unsigned long long otherTime;
+			char format = char(Package::Format::fixed);
+			char version = 0;
 			if(!(message>>otherTime))return false;
-			online(ip, otherTime);
+			message>>format;
+			message>>version;
+			online(ip, otherTime, format == char(Package::Format::compact), version >= gossipVersion, version >= batchVersion);
 		}
 		return true;
 	case p2pOperation::other_peers:
 		//Send current memebers
 		to_send<<p2pOperation::other_peers_response;
-		memberMutex.lock();
-		for(auto it = members.cbegin(); it != members.cend(); it++)
+		for(const Client &client : getMembers()->clients)
 		{
-			if(it->getAddress() != ip)
+			if(client.getAddress() != ip)
 			{
-				const string &address = it->getAddress().address;
-				to_send<<address;
+				to_send<<client.getAddress().toString();
 			}
 		}
-		memberMutex.unlock();
 		return true;
 	case p2pOperation::other_peers_response: {
 		//Extract other peers from message
@@ -574,6 +1518,51 @@ bool p2p::received(const Address &ip, const Package &message, Package &/*answer*
 	case p2pOperation::went_offline:
 		offline(ip);
 		return true;
+	case p2pOperation::ping:
+		readGossip(ip, message);
+		answer<<p2pOperation::ping_ack;
+		writeGossip(answer);
+		return true;
+	case p2pOperation::ping_request: {
+		string target;
+		if(!(message>>target))return false;
+		readGossip(ip, message);
+
+		shared_ptr<Address> targetAddress(protocol.decodeAddress(target));
+		if(!targetAddress)return true;
+
+		//The member is pinged without waiting. If it
+		//answers, the sender of the request is told
+		shared_ptr<Address> sender(ip.clone());
+		shared_ptr<Package> ack(new Package());
+		askPackageAsync(*targetAddress, createPing(*targetAddress), ack.get(), [this,target,targetAddress,sender,ack](bool success)
+		{
+			if(!success)return;
+
+			p2pOperation t;
+			if((*ack)>>t && t == p2pOperation::ping_ack)readGossip(*targetAddress, *ack);
+
+			Package indirectAck;
+			indirectAck<<p2pOperation::indirect_ack;
+			indirectAck<<target;
+			writeGossip(indirectAck);
+			askPackageAsync(*sender, indirectAck, nullptr, [](bool){});
+		});
+		return true;
+	}
+	case p2pOperation::indirect_ack: {
+		string target;
+		if(!(message>>target))return false;
+		readGossip(ip, message);
+
+		gossipMutex.lock();
+		auto it = pendingProbes.find(target);
+		shared_ptr<Probe> probe = (it != pendingProbes.end()) ? it->second : nullptr;
+		gossipMutex.unlock();
+
+		if(probe)probe->answered(true);
+		return true;
+	}
 	default:
 		return false;
 	}
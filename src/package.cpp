@@ -0,0 +1,138 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/package.hpp>
+#include <new>
+
+using namespace std;
+using namespace cluster;
+
+thread_local Package::Format Package::threadFormat = Package::Format::fixed;
+
+/**
+  * The smallest block of the pool
+  * has 2^minimumClass bytes
+ **/
+static const unsigned int minimumClass = 8;
+
+/**
+  * The amount of block sizes in the pool.
+  * The biggest block has 64 KiB
+ **/
+static const unsigned int classes = 9;
+
+/**
+  * The maximum amount of free blocks
+  * which are kept for every size
+ **/
+static const std::size_t maximumFreeBlocks = 16;
+
+/**
+  * The free blocks of one thread
+ **/
+struct Pool
+{
+	/**
+	  * Default constructor.
+	 **/
+	Pool() :
+		blocks()
+	{}
+
+	/**
+	  * Default destructor. Frees all blocks
+	 **/
+	~Pool();
+
+	/**
+	  * The free blocks of every size
+	 **/
+	vector<void*> blocks[classes];
+
+};
+
+/**
+  * A flag whether the pool of the current thread was
+  * already destroyed, e.g. when global Packages are
+  * destroyed after the thread local objects
+ **/
+static thread_local bool poolDestroyed = false;
+
+Pool::~Pool()
+{
+	poolDestroyed = true;
+	for(auto &free : blocks)
+	{
+		for(void *block : free)::operator delete(block);
+	}
+}
+
+/**
+  * Returns the pool of the current thread
+ **/
+static Pool& pool()
+{
+	static thread_local Pool p;
+	return p;
+}
+
+/**
+  * Returns the size class of a block with at least
+  * the given size or classes if it is too big
+ **/
+static unsigned int sizeClass(std::size_t size)
+{
+	unsigned int c = 0;
+	while(c < classes && (std::size_t(1) << (minimumClass + c)) < size)++c;
+	return c;
+}
+
+Package::Buffer* Package::Buffer::create(std::size_t capacity, std::size_t position)
+{
+	std::size_t size = sizeof(Buffer) + capacity;
+	void *block = nullptr;
+
+	const unsigned int c = sizeClass(size);
+	if(c < classes)
+	{
+		size = std::size_t(1) << (minimumClass + c);
+		if(!poolDestroyed)
+		{
+			vector<void*> &free = pool().blocks[c];
+			if(!free.empty())
+			{
+				block = free.back();
+				free.pop_back();
+			}
+		}
+	}
+
+	if(!block)block = ::operator new(size);
+	return new(block) Buffer(size - sizeof(Buffer), position);
+}
+
+void Package::Buffer::destroy(Buffer *buffer)
+{
+	const std::size_t size = sizeof(Buffer) + buffer->capacity;
+	buffer->~Buffer();
+
+	//Only blocks which were taken from
+	//a pool have the size of a class
+	const unsigned int c = sizeClass(size);
+	if(c < classes && size == (std::size_t(1) << (minimumClass + c)) && !poolDestroyed)
+	{
+		vector<void*> &free = pool().blocks[c];
+		if(free.size() < maximumFreeBlocks)
+		{
+			free.push_back(buffer);
+			return;
+		}
+	}
+
+	::operator delete(buffer);
+}
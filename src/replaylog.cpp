@@ -0,0 +1,128 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/replaylog.hpp>
+#include <cluster/digest.hpp>
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The amount of slots which are
+  * allocated for the first Package
+ **/
+static const std::size_t initialSlots = 16;
+
+ReplayLog::ReplayLog(std::size_t ui_maxPackages, std::size_t ui_maxBytes) :
+	slots(),
+	digests(),
+	first(0),
+	count(0),
+	base(0),
+	bytes(0),
+	maxPackages(ui_maxPackages),
+	maxBytes(ui_maxBytes)
+{}
+
+void ReplayLog::add(unsigned long long id, const Package &p)
+{
+	add(id, p, Digest::compute(p));
+}
+
+void ReplayLog::add(unsigned long long id, const Package &p, uint32_t digest)
+{
+	if(!empty() && id != base + count)clear();
+	if(empty())
+	{
+		first = 0;
+		base = id;
+	}
+
+	if(count == slots.size())grow();
+
+	const std::size_t slot = (first + count) % slots.size();
+	slots[slot] = p;
+	digests[slot] = digest;
+	bytes += p.getLength();
+	++count;
+
+	shrink();
+}
+
+const Package* ReplayLog::find(unsigned long long id) const
+{
+	if(id < base || id - base >= count)return nullptr;
+	return &slots[(first + std::size_t(id - base)) % slots.size()];
+}
+
+bool ReplayLog::findDigest(unsigned long long id, uint32_t &out) const
+{
+	if(id < base || id - base >= count)return false;
+	out = digests[(first + std::size_t(id - base)) % slots.size()];
+	return true;
+}
+
+void ReplayLog::clear()
+{
+	while(!empty())removeFirst();
+	first = 0;
+	base = 0;
+}
+
+void ReplayLog::setLimits(std::size_t ui_maxPackages, std::size_t ui_maxBytes)
+{
+	maxPackages = ui_maxPackages;
+	maxBytes = ui_maxBytes;
+	shrink();
+}
+
+void ReplayLog::removeFirst()
+{
+	//The slot releases its content but
+	//stays allocated for the next Package
+	bytes -= slots[first].getLength();
+	slots[first] = Package();
+	first = (first + 1) % slots.size();
+	++base;
+	--count;
+}
+
+void ReplayLog::shrink()
+{
+	while(count > 1 && (count > maxPackages || bytes > maxBytes))removeFirst();
+}
+
+void ReplayLog::grow()
+{
+	//The oldest Package makes room if the
+	//ring buffer reached its maximum size
+	if(count > 0 && count >= maxPackages)
+	{
+		removeFirst();
+		return;
+	}
+
+	std::size_t size = max(slots.size() * 2, initialSlots);
+	if(maxPackages > 0)size = max(min(size, maxPackages), std::size_t(1));
+
+	//The Packages are moved so that
+	//the oldest one is in the first slot
+	vector<Package> resized(size);
+	vector<uint32_t> resizedDigests(size);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const std::size_t slot = (first + i) % slots.size();
+		resized[i] = std::move(slots[slot]);
+		resizedDigests[i] = digests[slot];
+	}
+	slots.swap(resized);
+	digests.swap(resizedDigests);
+	first = 0;
+}
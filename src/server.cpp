@@ -7,33 +7,238 @@
  **/
 
 #include <cluster/prototypes/protocol.hpp>
+#include <cluster/prototypes/address.hpp>
 #include <cluster/server.hpp>
 #include <cluster/package.hpp>
 #include <cluster/prototypes/listenersocket.hpp>
 #include <cluster/prototypes/communicationsocket.hpp>
+#include <cluster/eventloop.hpp>
+#include <cluster/channel.hpp>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <iostream>
+#include <unordered_map>
 #include <unistd.h>
 
 using namespace std;
 using namespace cluster;
 
-Server::Server(const Protocol &p_protocol) :
+/**
+  * A connection which became a Channel while the
+  * Server doesn't use EventLoops. Its frames are
+  * read by its own thread.
+ **/
+struct Server::ChannelConnection
+{
+	ChannelConnection(CommunicationSocket *s) :
+		socket(s),
+		sendMutex(),
+		reader(nullptr),
+		pending(0),
+		finished(false),
+		compression(false)
+	{}
+
+	~ChannelConnection()
+	{
+		delete socket;
+	}
+
+	ChannelConnection(const ChannelConnection &c) = delete;
+	ChannelConnection& operator=(const ChannelConnection &c) = delete;
+
+	CommunicationSocket *socket;
+	mutex sendMutex;
+	thread *reader;
+	atomic<unsigned int> pending;
+	atomic<bool> finished;
+	atomic<bool> compression;
+};
+
+/**
+  * A connection which was accepted, a frame which was
+  * received over a Channel or a Package which was
+  * received by an EventLoop
+ **/
+struct Server::Request
+{
+	Request() :
+		socket(nullptr),
+		channel(),
+#ifdef __linux__
+		event(),
+#endif //__linux__
+		data(),
+		queued(chrono::steady_clock::now())
+	{}
+
+	Request(const Request &r) = default;
+	Request& operator=(const Request &r) = default;
+
+	CommunicationSocket *socket;
+	shared_ptr<ChannelConnection> channel;
+#ifdef __linux__
+	shared_ptr<EventConnection> event;
+#endif //__linux__
+	Package data;
+	chrono::steady_clock::time_point queued;
+};
+
+/**
+  * The bounded queue of the Requests. Control Requests
+  * are taken first. The other Requests are queued per
+  * peer and the peers take turns.
+ **/
+struct Server::RequestQueue
+{
+	RequestQueue() :
+		control(),
+		peers(),
+		turns(),
+		size(0),
+		maxQueued(defaultMaxQueued),
+		maxQueuedPerPeer(defaultMaxQueuedPerPeer),
+		statistics()
+	{}
+
+	RequestQueue(const RequestQueue &q) = delete;
+	RequestQueue& operator=(const RequestQueue &q) = delete;
+
+	/**
+	  * Adds the given Request of the given peer.
+	  * Returns false if the queue is full
+	 **/
+	bool push(const Address &from, const Request &request, bool isControl)
+	{
+		if(isControl)
+		{
+			if(size >= maxQueued + controlReserve)return reject();
+			control.push_back(request);
+		}
+		else
+		{
+			if(size >= maxQueued)return reject();
+
+			auto it = peers.find(AddressKey(from));
+			if(it == peers.end())it = peers.insert(make_pair(AddressKey(from), deque<Request>())).first;
+			else if(it->second.size() >= maxQueuedPerPeer)return reject();
+
+			//The peer waits for its turn
+			if(it->second.empty())turns.push_back(&it->first);
+			it->second.push_back(request);
+		}
+
+		++size;
+		++statistics.accepted;
+		if(size > statistics.maxQueued)statistics.maxQueued = size;
+		return true;
+	}
+
+	/**
+	  * Takes the next Request. Returns false
+	  * if nothing is waiting
+	 **/
+	bool pop(Request &out)
+	{
+		if(!control.empty())
+		{
+			out = control.front();
+			control.pop_front();
+		}
+		else if(!turns.empty())
+		{
+			const AddressKey *peer = turns.front();
+			turns.pop_front();
+
+			auto it = peers.find(*peer);
+			out = it->second.front();
+			it->second.pop_front();
+
+			//The peer gets another turn after the others
+			//or is removed if nothing of it is waiting
+			if(!it->second.empty())turns.push_back(peer);
+			else peers.erase(it);
+		}
+		else return false;
+
+		--size;
+		++statistics.handled;
+		const unsigned long long wait = (unsigned long long)chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - out.queued).count();
+		statistics.totalWait += wait;
+		if(wait > statistics.maxWait)statistics.maxWait = wait;
+		return true;
+	}
+
+	/**
+	  * Counts a rejected Request and returns false
+	 **/
+	bool reject()
+	{
+		++statistics.rejected;
+		return false;
+	}
+
+	deque<Request> control;
+	unordered_map<AddressKey,deque<Request> > peers;
+	deque<const AddressKey*> turns;
+	std::size_t size;
+	std::size_t maxQueued;
+	std::size_t maxQueuedPerPeer;
+	ServerStatistics statistics;
+};
+
+Server::Server(const Protocol &p_protocol, unsigned int ui_idleTimeout, unsigned int ui_eventLoopsCount) :
+	idleTimeout(ui_idleTimeout),
+	maxFrameSize(p_protocol.getMaxFrameSize()),
 	running(true),
 	socket(nullptr),
 	protocol(&p_protocol),
 	callback(nullptr),
-	t(),
+	channelCallback(nullptr),
+	priorityCallback(nullptr),
+	t(nullptr),
 	answerThread(),
-	requests(),
+	requests(new RequestQueue()),
+	channels(),
+#ifdef __linux__
+	eventLoops(),
+	nextEventLoop(0),
+#endif //__linux__
 	m(),
-	cv(),
-	cm()
+	cv()
 {
 	//Open listener connection
 	openConnection();
 
+#ifdef __linux__
+	//Let the EventLoops handle the connections if
+	//the ListenerSocket supports it
+	if(ui_eventLoopsCount > 0 && socket->getDescriptor() != -1)
+	{
+		for(unsigned int i = 0; i < ui_eventLoopsCount; i++)
+		{
+			eventLoops.push_back(new EventLoop([this](const shared_ptr<EventConnection> &connection, const Package &data)
+			{
+				dispatch(connection, data);
+			}, idleTimeout));
+		}
+
+		//The first EventLoop accepts the connections and
+		//distributes them to all EventLoops
+		eventLoops[0]->setListener(socket, [this](CommunicationSocket *client)
+		{
+			client->setMaxFrameSize(maxFrameSize);
+			eventLoops[nextEventLoop]->add(client);
+			nextEventLoop = (nextEventLoop + 1) % (unsigned int)eventLoops.size();
+		});
+	}
+#else
+	(void)ui_eventLoopsCount;
+#endif //__linux__
+
 	//Start thread that polls and accepts connection
-	t = new thread(&Server::serverFunction, this);
+	if(!usesEventLoops())t = new thread(&Server::serverFunction, this);
 
 	//Start the threads which handle the connections
 	for(unsigned int i = 0; i < handlersCount; i++)
@@ -50,19 +255,33 @@ void Server::openConnection()
 Server::~Server()
 {
 	running = false;
-	t->join();
-	delete t;
+	if(t)
+	{
+		t->join();
+		delete t;
+	}
+#ifdef __linux__
+	for(EventLoop *loop : eventLoops)
+	{
+		delete loop;
+	}
+	eventLoops.clear();
+#endif //__linux__
+	m.lock();
 	cv.notify_all();
+	m.unlock();
 	for(unsigned int i = 0; i < handlersCount; i++)
 	{
 		answerThread[i]->join();
 		delete answerThread[i];
 	}
-	while(requests.size())
+	joinChannelReaders(true);
+	Request request;
+	while(requests->pop(request))
 	{
-		delete requests.front();
-		requests.pop();
+		delete request.socket;
 	}
+	delete requests;
 	closeConnection();
 }
 
@@ -75,18 +294,21 @@ void Server::serverFunction()
 {
 	while(running)
 	{
+		//Clean up the threads of closed Channels
+		joinChannelReaders(false);
+
 		if(!socket->poll(2000))continue;
 
 		//Accept connections from client
 		if(CommunicationSocket *client = socket->listen())
 		{
-			m.lock();
-			requests.push(client);
-			m.unlock();
+			client->setMaxFrameSize(maxFrameSize);
 
-			//Notify threads that there is something to do
-			unique_lock<mutex> lock(cm);
-			cv.notify_one();
+			//The connection is closed at once if the
+			//queue is full
+			Request request;
+			request.socket = client;
+			if(!enqueue(client->getAddress(), request, false))delete client;
 		}
 		else
 		{
@@ -104,32 +326,287 @@ void Server::serverFunction()
 	}
 }
 
+void Server::setQueueLimits(std::size_t maxQueued, std::size_t maxQueuedPerPeer)
+{
+	m.lock();
+	requests->maxQueued = maxQueued;
+	requests->maxQueuedPerPeer = maxQueuedPerPeer;
+	m.unlock();
+}
+
+ServerStatistics Server::getStatistics() const
+{
+	m.lock();
+	ServerStatistics statistics = requests->statistics;
+	statistics.queued = requests->size;
+	m.unlock();
+	return statistics;
+}
+
+bool Server::isControl(const Package &data, bool channel) const
+{
+	//The read position of data must not change
+	Package copy(data);
+	if(!channel)return Channel::isHello(copy) || (priorityCallback && priorityCallback(copy));
+
+	ChannelFrame type;
+	uint64_t id;
+	bool compressed;
+	Package::Format format;
+	if(!Channel::decodeHeader(copy, type, id, compressed, format))return false;
+	if(type == ChannelFrame::options)return true;
+
+	//Control Packages are small, so compressed
+	//frames don't need to be decompressed
+	if(compressed || !priorityCallback)return false;
+
+	Package content;
+	copy.resetIterator();
+	return Channel::decode(copy, type, id, content) && priorityCallback(content);
+}
+
+bool Server::enqueue(const Address &from, const Request &request, bool control)
+{
+	m.lock();
+	const bool accepted = requests->push(from, request, control);
+	m.unlock();
+
+	//Notify threads that there is something to do
+	if(accepted)cv.notify_one();
+	return accepted;
+}
+
+Package Server::busyFrame(const Package &frame)
+{
+	//Only requests expect an answer
+	const Package copy(frame);
+	ChannelFrame type;
+	uint64_t id;
+	bool compressed;
+	Package::Format format;
+	if(!Channel::decodeHeader(copy, type, id, compressed, format) || type != ChannelFrame::request)return Package();
+
+	return Channel::encode(ChannelFrame::busy, id, Package());
+}
+
 void Server::handle()
 {
+	unique_lock<mutex> lock(m);
 	while(running)
 	{
-		m.lock();
-		if(requests.empty())
+		Request request;
+		if(!requests->pop(request))
 		{
-			m.unlock();
-			unique_lock<mutex> lock(cm);
 			cv.wait(lock);
 			continue;
 		}
-		CommunicationSocket *client = requests.front();
-		requests.pop();
-		m.unlock();
+		lock.unlock();
+
+		if(request.socket)handleConnection(request.socket);
+		else if(request.channel)handleChannelConnectionFrame(request.channel, request.data);
+#ifdef __linux__
+		else if(request.event)handleEvent(request.event, request.data);
+#endif //__linux__
+
+		lock.lock();
+	}
+}
+
+void Server::handleConnection(CommunicationSocket *client)
+{
+	//Serve requests until the client closes the connection or
+	//it is idle for too long. It is not closed earlier because
+	//the ConnectionPool of the client could reuse it meanwhile
+	//and the request would be lost
+	unsigned int idle = 0;
+	while(running)
+	{
+		if(!client->poll(idlePollInterval))
+		{
+			idle += idlePollInterval;
+			if(idle >= idleTimeout * 1000)break;
+			continue;
+		}
+		idle = 0;
 
 		//read data from client
 		Package p;
 		Package answer;
-		client->receive(&p);
-//cout<<client->getAddress().address<<": "<<p.toString()<<endl;
+		if(!client->receive(&p))break;
+//cout<<client->getAddress().toString()<<": "<<p.toString()<<endl;
+
+		//The connection becomes a Channel
+		//which is read by its own thread
+		if(Channel::isHello(p))
+		{
+			if(!client->send(Channel::helloAnswer()))break;
+
+			shared_ptr<ChannelConnection> connection(new ChannelConnection(client));
+			m.lock();
+			channels.push_back(connection);
+			connection->reader = new thread(&Server::readChannel, this, connection);
+			m.unlock();
+			return;
+		}
 
 		//Call callback and get answer
 		if(callback)callback(client->getAddress(), p, answer);
 
-		client->send(answer);
-		delete client;
+		if(!client->send(answer))break;
 	}
+	delete client;
+}
+
+void Server::readChannel(shared_ptr<ChannelConnection> connection)
+{
+	//The Channel is closed if it is idle for too long
+	//and none of its requests is being handled
+	unsigned int idle = 0;
+	while(running)
+	{
+		if(!connection->socket->poll(idlePollInterval))
+		{
+			idle += idlePollInterval;
+			if(idle >= idleTimeout * 1000 && connection->pending == 0)break;
+			continue;
+		}
+		idle = 0;
+
+		Package frame;
+		if(!connection->socket->receive(&frame))break;
+
+		++connection->pending;
+		Request request;
+		request.channel = connection;
+		request.data = frame;
+		if(!enqueue(connection->socket->getAddress(), request, isControl(frame, true)))
+		{
+			//The queue is full
+			const Package busy = busyFrame(frame);
+			connection->sendMutex.lock();
+			if(!busy.empty())connection->socket->send(busy);
+			connection->sendMutex.unlock();
+			--connection->pending;
+		}
+	}
+
+	connection->finished = true;
+}
+
+void Server::handleChannelConnectionFrame(const shared_ptr<ChannelConnection> &connection, const Package &frame)
+{
+	//Packages of a Channel are answered in any order
+	Package answer;
+	Package toSend;
+	handleChannelFrame(connection->socket->getAddress(), frame, connection->compression, answer, toSend);
+
+	connection->sendMutex.lock();
+	if(!toSend.empty())connection->socket->send(toSend);
+	if(!answer.empty())connection->socket->send(answer);
+	connection->sendMutex.unlock();
+
+	--connection->pending;
+}
+
+void Server::joinChannelReaders(bool all)
+{
+	list<shared_ptr<ChannelConnection> > closed;
+
+	m.lock();
+	for(auto it = channels.begin(); it != channels.end(); )
+	{
+		if(all || (*it)->finished)
+		{
+			closed.push_back(*it);
+			it = channels.erase(it);
+		}
+		else ++it;
+	}
+	m.unlock();
+
+	for(const shared_ptr<ChannelConnection> &connection : closed)
+	{
+		connection->reader->join();
+		delete connection->reader;
+		connection->reader = nullptr;
+	}
+}
+
+void Server::handleChannelFrame(const Address &from, const Package &frame, atomic<bool> &compression, Package &answer, Package &send)
+{
+	ChannelFrame type;
+	uint64_t id;
+	Package data;
+	if(!Channel::decode(frame, type, id, data))return;
+
+	//Answers are not expected by a Server
+	if(type == ChannelFrame::answer)return;
+
+	//The other side offers its options which
+	//are answered with the supported ones
+	if(type == ChannelFrame::options)
+	{
+		if(!Channel::supportsCompression(data))return;
+		compression = true;
+		answer = Channel::encode(ChannelFrame::options, 0, Channel::compressionOptions());
+		return;
+	}
+
+	//Without channelCallback the Packages of a
+	//Channel are handled like all other Packages
+	Package content;
+	Package toSend;
+	if(channelCallback)channelCallback(from, data, content, toSend);
+	else if(callback)callback(from, data, content);
+
+	if(type == ChannelFrame::request)answer = Channel::encode(ChannelFrame::answer, id, content, compression);
+	if(!toSend.empty())send = Channel::encode(ChannelFrame::message, 0, toSend, compression);
+}
+
+#ifdef __linux__
+void Server::dispatch(const shared_ptr<EventConnection> &connection, const Package &data)
+{
+	Request request;
+	request.event = connection;
+	request.data = data;
+	if(enqueue(connection->getAddress(), request, isControl(data, connection->isChannel())))return;
+
+	//The queue is full
+	if(!connection->isChannel())connection->send(Channel::busyAnswer());
+	else
+	{
+		const Package busy = busyFrame(data);
+		if(!busy.empty())connection->send(busy);
+	}
+	connection->finished();
+}
+
+void Server::handleEvent(const shared_ptr<EventConnection> &connection, const Package &data)
+{
+	Package answer;
+
+	if(connection->isChannel())
+	{
+		//Packages of a Channel are answered in any order
+		Package toSend;
+		handleChannelFrame(connection->getAddress(), data, connection->compression, answer, toSend);
+		if(!toSend.empty())connection->send(toSend);
+		if(!answer.empty())connection->send(answer);
+	}
+	else if(Channel::isHello(data))
+	{
+		//The connection becomes a Channel
+		connection->setChannel();
+		connection->send(Channel::helloAnswer());
+	}
+	else
+	{
+		//Call callback and get answer
+		if(callback)callback(connection->getAddress(), data, answer);
+
+		connection->send(answer);
+	}
+
+	connection->finished();
 }
+#endif //__linux__
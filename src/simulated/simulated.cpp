@@ -0,0 +1,68 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/simulated/simulated.hpp>
+
+using namespace std;
+using namespace cluster;
+
+Simulated::Simulated(SimulatedNetwork &n, const string &str_name, unsigned int ui_timeout, unsigned int ui_listenBacklog) :
+	Protocol(),
+	network(n),
+	name(str_name),
+	timeout(ui_timeout),
+	listenBacklog(ui_listenBacklog)
+{}
+
+ListenerSocket* Simulated::createListenerSocket() const
+{
+	try {
+		return new SimulatedListenerSocket(network, name, listenBacklog);
+	}catch(const ListenerException &e) {}
+
+	return nullptr;
+}
+
+CommunicationSocket* Simulated::createCommunicationSocket(const Address &address) const
+{
+	return network.connect(name, address.toString(), timeout);
+}
+
+void Simulated::getAddresses(std::list<Address*> &out) const
+{
+	if(Address *a = decodeAddress(name))
+	{
+		out.push_back(a);
+	}
+}
+
+Address* Simulated::decodeAddress(const std::string &address) const
+{
+	try {
+		return new SimulatedAddress(address);
+	} catch(const AddressException &e) {}
+
+	return nullptr;
+}
+
+bool Simulated::discoverAddresses(std::list<Address*> &out) const
+{
+	list<string> names;
+	network.getNames(names);
+
+	for(const string &member : names)
+	{
+		if(member == name)continue;
+		if(Address *a = decodeAddress(member))
+		{
+			out.push_back(a);
+		}
+	}
+
+	return true;
+}
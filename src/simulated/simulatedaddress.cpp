@@ -0,0 +1,62 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/simulated/simulatedaddress.hpp>
+#include <functional>
+#include <typeinfo>
+#include <ctype.h>
+
+using namespace std;
+using namespace cluster;
+
+SimulatedAddress::SimulatedAddress(const string &str_name) :
+	Address(),
+	name(str_name)
+{
+	if(str_name.empty())throw AddressException("The name of a member must not be empty");
+}
+
+Address* SimulatedAddress::clone() const
+{
+	return new SimulatedAddress(*this);
+}
+
+void SimulatedAddress::increase()
+{
+	//Increase the number at the end from right to left
+	std::size_t position = name.length();
+	while(position > 0 && isdigit(name[position-1]))
+	{
+		--position;
+		if(name[position] < '9')
+		{
+			++name[position];
+			return;
+		}
+		name[position] = '0';
+	}
+
+	//All digits were 9 or there was no number
+	name.insert(position, "1");
+}
+
+bool SimulatedAddress::isLoopback() const
+{
+	return false;
+}
+
+bool SimulatedAddress::operator==(const Address &a) const
+{
+	if(typeid(a) != typeid(*this))return false;
+	return name == static_cast<const SimulatedAddress&>(a).name;
+}
+
+std::size_t SimulatedAddress::hash() const
+{
+	return std::hash<string>()(name);
+}
@@ -0,0 +1,44 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/simulated/simulatedcommunicationsocket.hpp>
+#include <cluster/simulated/simulatedaddress.hpp>
+#include <cluster/simulated/simulatednetwork.hpp>
+
+using namespace std;
+using namespace cluster;
+
+SimulatedCommunicationSocket::SimulatedCommunicationSocket(const SimulatedAddress &memberAddress, shared_ptr<SimulatedPipe> p_in, shared_ptr<SimulatedPipe> p_out, unsigned int ui_timeout) :
+	CommunicationSocket(memberAddress),
+	in(p_in),
+	out(p_out),
+	timeout(ui_timeout)
+{}
+
+SimulatedCommunicationSocket::~SimulatedCommunicationSocket()
+{
+	//The other member can still receive
+	//what was sent before
+	in->close();
+	out->close();
+}
+
+bool SimulatedCommunicationSocket::send(const Package &message)
+{
+	return out->send(message);
+}
+
+bool SimulatedCommunicationSocket::receive(Package *data)
+{
+	return in->receive(data, timeout);
+}
+
+bool SimulatedCommunicationSocket::poll(unsigned int time)
+{
+	return in->poll(time);
+}
@@ -0,0 +1,65 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/simulated/simulatedlistenersocket.hpp>
+#include <cluster/simulated/simulatednetwork.hpp>
+#include <cluster/prototypes/communicationsocket.hpp>
+#include <chrono>
+
+using namespace std;
+using namespace cluster;
+
+SimulatedListenerSocket::SimulatedListenerSocket(SimulatedNetwork &n, const string &str_name, unsigned int ui_listenBacklog) :
+	ListenerSocket(),
+	network(n),
+	name(str_name),
+	listenBacklog(ui_listenBacklog),
+	waiting(),
+	m(),
+	cv()
+{
+	if(!network.addListener(name, this))throw ListenerException("Member name is already in use: "+name);
+}
+
+SimulatedListenerSocket::~SimulatedListenerSocket()
+{
+	network.removeListener(name);
+
+	while(!waiting.empty())
+	{
+		delete waiting.front();
+		waiting.pop();
+	}
+}
+
+bool SimulatedListenerSocket::poll(unsigned int time)
+{
+	unique_lock<mutex> lock(m);
+	return cv.wait_for(lock, chrono::milliseconds(time), [this]{ return !waiting.empty(); });
+}
+
+CommunicationSocket* SimulatedListenerSocket::listen()
+{
+	unique_lock<mutex> lock(m);
+	cv.wait(lock, [this]{ return !waiting.empty(); });
+
+	CommunicationSocket *socket = waiting.front();
+	waiting.pop();
+	return socket;
+}
+
+bool SimulatedListenerSocket::connected(CommunicationSocket *socket)
+{
+	m.lock();
+	const bool accepted = (waiting.size() < listenBacklog);
+	if(accepted)waiting.push(socket);
+	m.unlock();
+	cv.notify_one();
+
+	return accepted;
+}
@@ -0,0 +1,216 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/simulated/simulatednetwork.hpp>
+#include <cluster/simulated/simulatedaddress.hpp>
+#include <cluster/simulated/simulatedcommunicationsocket.hpp>
+#include <cluster/simulated/simulatedlistenersocket.hpp>
+#include <memory>
+
+using namespace std;
+using namespace cluster;
+
+SimulatedPipe::SimulatedPipe(SimulatedNetwork &n, const string &str_from, const string &str_to) :
+	network(n),
+	from(str_from),
+	to(str_to),
+	packages(),
+	nextFree(Clock::now()),
+	closed(false),
+	m(),
+	cv()
+{}
+
+bool SimulatedPipe::send(const Package &data)
+{
+	SimulatedLink link;
+	const bool arrives = network.transmit(from, to, link);
+
+	//Sending 0 byte packages is illegal,
+	//so they are sent as '\0' like by the Framing
+	Package toSend(data);
+	if(toSend.empty())toSend<<'\0';
+
+	m.lock();
+	if(closed)
+	{
+		m.unlock();
+		return false;
+	}
+
+	//The link transmits one Package after the other
+	Clock::time_point start = max(Clock::now(), nextFree);
+	if(link.bandwidth > 0)start += chrono::microseconds(toSend.getLength() * 1000000 / link.bandwidth);
+	nextFree = start;
+
+	if(arrives)
+	{
+		//The Packages arrive in the order they were sent
+		//even if the latency was changed in the meantime
+		Clock::time_point arrival = start + chrono::microseconds(link.latency);
+		if(!packages.empty() && arrival < packages.back().first)arrival = packages.back().first;
+		packages.push(make_pair(arrival, toSend));
+	}
+	m.unlock();
+	cv.notify_all();
+
+	return true;
+}
+
+bool SimulatedPipe::receive(Package *out, unsigned int timeout)
+{
+	unique_lock<mutex> lock(m);
+	if(!wait(lock, Clock::now() + chrono::seconds(timeout)))return false;
+
+	//The pipe was closed
+	if(packages.empty())return false;
+
+	if(out && out->empty())*out = packages.front().second;
+	else if(out)out->write(packages.front().second.getData(), packages.front().second.getLength());
+	packages.pop();
+
+	return true;
+}
+
+bool SimulatedPipe::poll(unsigned int time)
+{
+	unique_lock<mutex> lock(m);
+	return wait(lock, Clock::now() + chrono::milliseconds(time));
+}
+
+void SimulatedPipe::close()
+{
+	m.lock();
+	closed = true;
+	m.unlock();
+	cv.notify_all();
+}
+
+bool SimulatedPipe::wait(unique_lock<mutex> &lock, Clock::time_point deadline)
+{
+	while(true)
+	{
+		const Clock::time_point now = Clock::now();
+		if(!packages.empty() && packages.front().first <= now)return true;
+		if(closed && packages.empty())return true;
+		if(now >= deadline)return false;
+
+		//Wake up when the next Package arrives
+		Clock::time_point until = deadline;
+		if(!packages.empty() && packages.front().first < until)until = packages.front().first;
+		cv.wait_until(lock, until);
+	}
+}
+
+/******************************************************/
+
+SimulatedNetwork::SimulatedNetwork(uint32_t seed) :
+	m(),
+	defaultLink(),
+	links(),
+	partitions(),
+	listeners(),
+	random(seed)
+{}
+
+void SimulatedNetwork::setDefaultLink(const SimulatedLink &link)
+{
+	m.lock();
+	defaultLink = link;
+	m.unlock();
+}
+
+void SimulatedNetwork::setLink(const string &from, const string &to, const SimulatedLink &link)
+{
+	m.lock();
+	links[make_pair(from, to)] = link;
+	m.unlock();
+}
+
+void SimulatedNetwork::setPartition(const string &name, unsigned int partition)
+{
+	m.lock();
+	if(partition == 0)partitions.erase(name);
+	else partitions[name] = partition;
+	m.unlock();
+}
+
+void SimulatedNetwork::heal()
+{
+	m.lock();
+	partitions.clear();
+	m.unlock();
+}
+
+bool SimulatedNetwork::addListener(const string &name, SimulatedListenerSocket *listener)
+{
+	m.lock();
+	const bool success = listeners.insert(make_pair(name, listener)).second;
+	m.unlock();
+	return success;
+}
+
+void SimulatedNetwork::removeListener(const string &name)
+{
+	m.lock();
+	listeners.erase(name);
+	m.unlock();
+}
+
+SimulatedCommunicationSocket* SimulatedNetwork::connect(const string &from, const string &to, unsigned int timeout)
+{
+	shared_ptr<SimulatedPipe> request(new SimulatedPipe(*this, from, to));
+	shared_ptr<SimulatedPipe> response(new SimulatedPipe(*this, to, from));
+
+	//The ListenerSocket is used while m is locked
+	//so that it can't be removed in the meantime
+	lock_guard<mutex> lock(m);
+	auto it = listeners.find(to);
+	if(it == listeners.end() || !isReachable(from, to))return nullptr;
+
+	SimulatedCommunicationSocket *server = new SimulatedCommunicationSocket(SimulatedAddress(from), request, response, timeout);
+	if(!it->second->connected(server))
+	{
+		delete server;
+		return nullptr;
+	}
+
+	return new SimulatedCommunicationSocket(SimulatedAddress(to), response, request, timeout);
+}
+
+void SimulatedNetwork::getNames(list<string> &out) const
+{
+	m.lock();
+	for(auto it = listeners.cbegin(); it != listeners.cend(); ++it)
+	{
+		out.push_back(it->first);
+	}
+	m.unlock();
+}
+
+bool SimulatedNetwork::transmit(const string &from, const string &to, SimulatedLink &link)
+{
+	lock_guard<mutex> lock(m);
+
+	auto it = links.find(make_pair(from, to));
+	link = (it == links.end()) ? defaultLink : it->second;
+
+	if(!isReachable(from, to))return false;
+	if(link.dropRate > 0 && uniform_real_distribution<double>(0, 1)(random) < link.dropRate)return false;
+
+	return true;
+}
+
+bool SimulatedNetwork::isReachable(const string &from, const string &to) const
+{
+	auto a = partitions.find(from);
+	auto b = partitions.find(to);
+	const unsigned int partitionFrom = (a == partitions.end()) ? 0 : a->second;
+	const unsigned int partitionTo = (b == partitions.end()) ? 0 : b->second;
+	return partitionFrom == partitionTo;
+}
@@ -0,0 +1,101 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifdef __linux__
+
+#include <cluster/unixdomain/unixdomain.hpp>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace cluster;
+
+UnixDomain::UnixDomain(const string &str_directory, const string &str_name, unsigned int ui_timeout, unsigned int ui_listenBacklog) :
+	Protocol(),
+	directory(str_directory),
+	name(str_name),
+	timeout(ui_timeout),
+	listenBacklog(ui_listenBacklog)
+{}
+
+ListenerSocket* UnixDomain::createListenerSocket() const
+{
+	try {
+		return new UnixDomainListenerSocket(directory, name, timeout, listenBacklog);
+	}catch(const ListenerException &e) {}
+
+	return nullptr;
+}
+
+CommunicationSocket* UnixDomain::createCommunicationSocket(const Address &address) const
+{
+	CommunicationSocket *socket = nullptr;
+
+	//Other Addresses need to be decoded
+	const UnixDomainAddress *a = dynamic_cast<const UnixDomainAddress*>(&address);
+	const UnixDomainAddress *decoded = a ? nullptr : static_cast<UnixDomainAddress*>(decodeAddress(address.toString()));
+	if(!a && !decoded)throw AddressException("Wrong UnixDomain Address");
+
+	try {
+		socket = new UnixDomainCommunicationSocket(a ? *a : *decoded, directory, name, timeout);
+		socket->setMaxFrameSize(getMaxFrameSize());
+	}catch(const CommunicationException &e) {}
+
+	delete decoded;
+	return socket;
+}
+
+void UnixDomain::getAddresses(std::list<Address*> &out) const
+{
+	if(Address *a = decodeAddress(name))
+	{
+		out.push_back(a);
+	}
+}
+
+Address* UnixDomain::decodeAddress(const std::string &address) const
+{
+	try {
+		return new UnixDomainAddress(address);
+	} catch(const AddressException &e) {}
+
+	return nullptr;
+}
+
+bool UnixDomain::discoverAddresses(std::list<Address*> &out) const
+{
+	DIR *dir = opendir(directory.c_str());
+	if(!dir)return true;
+
+	//Every socket file belongs to a member
+	while(struct dirent *entry = readdir(dir))
+	{
+		const string file = entry->d_name;
+		if(file == name)continue;
+
+		bool isSocket = (entry->d_type == DT_SOCK);
+		if(entry->d_type == DT_UNKNOWN)
+		{
+			struct stat s;
+			isSocket = (stat((directory + "/" + file).c_str(), &s) == 0 && S_ISSOCK(s.st_mode));
+		}
+
+		if(isSocket)
+		{
+			if(Address *a = decodeAddress(file))
+			{
+				out.push_back(a);
+			}
+		}
+	}
+	closedir(dir);
+
+	return true;
+}
+
+#endif //__linux__
@@ -0,0 +1,68 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/unixdomain/unixdomainaddress.hpp>
+#include <functional>
+#include <typeinfo>
+#include <ctype.h>
+
+using namespace std;
+using namespace cluster;
+
+UnixDomainAddress::UnixDomainAddress(const string &str_name) :
+	Address(),
+	name(str_name)
+{
+	if(!isValid(str_name))throw AddressException("Invalid member name: "+str_name);
+}
+
+bool UnixDomainAddress::isValid(const std::string &name)
+{
+	if(name.empty() || name[0] == '.')return false;
+	return name.find('/') == string::npos && name.find('\0') == string::npos;
+}
+
+Address* UnixDomainAddress::clone() const
+{
+	return new UnixDomainAddress(*this);
+}
+
+void UnixDomainAddress::increase()
+{
+	//Increase the number at the end from right to left
+	std::size_t position = name.length();
+	while(position > 0 && isdigit(name[position-1]))
+	{
+		--position;
+		if(name[position] < '9')
+		{
+			++name[position];
+			return;
+		}
+		name[position] = '0';
+	}
+
+	//All digits were 9 or there was no number
+	name.insert(position, "1");
+}
+
+bool UnixDomainAddress::isLoopback() const
+{
+	return false;
+}
+
+bool UnixDomainAddress::operator==(const Address &a) const
+{
+	if(typeid(a) != typeid(*this))return false;
+	return name == static_cast<const UnixDomainAddress&>(a).name;
+}
+
+std::size_t UnixDomainAddress::hash() const
+{
+	return std::hash<string>()(name);
+}
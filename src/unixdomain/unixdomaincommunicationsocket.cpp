@@ -0,0 +1,146 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifdef __linux__
+
+#include <cluster/unixdomain/unixdomaincommunicationsocket.hpp>
+#include <cluster/unixdomain/unixdomainaddress.hpp>
+#include <cluster/package.hpp>
+#include <cluster/framing.hpp>
+#include <atomic>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+
+using namespace std;
+using namespace cluster;
+
+const char UnixDomainCommunicationSocket::clientPrefix[] = "cluster-member/";
+
+UnixDomainCommunicationSocket::UnixDomainCommunicationSocket(const UnixDomainAddress &memberAddress, int client, unsigned int timeout) :
+	CommunicationSocket(memberAddress),
+	fd_client(client),
+	counter(new int(1))
+{
+	Framing::setOptions(fd_client, timeout, false);
+}
+
+UnixDomainCommunicationSocket::UnixDomainCommunicationSocket(const UnixDomainAddress &memberAddress, const string &directory, const string &ownName, unsigned int timeout) :
+	CommunicationSocket(memberAddress),
+	fd_client(),
+	counter(nullptr)
+{
+	//The abstract name contains the process id and a
+	//counter so that every connection gets its own name
+	static atomic<unsigned int> connectionCounter(0);
+	const string clientName = string(clientPrefix) + ownName + "/" + to_string(getpid()) + "/" + to_string(connectionCounter++);
+
+	struct sockaddr_un clientAddr;
+	struct sockaddr_un serverAddr;
+	const string path = directory + "/" + memberAddress.toString();
+	if(clientName.length() + 1 > sizeof(clientAddr.sun_path))throw CommunicationException("Member name too long: "+ownName);
+	if(path.length() + 1 > sizeof(serverAddr.sun_path))throw CommunicationException("Socket path too long: "+path);
+
+	//Open socket
+	fd_client = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(fd_client == -1)
+		throw CommunicationException(string("Unable to create socket: ")+strerror(errno));
+
+	//Bind to the abstract name which starts with '\0'
+	memset(&clientAddr, 0, sizeof(clientAddr));
+	clientAddr.sun_family = AF_UNIX;
+	memcpy(clientAddr.sun_path + 1, clientName.c_str(), clientName.length());
+	const socklen_t clientSize = socklen_t(offsetof(struct sockaddr_un, sun_path) + 1 + clientName.length());
+	if(bind(fd_client, reinterpret_cast<const sockaddr*>(&clientAddr), clientSize) != 0)
+	{
+		close(fd_client);
+		throw CommunicationException(string("Unable to bind socket: ")+strerror(errno));
+	}
+
+	//Connect socket
+	memset(&serverAddr, 0, sizeof(serverAddr));
+	serverAddr.sun_family = AF_UNIX;
+	memcpy(serverAddr.sun_path, path.c_str(), path.length());
+	if(connect(fd_client, reinterpret_cast<const sockaddr*>(&serverAddr), sizeof(serverAddr)) != 0)
+	{
+		close(fd_client);
+		throw CommunicationException(string("Unable to connect to client: ")+strerror(errno));
+	}
+
+	Framing::setOptions(fd_client, timeout, false);
+
+	counter = new int(1);
+}
+
+UnixDomainCommunicationSocket::UnixDomainCommunicationSocket(const UnixDomainCommunicationSocket &c) :
+	CommunicationSocket(c),
+	fd_client(c.fd_client),
+	counter(c.counter)
+{
+	//Increase reference counter
+	(*counter)++;
+}
+
+UnixDomainCommunicationSocket& UnixDomainCommunicationSocket::operator=(const UnixDomainCommunicationSocket &c)
+{
+	if(this == &c)return (*this);
+
+	CommunicationSocket::operator=(c);
+	release();
+	fd_client = c.fd_client;
+	counter = c.counter;
+
+	//Increase reference counter
+	(*counter)++;
+
+	return (*this);
+}
+
+UnixDomainCommunicationSocket::~UnixDomainCommunicationSocket()
+{
+	release();
+}
+
+void UnixDomainCommunicationSocket::release()
+{
+	//Decrease reference counter
+	(*counter)--;
+
+	//If this class is the last one that connects
+	//to the socket, close ist
+	if((*counter) == 0)
+	{
+		shutdown(fd_client, SHUT_RDWR);
+		close(fd_client);
+		delete counter;
+	}
+}
+
+bool UnixDomainCommunicationSocket::send(const Package &message)
+{
+	return Framing::send(fd_client, message);
+}
+
+bool UnixDomainCommunicationSocket::receive(Package *out)
+{
+	return Framing::receive(fd_client, out, maxFrameSize);
+}
+
+bool UnixDomainCommunicationSocket::poll(unsigned int time)
+{
+	struct pollfd fd;
+	fd.fd = fd_client;
+	fd.events = POLLIN;
+	return ::poll(&fd, 1, int(time)) > 0;
+}
+
+#endif //__linux__
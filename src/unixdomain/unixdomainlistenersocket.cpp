@@ -0,0 +1,137 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifdef __linux__
+
+#include <cluster/unixdomain/unixdomainlistenersocket.hpp>
+#include <cluster/unixdomain/unixdomaincommunicationsocket.hpp>
+#include <cluster/unixdomain/unixdomainaddress.hpp>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+
+using namespace std;
+using namespace cluster;
+
+UnixDomainListenerSocket::UnixDomainListenerSocket(const string &directory, const string &name, unsigned int ui_timeout, unsigned int listenBacklog) :
+	ListenerSocket(),
+	path(directory + "/" + name),
+	fd_socket(),
+	timeout(ui_timeout)
+{
+	struct sockaddr_un addr;
+	if(!UnixDomainAddress::isValid(name))throw ListenerException("Invalid member name: "+name);
+	if(path.length() + 1 > sizeof(addr.sun_path))throw ListenerException("Socket path too long: "+path);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	memcpy(addr.sun_path, path.c_str(), path.length());
+
+	//The directory is only accessible by the current user
+	if(mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST)
+		throw ListenerException(string("Unable to create directory ")+directory+": "+strerror(errno));
+
+	//A socket file which nobody listens on
+	//is left over from a crashed member
+	int fd_probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(fd_probe != -1)
+	{
+		const bool inUse = (connect(fd_probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0);
+		const bool leftOver = (!inUse && errno == ECONNREFUSED);
+		close(fd_probe);
+		if(inUse)throw ListenerException("Member name is already in use: "+name);
+		if(leftOver)unlink(path.c_str());
+	}
+
+	//Open socket
+	fd_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(fd_socket == -1)
+		throw ListenerException(string("Unable to create socket: ")+strerror(errno));
+
+	//Bind socket
+	if(bind(fd_socket, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+	{
+		close(fd_socket);
+		throw ListenerException(string("Unable to bind server socket: ")+strerror(errno));
+	}
+
+	//Open listener
+	if(::listen(fd_socket, int(listenBacklog)) != 0)
+	{
+		close(fd_socket);
+		unlink(path.c_str());
+		throw ListenerException(string("Unable to listen on server socket: ")+strerror(errno));
+	}
+}
+
+UnixDomainListenerSocket::~UnixDomainListenerSocket()
+{
+	close(fd_socket);
+	unlink(path.c_str());
+}
+
+bool UnixDomainListenerSocket::poll(unsigned int time)
+{
+	struct pollfd fd;
+	fd.fd = fd_socket;
+	fd.events = POLLIN;
+	return ::poll(&fd, 1, int(time)) > 0;
+}
+
+CommunicationSocket* UnixDomainListenerSocket::listen()
+{
+	struct sockaddr_un clientAddr;
+	socklen_t size = sizeof(clientAddr);
+	int fd_client = accept4(fd_socket, reinterpret_cast<struct sockaddr*>(&clientAddr), &size, SOCK_CLOEXEC);
+	if(fd_client == -1)return nullptr;
+
+	return accepted(fd_client, &clientAddr, size);
+}
+
+CommunicationSocket* UnixDomainListenerSocket::listenNonBlocking()
+{
+	struct sockaddr_un clientAddr;
+	socklen_t size = sizeof(clientAddr);
+	int fd_client = accept4(fd_socket, reinterpret_cast<struct sockaddr*>(&clientAddr), &size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if(fd_client == -1)return nullptr;
+
+	return accepted(fd_client, &clientAddr, size);
+}
+
+CommunicationSocket* UnixDomainListenerSocket::accepted(int fd_client, const void *clientAddr, unsigned int size)
+{
+	//The abstract name is clientPrefix, the member name,
+	//the process id and a counter separated by '/'
+	const struct sockaddr_un *addr = static_cast<const struct sockaddr_un*>(clientAddr);
+	const std::size_t prefixLength = strlen(UnixDomainCommunicationSocket::clientPrefix);
+	const std::size_t nameOffset = offsetof(struct sockaddr_un, sun_path) + 1;
+	if(size > nameOffset && addr->sun_path[0] == '\0')
+	{
+		const string clientName(addr->sun_path + 1, size - nameOffset);
+		const std::size_t end = clientName.find('/', prefixLength);
+		if(clientName.compare(0, prefixLength, UnixDomainCommunicationSocket::clientPrefix) == 0 && end != string::npos)
+		{
+			const string name = clientName.substr(prefixLength, end - prefixLength);
+			if(UnixDomainAddress::isValid(name))
+			{
+				return new UnixDomainCommunicationSocket(UnixDomainAddress(name), fd_client, timeout);
+			}
+		}
+	}
+
+	//Connections of unknown members are refused
+	close(fd_client);
+	return nullptr;
+}
+
+#endif //__linux__
@@ -0,0 +1,231 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include <cluster/writeaheadlog.hpp>
+#include <cluster/digest.hpp>
+#include <cstdio>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#include <fcntl.h>
+#endif //__linux__
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The size of the header of a record:
+  * the id, the Digest, the Format
+  * and the length of the Package
+ **/
+static const std::size_t recordHeaderSize = sizeof(uint64_t) + sizeof(uint32_t) + sizeof(char) + sizeof(uint64_t);
+
+/**
+  * Writes the given Package with its
+  * id and Digest as one record
+ **/
+static void writeRecord(ostream &out, unsigned long long id, const Package &p, uint32_t digest)
+{
+	//The headers always use the fixed Format
+	Package header;
+	header.setFormat(Package::Format::fixed);
+	header<<uint64_t(id);
+	header<<digest;
+	header<<static_cast<char>(p.getFormat());
+	header<<uint64_t(p.getLength());
+
+	out.write(header.getData(), header.getLength());
+	out.write(p.getData(), p.getLength());
+}
+
+/**
+  * Reads the next record. Returns false if the
+  * record is incomplete or its Digest is wrong
+ **/
+static bool readRecord(istream &in, unsigned long long &id, Package &p)
+{
+	char buffer[recordHeaderSize];
+	if(!in.read(buffer, sizeof(buffer)))return false;
+
+	Package header(buffer, sizeof(buffer));
+	header.setFormat(Package::Format::fixed);
+	uint64_t recordId;
+	uint32_t digest;
+	char format;
+	uint64_t length;
+	if(!(header>>recordId) || !(header>>digest) || !(header>>format) || !(header>>length))return false;
+	if(format != static_cast<char>(Package::Format::fixed) && format != static_cast<char>(Package::Format::compact))return false;
+
+	//The length of a record which was only
+	//written partly may be anything
+	const streampos start = in.tellg();
+	in.seekg(0, ios_base::end);
+	const streampos end = in.tellg();
+	in.seekg(start);
+	if(start < 0 || end < start || length > uint64_t(end - start))return false;
+
+	p.setFormat(static_cast<Package::Format>(format));
+	if(!in.read(p.extend((std::size_t)length), (streamsize)length))return false;
+	if(Digest::compute(p) != digest)return false;
+
+	id = recordId;
+	return true;
+}
+
+/**
+  * Writes the data of the given file to the disk.
+  * Returns false if it can't be synced
+ **/
+static bool syncFile(const string &fileName)
+{
+#ifdef __linux__
+	const int fd = ::open(fileName.c_str(), O_RDONLY);
+	if(fd == -1)return false;
+	const bool success = (fsync(fd) == 0);
+	::close(fd);
+#else
+	const int fd = _open(fileName.c_str(), _O_RDWR);
+	if(fd == -1)return false;
+	const bool success = (_commit(fd) == 0);
+	_close(fd);
+#endif //__linux__
+	return success;
+}
+
+/**
+  * Writes the directory entries of the directory
+  * which contains the given file to the disk,
+  * so that a renamed file keeps its new name
+ **/
+static bool syncDirectory(const string &fileName)
+{
+#ifdef __linux__
+	const string::size_type slash = fileName.rfind('/');
+	const string directory = (slash == string::npos) ? "." : (slash == 0 ? "/" : fileName.substr(0, slash));
+	const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+	if(fd == -1)return false;
+	const bool success = (fsync(fd) == 0);
+	::close(fd);
+	return success;
+#else
+	//Windows writes the directory entries on its own
+	(void)fileName;
+	return true;
+#endif //__linux__
+}
+
+/**
+  * Returns the first record of a log which belongs
+  * to the snapshot with the given Digest
+ **/
+static Package startRecord(uint32_t snapshotDigest)
+{
+	Package start;
+	start.setFormat(Package::Format::fixed);
+	start<<snapshotDigest;
+	return start;
+}
+
+WriteAheadLog::WriteAheadLog(const string &str_fileName) :
+	fileName(str_fileName),
+	snapshotFileName(str_fileName + ".snapshot"),
+	log(),
+	appended(0),
+	unsynced(false)
+{}
+
+WriteAheadLog::~WriteAheadLog()
+{
+	log.close();
+}
+
+bool WriteAheadLog::load(unsigned long long &snapshotId, Package &snapshot, vector<pair<unsigned long long,Package> > &packages) const
+{
+	packages.clear();
+
+	ifstream snapshotFile(snapshotFileName, ios_base::binary);
+	if(!snapshotFile || !readRecord(snapshotFile, snapshotId, snapshot))return false;
+
+	//The log belongs to the snapshot if it starts with
+	//its id and Digest. Otherwise the process stopped
+	//after the snapshot was replaced but before the log
+	//was started again, and the snapshot contains all
+	//Packages of the log
+	ifstream logFile(fileName, ios_base::binary);
+	unsigned long long startId;
+	Package start;
+	if(!readRecord(logFile, startId, start) || startId != snapshotId || start != startRecord(Digest::compute(snapshot)))return true;
+
+	//Reading stops at the first record which
+	//is incomplete or doesn't follow
+	while(logFile)
+	{
+		unsigned long long id;
+		Package p;
+		if(!readRecord(logFile, id, p))break;
+		if(id != snapshotId + packages.size())break;
+		packages.push_back(make_pair(id, p));
+	}
+
+	return true;
+}
+
+bool WriteAheadLog::writeSnapshot(unsigned long long nextId, const Package &snapshot)
+{
+	const uint32_t digest = Digest::compute(snapshot);
+	const string tempFileName = snapshotFileName + ".tmp";
+	ofstream snapshotFile(tempFileName, ios_base::binary | ios_base::trunc);
+	writeRecord(snapshotFile, nextId, snapshot, digest);
+	snapshotFile.close();
+	if(!snapshotFile || !syncFile(tempFileName))return false;
+
+	//The snapshot is replaced before the log is started
+	//again. If the process stops in between, the old log
+	//doesn't belong to the new snapshot and is ignored
+#ifndef __linux__
+	//rename doesn't replace existing files on Windows
+	remove(snapshotFileName.c_str());
+#endif //__linux__
+	if(rename(tempFileName.c_str(), snapshotFileName.c_str()) != 0 || !syncDirectory(snapshotFileName))return false;
+
+	log.close();
+	log.clear();
+	log.open(fileName, ios_base::binary | ios_base::trunc);
+	writeRecord(log, nextId, startRecord(digest), Digest::compute(startRecord(digest)));
+	log.flush();
+	if(!log || !syncFile(fileName))return false;
+	appended = 0;
+	unsynced = false;
+
+	return true;
+}
+
+bool WriteAheadLog::append(unsigned long long id, const Package &p, uint32_t digest)
+{
+	if(!log.is_open())return false;
+
+	writeRecord(log, id, p, digest);
+	log.flush();
+	if(!log)return false;
+
+	++appended;
+	unsynced = true;
+	return true;
+}
+
+bool WriteAheadLog::sync()
+{
+	if(!unsynced)return true;
+	if(!log.is_open() || !syncFile(fileName))return false;
+
+	unsynced = false;
+	return true;
+}
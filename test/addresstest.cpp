@@ -0,0 +1,110 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include "test.hpp"
+#include <cluster/ipv4/ipv4address.hpp>
+#include <cluster/ipv6/ipv6address.hpp>
+#include <cluster/simulated/simulatedaddress.hpp>
+#include <string>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#else
+#include <winsock2.h>
+#endif //__linux__
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The binary Addresses convert to and from
+  * strings and keep their socket address
+ **/
+static void testAddresses()
+{
+	IPv4Address a("10.0.0.254");
+	CHECK(a.toString() == "10.0.0.254");
+	CHECK(a.getSocketAddress().sin_addr.s_addr == inet_addr("10.0.0.254"));
+	CHECK(!a.isLoopback());
+	CHECK(IPv4Address("127.0.0.1").isLoopback());
+
+	//Increasing skips the broadcast and network
+	//Addresses and carries into the next byte
+	a.increase();
+	CHECK(a.toString() == "10.0.1.1");
+	CHECK(a == IPv4Address("10.0.1.1"));
+	CHECK(a.getSocketAddress().sin_addr.s_addr == inet_addr("10.0.1.1"));
+
+	const uint8_t bytes[4] = {10, 0, 1, 1};
+	CHECK(IPv4Address(bytes) == a);
+	CHECK(IPv4Address(bytes).hash() == a.hash());
+
+	IPv6Address b("fe80::1");
+	CHECK(b == IPv6Address("fe80:0:0:0:0:0:0:1"));
+	CHECK(b.hash() == IPv6Address("fe80:0:0:0:0:0:0:1").hash());
+	CHECK(IPv6Address("::1").isLoopback());
+	CHECK(IPv6Address(b.toString()) == b);
+
+	//Addresses of different Protocols are never equal
+	CHECK(!(IPv4Address("10.0.0.1") == SimulatedAddress("10.0.0.1")));
+	CHECK(SimulatedAddress("node1") == SimulatedAddress("node1"));
+	CHECK(SimulatedAddress("node1") != SimulatedAddress("node2"));
+}
+
+/**
+  * AddressKeys find equal Addresses in hash maps
+  * and their copies own a copy of the Address
+ **/
+static void testAddressKey()
+{
+	unordered_map<AddressKey, int> map;
+	for(int i = 0; i < 100; ++i)
+	{
+		//The Address is destroyed after it was inserted
+		const IPv4Address address("10.0.0." + to_string(i));
+		map[AddressKey(address)] = i;
+	}
+	map[AddressKey(SimulatedAddress("10.0.0.1"))] = 1000;
+	CHECK(map.size() == 101);
+
+	//Looking up doesn't need the same Address object
+	for(int i = 0; i < 100; ++i)
+	{
+		const IPv4Address address("10.0.0." + to_string(i));
+		auto it = map.find(AddressKey(address));
+		CHECK(it != map.end() && it->second == i);
+		CHECK(it != map.end() && it->first.get() == address);
+		CHECK(it != map.end() && &it->first.get() != &address);
+	}
+	CHECK(map[AddressKey(SimulatedAddress("10.0.0.1"))] == 1000);
+	CHECK(map.find(AddressKey(IPv4Address("10.0.1.0"))) == map.end());
+
+	//Copies and assignments own their Address
+	IPv6Address *address = new IPv6Address("fe80::1");
+	AddressKey *key = new AddressKey(*address);
+	AddressKey copy(*key);
+	delete key;
+	delete address;
+	{
+		const IPv6Address other("fe80::2");
+		AddressKey assigned(other);
+		assigned = copy;
+		copy = assigned;
+	}
+	CHECK(copy.get() == IPv6Address("fe80::1"));
+	CHECK(copy == AddressKey(IPv6Address("fe80::1")));
+	CHECK(hash<AddressKey>()(copy) == IPv6Address("fe80::1").hash());
+}
+
+int main()
+{
+	testAddresses();
+	testAddressKey();
+	return testResult("addresstest");
+}
@@ -0,0 +1,140 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include "test.hpp"
+#include <cluster/channel.hpp>
+#include <cluster/client.hpp>
+#include <cluster/connectionpool.hpp>
+#include <cluster/server.hpp>
+#include <cluster/simulated/simulated.hpp>
+#include <cluster/simulated/simulatedaddress.hpp>
+#include <atomic>
+#include <future>
+#include <vector>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The frames keep their type,
+  * id and content
+ **/
+static void testFrames()
+{
+	Package content;
+	content<<string("content");
+	content<<42;
+
+	ChannelFrame type;
+	uint64_t id;
+	Package decoded;
+	CHECK(Channel::decode(Channel::encode(ChannelFrame::request, 123456789, content), type, id, decoded));
+	CHECK(type == ChannelFrame::request);
+	CHECK(id == 123456789);
+	string s;
+	int i = 0;
+	CHECK(decoded>>s && s == "content");
+	CHECK(decoded>>i && i == 42);
+
+	//The answer of a busy member has no content
+	CHECK(Channel::decode(Channel::encode(ChannelFrame::busy, 7, Package()), type, id, decoded));
+	CHECK(type == ChannelFrame::busy && id == 7);
+
+	//The Format of the content is sent with the frame
+	Package compact;
+	compact.setFormat(Package::Format::compact);
+	compact<<string("compact");
+	CHECK(Channel::decode(Channel::encode(ChannelFrame::message, 1, compact), type, id, decoded));
+	CHECK(type == ChannelFrame::message);
+	CHECK(decoded.getFormat() == Package::Format::compact);
+	CHECK(decoded>>s && s == "compact");
+
+	//The busy answer of plain connections is no
+	//answer which could be sent by a callback
+	Package plain;
+	plain<<string("plain");
+	CHECK(Channel::isBusy(Channel::busyAnswer()));
+	CHECK(!Channel::isBusy(plain));
+	CHECK(!Channel::isHello(plain));
+}
+
+/**
+  * Many requests are sent over one Channel at once.
+  * The answers arrive in another order than the
+  * requests and every one reaches its sender
+ **/
+static void testMultiplexing()
+{
+	SimulatedNetwork network(1);
+	network.setDefaultLink(SimulatedLink(200, 0, 0));
+	Simulated serverProtocol(network, "server");
+	Simulated clientProtocol(network, "client");
+
+	Server server(serverProtocol);
+	server.setChannelCallback([](const Address&, const Package &data, Package &answer, Package&)
+	{
+		int value = 0;
+		data>>value;
+
+		//Later requests are answered earlier
+		this_thread::sleep_for(chrono::milliseconds(50 - value));
+		answer<<(value * 2);
+	});
+
+	ConnectionPool pool(clientProtocol);
+	pool.setMultiplexing(true);
+	Client client(SimulatedAddress("server"), clientProtocol, &pool);
+
+	const int count = 40;
+	vector<Package> answers((std::size_t)count);
+	vector<promise<bool> > sent((std::size_t)count);
+	for(int i = 0; i < count; ++i)
+	{
+		Package request;
+		request<<i;
+		promise<bool> &p = sent[(std::size_t)i];
+		client.sendAsync(request, &answers[(std::size_t)i], [&p](bool success) { p.set_value(success); });
+	}
+
+	for(int i = 0; i < count; ++i)
+	{
+		CHECK(sent[(std::size_t)i].get_future().get());
+		int value = -1;
+		CHECK(answers[(std::size_t)i]>>value && value == i * 2);
+	}
+
+	//The requests were sent over a Channel which stays open
+	bool reused = false;
+	bool connected = false;
+	CHECK(pool.getChannel(SimulatedAddress("server"), reused, connected) != nullptr);
+	CHECK(reused && connected);
+
+	//The synchronous requests use the same Channel
+	atomic<int> correct(0);
+	vector<thread> threads;
+	for(int i = 0; i < count; ++i)
+	{
+		threads.emplace_back([&client,&correct,i]()
+		{
+			Package request;
+			request<<i;
+			Package answer;
+			int value = -1;
+			if(client.send(request, &answer) && answer>>value && value == i * 2)++correct;
+		});
+	}
+	for(thread &t : threads)t.join();
+	CHECK(correct == count);
+}
+
+int main()
+{
+	testFrames();
+	testMultiplexing();
+	return testResult("channeltest");
+}
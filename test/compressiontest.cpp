@@ -0,0 +1,171 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include "test.hpp"
+#include <cluster/channel.hpp>
+#include <cluster/client.hpp>
+#include <cluster/compression.hpp>
+#include <cluster/connectionpool.hpp>
+#include <cluster/server.hpp>
+#include <cluster/simulated/simulated.hpp>
+#include <cluster/simulated/simulatedaddress.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * Compresses and decompresses the given data.
+  * Returns whether the data could be compressed
+ **/
+static bool roundTrip(const vector<char> &data)
+{
+	vector<char> compressed;
+	if(!Compression::compress(data.data(), data.size(), compressed))return false;
+	CHECK(compressed.size() < data.size());
+
+	vector<char> decompressed(data.size());
+	CHECK(Compression::decompress(compressed.data(), compressed.size(), data.size(), decompressed.data()));
+	CHECK(decompressed == data);
+	return true;
+}
+
+/**
+  * The LZ codec restores every input which it compressed
+  * and refuses input which it can't decompress
+ **/
+static void testCodec()
+{
+	mt19937 random(5);
+
+	//Repeated text is compressed
+	string text;
+	for(int i = 0; i < 2000; ++i)text += "insert into test (id, name) values (" + to_string(i % 100) + ", 'row');";
+	CHECK(roundTrip(vector<char>(text.begin(), text.end())));
+
+	//Short and long matches, overlapping copies
+	for(std::size_t length : {16, 100, 4096, 70000})
+	{
+		vector<char> runs(length, 'a');
+		CHECK(roundTrip(runs));
+
+		vector<char> periodic(length);
+		for(std::size_t i = 0; i < length; ++i)periodic[i] = (i >= 7 && random() % 10) ? periodic[i - 7] : char(random());
+		roundTrip(periodic);
+	}
+
+	//Random data can't be compressed
+	vector<char> noise(10000);
+	for(char &c : noise)c = char(random());
+	CHECK(!roundTrip(noise));
+
+	//Truncated and corrupted data is refused or stays in bounds
+	vector<char> data(text.begin(), text.end());
+	vector<char> compressed;
+	CHECK(Compression::compress(data.data(), data.size(), compressed));
+	vector<char> out(data.size());
+	CHECK(!Compression::decompress(compressed.data(), compressed.size() / 2, data.size(), out.data()));
+	CHECK(!Compression::decompress(compressed.data(), compressed.size(), data.size() - 1, out.data()));
+	for(int i = 0; i < 1000; ++i)
+	{
+		vector<char> corrupted(compressed);
+		corrupted[random() % corrupted.size()] ^= char(1 + random() % 255);
+		Compression::decompress(corrupted.data(), corrupted.size(), data.size(), out.data());
+	}
+}
+
+/**
+  * Compressed Channel frames keep their content
+ **/
+static void testFrames()
+{
+	Package content;
+	content<<string(100000, 'x');
+
+	const Package plain = Channel::encode(ChannelFrame::request, 1, content, false);
+	const Package compressed = Channel::encode(ChannelFrame::request, 1, content, true);
+	CHECK(compressed.getLength() < plain.getLength() / 10);
+
+	ChannelFrame type;
+	uint64_t id;
+	Package decoded;
+	CHECK(Channel::decode(compressed, type, id, decoded));
+	CHECK(type == ChannelFrame::request && id == 1);
+	string s;
+	CHECK(decoded>>s && s == string(100000, 'x'));
+
+	//Small Packages are not worth it
+	Package small;
+	small<<string("small");
+	CHECK(Channel::encode(ChannelFrame::request, 1, small, true).getLength() == Channel::encode(ChannelFrame::request, 1, small, false).getLength());
+}
+
+/**
+  * Sends a big Package over a slow link and returns
+  * the time in milliseconds until it was answered
+ **/
+static long long sendBig(SimulatedNetwork &network, const string &name, bool compression)
+{
+	Simulated protocol(network, name);
+	ConnectionPool pool(protocol);
+	pool.setMultiplexing(true);
+	pool.setCompression(compression);
+	Client client(SimulatedAddress("server"), protocol, &pool);
+
+	//The compression is agreed on when
+	//the Channel is established
+	Package first;
+	first<<string("first");
+	CHECK(client.send(first, nullptr));
+
+	string text;
+	while(text.size() < 1000000)text += "row " + to_string(text.size() % 1000) + " of the table;";
+	Package request;
+	request<<text;
+
+	const auto start = chrono::steady_clock::now();
+	Package answer;
+	CHECK(client.send(request, &answer));
+	const auto end = chrono::steady_clock::now();
+
+	uint64_t length = 0;
+	CHECK(answer>>length && length == text.size());
+	return chrono::duration_cast<chrono::milliseconds>(end - start).count();
+}
+
+/**
+  * Big Packages are only compressed if both sides
+  * of a Channel agreed on it
+ **/
+static void testNegotiation()
+{
+	//The link needs 2 seconds for 1 MB
+	SimulatedNetwork network(1);
+	network.setDefaultLink(SimulatedLink(200, 500000, 0));
+	Simulated serverProtocol(network, "server");
+
+	Server server(serverProtocol);
+	server.setChannelCallback([](const Address&, const Package &data, Package &answer, Package&)
+	{
+		string text;
+		if(data>>text)answer<<uint64_t(text.size());
+	});
+
+	CHECK(sendBig(network, "compressed", true) < 1000);
+	CHECK(sendBig(network, "uncompressed", false) >= 1500);
+}
+
+int main()
+{
+	testCodec();
+	testFrames();
+	testNegotiation();
+	return testResult("compressiontest");
+}
@@ -0,0 +1,106 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include "test.hpp"
+#include <cluster/digest.hpp>
+#include <cluster/package.hpp>
+#include <cluster/replaylog.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * The Digest is CRC32C and can be computed in parts
+ **/
+static void testCompute()
+{
+	const string check = "123456789";
+	CHECK(Digest::compute(check.data(), check.size()) == 0xE3069283);
+	CHECK(Digest::compute(check.data(), 0) == 0);
+
+	//Every length and alignment, split at every position
+	mt19937 random(23);
+	vector<char> data(300);
+	for(char &c : data)c = char(random());
+	for(std::size_t offset = 0; offset < 8; ++offset)
+	{
+		for(std::size_t length = 0; length + offset <= data.size(); length += 37)
+		{
+			const char *begin = data.data() + offset;
+			const uint32_t whole = Digest::compute(begin, length);
+			for(std::size_t split = 0; split <= length; ++split)
+			{
+				CHECK(Digest::compute(begin + split, length - split, Digest::compute(begin, split)) == whole);
+			}
+		}
+	}
+
+	//Changing one bit changes the Digest
+	vector<char> changed(data);
+	changed[150] ^= 1;
+	CHECK(Digest::compute(changed.data(), changed.size()) != Digest::compute(data.data(), data.size()));
+
+	//The Digest of a Package is the one of its content
+	Package p;
+	p<<string("content");
+	p<<12345;
+	CHECK(Digest::compute(p) == Digest::compute(p.getData(), p.getLength()));
+}
+
+/**
+  * Combined Digests depend on the order
+  * of the Packages
+ **/
+static void testCombine()
+{
+	const uint32_t a = Digest::compute("a", 1);
+	const uint32_t b = Digest::compute("b", 1);
+	CHECK(Digest::combine(Digest::combine(0, a), b) == Digest::combine(Digest::combine(0, a), b));
+	CHECK(Digest::combine(Digest::combine(0, a), b) != Digest::combine(Digest::combine(0, b), a));
+	CHECK(Digest::combine(Digest::combine(0, a), a) != Digest::combine(0, a));
+}
+
+/**
+  * The ReplayLog remembers the Digest of
+  * every Package as long as the Package
+ **/
+static void testReplayLog()
+{
+	ReplayLog log(3, 1000000);
+	vector<Package> packages(5);
+	for(int i = 0; i < 5; ++i)
+	{
+		packages[std::size_t(i)]<<i;
+		log.add((unsigned long long)i, packages[std::size_t(i)]);
+	}
+
+	uint32_t digest;
+	CHECK(!log.findDigest(1, digest));
+	for(unsigned long long i = 2; i < 5; ++i)
+	{
+		CHECK(log.findDigest(i, digest) && digest == Digest::compute(packages[std::size_t(i)]));
+	}
+
+	//A Digest which is known already is not computed again
+	Package p;
+	p<<5;
+	log.add(5, p, 42);
+	CHECK(log.findDigest(5, digest) && digest == 42);
+	CHECK(!log.findDigest(2, digest));
+}
+
+int main()
+{
+	testCompute();
+	testCombine();
+	testReplayLog();
+	return testResult("digesttest");
+}
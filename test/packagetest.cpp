@@ -0,0 +1,190 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include "test.hpp"
+#include <cluster/package.hpp>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * Returns the size of the given integer
+  * written in the compact Format
+ **/
+template <class T>
+static std::size_t compactSize(const T &t)
+{
+	Package p;
+	p.setFormat(Package::Format::compact);
+	p.writeInteger(t);
+	return p.getLength();
+}
+
+/**
+  * Both Formats read what they wrote
+ **/
+static void testFormats()
+{
+	for(Package::Format format : {Package::Format::fixed, Package::Format::compact})
+	{
+		Package::FormatScope scope(format);
+		Package p;
+		CHECK(p.getFormat() == format);
+
+		p<<string("id-123");
+		p<<vector<int>{1, 2, 3};
+		p<<list<string>{"a", "bb"};
+		p.writeInteger(int64_t(-1));
+		p.writeInteger(int16_t(-300));
+		p.writeInteger(uint32_t(4000000000u));
+		p.writeInteger(numeric_limits<int64_t>::min());
+		p.writeInteger(numeric_limits<uint64_t>::max());
+		p.prependInteger(uint64_t(300));
+
+		//Copies and nested Packages keep the Format
+		Package copy(p);
+		Package q;
+		q<<copy;
+		CHECK(q.getFormat() == format);
+
+		uint64_t id = 0;
+		string s;
+		vector<int> v;
+		list<string> l;
+		CHECK(q.readInteger(id) && id == 300);
+		CHECK(q>>s && s == "id-123");
+		CHECK(q>>v && v == vector<int>({1, 2, 3}));
+		CHECK(q>>l && l.back() == "bb");
+
+		int64_t a = 0;
+		int16_t b = 0;
+		uint32_t c = 0;
+		int64_t d = 0;
+		uint64_t e = 0;
+		CHECK(q.readInteger(a) && a == -1);
+		CHECK(q.readInteger(b) && b == -300);
+		CHECK(q.readInteger(c) && c == 4000000000u);
+		CHECK(q.readInteger(d) && d == numeric_limits<int64_t>::min());
+		CHECK(q.readInteger(e) && e == numeric_limits<uint64_t>::max());
+		CHECK(q.finished());
+
+		CHECK(p.subPackageFromCurrentPosition().getFormat() == format);
+	}
+
+	//New Packages are fixed outside of a FormatScope
+	CHECK(Package().getFormat() == Package::Format::fixed);
+}
+
+/**
+  * Small integers and lengths need only a few
+  * bytes in the compact Format
+ **/
+static void testVarints()
+{
+	CHECK(compactSize(uint64_t(0)) == 1);
+	CHECK(compactSize(uint64_t(127)) == 1);
+	CHECK(compactSize(uint64_t(128)) == 2);
+	CHECK(compactSize(uint64_t(16383)) == 2);
+	CHECK(compactSize(uint64_t(16384)) == 3);
+	CHECK(compactSize(numeric_limits<uint64_t>::max()) == 10);
+
+	//Small negative numbers are small as well
+	CHECK(compactSize(int64_t(-1)) == 1);
+	CHECK(compactSize(int64_t(-64)) == 1);
+	CHECK(compactSize(numeric_limits<int64_t>::min()) == 10);
+
+	Package fixed;
+	Package compact;
+	compact.setFormat(Package::Format::compact);
+	fixed<<string("abc");
+	compact<<string("abc");
+	CHECK(fixed.getLength() == 8 + 3);
+	CHECK(compact.getLength() == 1 + 3);
+
+	//An integer which doesn't fit is refused
+	Package tooBig;
+	tooBig.setFormat(Package::Format::compact);
+	tooBig.writeInteger(int64_t(70000));
+	int16_t small = 0;
+	CHECK(!tooBig.readInteger(small));
+
+	//A varint longer than 10 bytes is invalid
+	Package invalid;
+	invalid.setFormat(Package::Format::compact);
+	const char bytes[11] = {char(0xff), char(0xff), char(0xff), char(0xff), char(0xff), char(0xff), char(0xff), char(0xff), char(0xff), char(0xff), char(0xff)};
+	invalid.write(bytes, sizeof(bytes));
+	uint64_t value = 0;
+	CHECK(!invalid.readVarint(value));
+
+	//A truncated varint is invalid
+	Package truncated;
+	truncated.setFormat(Package::Format::compact);
+	truncated.write(bytes, 3);
+	CHECK(!truncated.readVarint(value));
+}
+
+/**
+  * A PackageSpan views the elements of a vector
+  * inside of the Package without copying them
+ **/
+static void testPackageSpan()
+{
+	for(Package::Format format : {Package::Format::fixed, Package::Format::compact})
+	{
+		Package::FormatScope scope(format);
+		vector<uint64_t> values;
+		for(uint64_t i = 0; i < 1000; ++i)values.push_back(i * 1000003);
+
+		//The content of a Package is not aligned
+		Package p;
+		p<<char('x');
+		p<<values;
+		p<<int(7);
+
+		char c = 0;
+		PackageSpan<uint64_t> span;
+		CHECK(p>>c && c == 'x');
+		CHECK(p>>span);
+		CHECK(span.size() == values.size() && !span.empty());
+		CHECK(span[0] == 0 && span[999] == 999 * uint64_t(1000003));
+		CHECK(span.toVector() == values);
+		int i = 0;
+		CHECK(p>>i && i == 7);
+
+		//The span points into the Package
+		CHECK(span.data() > p.getData() && span.data() < p.getData() + p.getLength());
+
+		//A span reads the vectors which are
+		//written element by element as well
+		vector<int> empty;
+		Package q;
+		q<<empty;
+		PackageSpan<int> emptySpan;
+		CHECK(q>>emptySpan && emptySpan.empty());
+
+		//A length which exceeds the Package is refused
+		Package truncated;
+		truncated.writeLength(100);
+		truncated<<int(1);
+		PackageSpan<int> invalid;
+		CHECK(!(truncated>>invalid));
+	}
+}
+
+int main()
+{
+	testFormats();
+	testVarints();
+	testPackageSpan();
+	return testResult("packagetest");
+}
@@ -0,0 +1,349 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include "test.hpp"
+#include <cluster/answerpackage.hpp>
+#include <cluster/clusterobjectserialized.hpp>
+#include <cluster/p2p.hpp>
+#include <cluster/simulated/simulated.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * A ClusterObjectSerialized which appends every
+  * value it performs to a list
+ **/
+struct Log : public ClusterObjectSerialized
+{
+	Log(ClusterObject *network) :
+		ClusterObjectSerialized(network, 1000),
+		m(),
+		values(),
+		rebuilds(0),
+		replayed(0),
+		batches(0),
+		dropFrom(0),
+		dropTo(0),
+		corrupt(false)
+	{}
+
+	Log(const Log &l) = delete;
+	Log& operator=(const Log &l) = delete;
+
+	virtual std::string getType() const override
+	{
+		return "Log";
+	}
+
+	/**
+	  * Appends the value to the list
+	  * and performs it locally
+	 **/
+	bool add(int value, AnswerPackage *answer=nullptr)
+	{
+		Package p;
+		p<<value;
+		return sendPackageAndPerform(p, answer);
+	}
+
+	/**
+	  * Returns a copy of the list
+	 **/
+	vector<int> getValues()
+	{
+		lock_guard<mutex> lock(m);
+		return values;
+	}
+
+	/**
+	  * Ignores the packages with an id
+	  * in the range [from, to)
+	 **/
+	void drop(unsigned long long from, unsigned long long to)
+	{
+		dropFrom = from;
+		dropTo = to;
+	}
+
+	virtual bool perform(const Address&, const Package &message, Package &answer, Package&) override
+	{
+		int value;
+		if(!(message>>value))return false;
+		if(isReplaying())++replayed;
+		answer<<value;
+
+		lock_guard<mutex> lock(m);
+		values.push_back(value);
+		return true;
+	}
+
+	virtual void getRebuildPackage(Package &out) const override
+	{
+		out<<(unsigned long long)values.size();
+		for(int value : values)out<<value;
+	}
+
+	virtual void rebuild(const Package &in, const Address&) override
+	{
+		++rebuilds;
+
+		lock_guard<mutex> lock(m);
+		values.clear();
+		unsigned long long size = 0;
+		in>>size;
+		for(unsigned long long i = 0; i < size; ++i)
+		{
+			int value;
+			in>>value;
+			values.push_back(value);
+		}
+	}
+
+	virtual bool received(const Address &ip, const Package &message, Package &answer, Package &to_send) override
+	{
+		Package copy(message);
+		char type = 0;
+		char operation = 0;
+		unsigned long long id;
+		copy>>type;
+		if(type == 'o' && copy.readInteger(id) && id >= dropFrom && id < dropTo)return true;
+		if(type == 'm')copy>>operation;
+		if(type == 'b')++batches;
+
+		const bool success = ClusterObjectSerialized::received(ip, message, answer, to_send);
+
+		//The last byte of the answer to a
+		//catch-up request is changed
+		if(corrupt && operation == 'r' && !answer.empty())
+		{
+			vector<char> data(answer.getData(), answer.getData() + answer.getLength());
+			data.back() ^= 1;
+			const Package::Format format = answer.getFormat();
+			answer = Package(data);
+			answer.setFormat(format);
+		}
+
+		return success;
+	}
+
+	mutex m;
+	vector<int> values;
+	atomic<int> rebuilds;
+	atomic<int> replayed;
+	atomic<int> batches;
+	atomic<unsigned long long> dropFrom;
+	atomic<unsigned long long> dropTo;
+	atomic<bool> corrupt;
+};
+
+/**
+  * A member of the simulated network which
+  * waits 2 seconds for every answer
+ **/
+struct Node
+{
+	Node(SimulatedNetwork &net, const string &name) :
+		protocol(net, name, 2),
+		network(protocol),
+		log(&network)
+	{}
+
+	Node(const Node &n) = delete;
+	Node& operator=(const Node &n) = delete;
+
+	Simulated protocol;
+	p2p network;
+	Log log;
+};
+
+/**
+  * Starts the given amount of Nodes and waits
+  * until all of them know each other
+ **/
+static vector<unique_ptr<Node> > startNodes(SimulatedNetwork &net, unsigned int count)
+{
+	vector<unique_ptr<Node> > nodes;
+	for(unsigned int i = 1; i <= count; ++i)nodes.emplace_back(new Node(net, "node" + to_string(i)));
+
+	CHECK(waitFor([&nodes, count]()
+	{
+		for(const unique_ptr<Node> &node : nodes)
+		{
+			if(node->network.getMembersCount() < count - 1)return false;
+		}
+		return true;
+	}, 30));
+
+	return nodes;
+}
+
+/**
+  * A member which missed many packages fetches them
+  * with one range request instead of rebuilding
+ **/
+static void testCatchUp()
+{
+	SimulatedNetwork net(1);
+	net.setDefaultLink(SimulatedLink(200, 0, 0));
+	vector<unique_ptr<Node> > nodes = startNodes(net, 3);
+
+	for(int i = 0; i < 10; ++i)CHECK(nodes[0]->log.add(i));
+	CHECK(waitFor([&nodes]{ return nodes[2]->log.getValues().size() == 10; }, 30));
+	const int rebuilds = nodes[2]->log.rebuilds;
+
+	//The third member misses 500 packages
+	nodes[2]->log.drop(10, 510);
+	for(int i = 10; i < 510; ++i)CHECK(nodes[0]->log.add(i));
+	CHECK(nodes[2]->log.getValues().size() == 10);
+
+	//The next package reveals the gap
+	CHECK(nodes[0]->log.add(510));
+	CHECK(waitFor([&nodes]{ return nodes[2]->log.getValues().size() == 511; }, 150));
+	CHECK(nodes[2]->log.getValues() == nodes[0]->log.getValues());
+	CHECK(nodes[2]->log.rebuilds == rebuilds);
+
+	//Every member continues with the same packages
+	CHECK(nodes[0]->log.add(511));
+	CHECK(waitFor([&nodes]
+	{
+		const vector<int> values = nodes[0]->log.getValues();
+		return nodes[1]->log.getValues() == values && nodes[2]->log.getValues() == values;
+	}, 30));
+}
+
+/**
+  * A member which receives corrupted packages
+  * while it catches up rebuilds instead
+ **/
+static void testCorruptedCatchUp()
+{
+	SimulatedNetwork net(1);
+	net.setDefaultLink(SimulatedLink(200, 0, 0));
+	vector<unique_ptr<Node> > nodes = startNodes(net, 3);
+
+	for(int i = 0; i < 10; ++i)CHECK(nodes[0]->log.add(i));
+	CHECK(waitFor([&nodes]{ return nodes[2]->log.getValues().size() == 10; }, 30));
+	const int rebuilds = nodes[2]->log.rebuilds;
+
+	nodes[0]->log.corrupt = true;
+	nodes[2]->log.drop(10, 20);
+	for(int i = 10; i < 21; ++i)CHECK(nodes[0]->log.add(i));
+
+	CHECK(waitFor([&nodes]{ return nodes[2]->log.getValues().size() == 21; }, 150));
+	CHECK(nodes[2]->log.getValues() == nodes[0]->log.getValues());
+	CHECK(nodes[2]->log.rebuilds == rebuilds + 1);
+}
+
+/**
+  * A member which restarts restores the packages
+  * from its WriteAheadLog and only fetches those
+  * which it missed while it was offline
+ **/
+static void testRestore()
+{
+	const string fileName = "bin/test/serializedtest.log";
+	remove(fileName.c_str());
+	remove((fileName + ".snapshot").c_str());
+
+	SimulatedNetwork net(1);
+	net.setDefaultLink(SimulatedLink(200, 0, 0));
+	vector<unique_ptr<Node> > nodes = startNodes(net, 3);
+	CHECK(nodes[2]->log.openWriteAheadLog(fileName, 100));
+
+	for(int i = 0; i < 250; ++i)CHECK(nodes[0]->log.add(i));
+	CHECK(waitFor([&nodes]{ return nodes[2]->log.getValues().size() == 250; }, 30));
+	const vector<int> before = nodes[2]->log.getValues();
+
+	//The third member goes offline
+	nodes[2].reset();
+	CHECK(waitFor([&nodes]{ return nodes[0]->network.getMembersCount() == 1; }, 60));
+	for(int i = 250; i < 350; ++i)CHECK(nodes[0]->log.add(i));
+
+	//The snapshot and the packages after it are restored
+	nodes[2].reset(new Node(net, "node3"));
+	CHECK(nodes[2]->log.openWriteAheadLog(fileName, 100));
+	CHECK(nodes[2]->log.getValues() == before);
+	CHECK(nodes[2]->log.replayed > 0);
+	CHECK(nodes[2]->log.rebuilds == 1);
+
+	//The missed packages are fetched from the master
+	CHECK(waitFor([&nodes]{ return nodes[2]->log.getValues().size() == 350; }, 60));
+	CHECK(nodes[2]->log.getValues() == nodes[0]->log.getValues());
+	CHECK(nodes[2]->log.rebuilds == 1);
+
+	remove(fileName.c_str());
+	remove((fileName + ".snapshot").c_str());
+}
+
+/**
+  * Packages which are sent concurrently are sent
+  * in batches and performed in the same order by
+  * every member. Every member answers each of them
+ **/
+static void testBatching()
+{
+	SimulatedNetwork net(1);
+	net.setDefaultLink(SimulatedLink(1000, 0, 0));
+	vector<unique_ptr<Node> > nodes = startNodes(net, 3);
+
+	atomic<int> answered(0);
+	vector<thread> threads;
+	for(int t = 0; t < 8; ++t)
+	{
+		threads.emplace_back([&nodes, &answered, t]()
+		{
+			for(int i = t * 50; i < (t + 1) * 50; ++i)
+			{
+				AnswerPackage answer;
+				CHECK(nodes[0]->log.add(i, &answer));
+
+				int count = 0;
+				for(auto it = answer.cbegin(); it != answer.cend(); ++it)
+				{
+					int value;
+					if(it->second>>value && value == i)++count;
+				}
+				if(count == 2)++answered;
+			}
+		});
+	}
+	for(thread &t : threads)t.join();
+
+	CHECK(answered == 400);
+	CHECK(nodes[1]->log.batches > 0);
+	CHECK(waitFor([&nodes]
+	{
+		return nodes[1]->log.getValues().size() == 400 && nodes[2]->log.getValues().size() == 400;
+	}, 30));
+
+	vector<int> values = nodes[0]->log.getValues();
+	CHECK(nodes[1]->log.getValues() == values);
+	CHECK(nodes[2]->log.getValues() == values);
+
+	//Every package is performed once
+	sort(values.begin(), values.end());
+	for(std::size_t i = 0; i < values.size(); ++i)CHECK(values[i] == int(i));
+}
+
+int main()
+{
+	testCatchUp();
+	testCorruptedCatchUp();
+	testRestore();
+	testBatching();
+	return testResult("serializedtest");
+}
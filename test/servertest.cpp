@@ -0,0 +1,177 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#include "test.hpp"
+#include <cluster/client.hpp>
+#include <cluster/connectionpool.hpp>
+#include <cluster/server.hpp>
+#include <cluster/simulated/simulated.hpp>
+#include <cluster/simulated/simulatedaddress.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+using namespace cluster;
+
+/**
+  * Blocks the handlers of the Server until it is opened
+ **/
+struct Gate
+{
+	Gate() :
+		m(),
+		cv(),
+		open(false),
+		arrived(0),
+		order()
+	{}
+
+	Gate(const Gate &g) = delete;
+	Gate& operator=(const Gate &g) = delete;
+
+	/**
+	  * Waits until the Gate is open and remembers
+	  * the order in which the values pass
+	 **/
+	void pass(int value)
+	{
+		unique_lock<mutex> lock(m);
+		++arrived;
+		cv.wait(lock, [this]{ return open; });
+		order.push_back(value);
+	}
+
+	/**
+	  * Returns the amount of handlers
+	  * which wait or passed
+	 **/
+	std::size_t waiting()
+	{
+		lock_guard<mutex> lock(m);
+		return arrived;
+	}
+
+	/**
+	  * Lets all waiting handlers pass
+	 **/
+	void openGate()
+	{
+		m.lock();
+		open = true;
+		m.unlock();
+		cv.notify_all();
+	}
+
+	mutex m;
+	condition_variable cv;
+	bool open;
+	std::size_t arrived;
+	vector<int> order;
+};
+
+/**
+  * Sends the given value and returns the
+  * future which tells whether it was answered
+ **/
+static future<bool> sendValue(const Client &client, int value, Package *answer)
+{
+	shared_ptr<promise<bool> > sent(new promise<bool>());
+	Package request;
+	request<<value;
+	client.sendAsync(request, answer, [sent](bool success){ sent->set_value(success); });
+	return sent->get_future();
+}
+
+/**
+  * A full queue rejects requests at once with a busy
+  * answer. The sender retries and gives up, while control
+  * requests are still queued and are handled first
+ **/
+static void testLoadShedding()
+{
+	SimulatedNetwork network(1);
+	Simulated serverProtocol(network, "server");
+	Simulated clientProtocol(network, "client");
+
+	Gate gate;
+	Server server(serverProtocol);
+	server.setQueueLimits(4, 4);
+	server.setPriorityCallback([](const Package &data)
+	{
+		int value = 0;
+		return (data>>value) && value >= 1000;
+	});
+	server.setChannelCallback([&gate](const Address&, const Package &data, Package &answer, Package&)
+	{
+		int value = 0;
+		data>>value;
+		gate.pass(value);
+		answer<<value;
+	});
+
+	ConnectionPool pool(clientProtocol);
+	pool.setMultiplexing(true);
+	Client client(SimulatedAddress("server"), clientProtocol, &pool);
+
+	//All handlers are blocked
+	vector<Package> answers(30);
+	vector<future<bool> > sent;
+	for(int i = 0; i < 20; ++i)
+	{
+		sent.push_back(sendValue(client, i, &answers[(std::size_t)i]));
+		CHECK(waitFor([&gate,i]{ return gate.waiting() == std::size_t(i + 1); }, 10));
+	}
+
+	//The queue takes four more requests
+	for(int i = 20; i < 24; ++i)
+	{
+		sent.push_back(sendValue(client, i, &answers[(std::size_t)i]));
+		CHECK(waitFor([&server,i]{ return server.getStatistics().queued == std::size_t(i - 19); }, 10));
+	}
+
+	//The next one is rejected until the sender gives up
+	const unsigned long long rejectedBefore = server.getStatistics().rejected;
+	const auto start = chrono::steady_clock::now();
+	future<bool> rejected = sendValue(client, 24, &answers[24]);
+	CHECK(!rejected.get());
+	CHECK(chrono::steady_clock::now() - start < chrono::seconds(5));
+	CHECK(server.getStatistics().rejected - rejectedBefore == Client::busyRetries + 1);
+
+	//Control requests are queued nevertheless
+	future<bool> control = sendValue(client, 1000, &answers[25]);
+	CHECK(waitFor([&server]{ return server.getStatistics().queued == 5; }, 10));
+
+	gate.openGate();
+	for(future<bool> &f : sent)CHECK(f.get());
+	CHECK(control.get());
+	for(int i = 0; i < 24; ++i)
+	{
+		int value = -1;
+		CHECK(answers[(std::size_t)i]>>value && value == i);
+	}
+
+	//The control request was handled before the queued ones
+	gate.m.lock();
+	const vector<int> order = gate.order;
+	gate.m.unlock();
+	CHECK(order.size() == 25);
+	auto controlPosition = find(order.begin(), order.end(), 1000);
+	auto queuedPosition = find(order.begin(), order.end(), 20);
+	CHECK(controlPosition != order.end() && queuedPosition != order.end());
+	CHECK(controlPosition < queuedPosition);
+	CHECK(server.getStatistics().maxQueued == 5);
+}
+
+int main()
+{
+	testLoadShedding();
+	return testResult("servertest");
+}
@@ -0,0 +1,63 @@
+/**
+  *
+  * (C) Thomas Sparber
+  * thomas@sparber.eu
+  * 2013-2015
+  *
+ **/
+
+#ifndef TEST_HPP
+#define TEST_HPP
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+/**
+  * The amount of checks of the
+  * current test which failed
+ **/
+static unsigned int failedChecks = 0;
+
+/**
+  * Checks the given condition and prints the
+  * condition and its position if it doesn't hold
+ **/
+#define CHECK(condition) \
+	do { \
+		if(!(condition)) \
+		{ \
+			std::cout<<__FILE__<<":"<<__LINE__<<": "<<#condition<<" failed"<<std::endl; \
+			++failedChecks; \
+		} \
+	} while(false)
+
+/**
+  * Waits at most the given amount of seconds
+  * until the condition holds. Returns whether
+  * the condition holds
+ **/
+inline bool waitFor(std::function<bool()> condition, unsigned int seconds)
+{
+	const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+	while(!condition())
+	{
+		if(std::chrono::steady_clock::now() > end)return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return true;
+}
+
+/**
+  * Prints the result of the test and returns
+  * the exit code of the test program
+ **/
+inline int testResult(const char *name)
+{
+	if(failedChecks == 0)std::cout<<name<<": passed"<<std::endl;
+	else std::cout<<name<<": "<<failedChecks<<" check(s) failed"<<std::endl;
+	return failedChecks == 0 ? 0 : 1;
+}
+
+#endif //TEST_HPP